@@ -0,0 +1,142 @@
+/*
+ * cellwalker.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tilelayer.h"
+
+#include <QPoint>
+
+namespace Tiled {
+
+/**
+ * Walks over the cells of a tile layer along a straight line, moving by a
+ * fixed step each time. This is how the map renderers visit the cells in a
+ * row of tiles, which depending on the orientation is a horizontal,
+ * diagonal or staggered line.
+ *
+ * Compared to calling TileLayer::cellAt() for each cell, the chunk is only
+ * looked up when the walker enters it. In addition, emptyStepsAhead() allows
+ * skipping over absent chunks and over runs of empty cells within a chunk,
+ * which makes drawing sparse maps about as cheap as drawing dense ones.
+ *
+ * Positions are in local coordinates of the layer.
+ */
+class CellWalker
+{
+public:
+    CellWalker(const TileLayer &layer, QPoint start, QPoint step);
+
+    QPoint position() const { return mPosition; }
+    const Cell &cell() const;
+
+    int emptyStepsAhead() const;
+
+    void advance(int steps = 1);
+
+private:
+    void enterChunk();
+
+    const TileLayer &mLayer;
+    QPoint mPosition;
+    const QPoint mStep;
+    QPoint mChunkOrigin;
+    const Chunk *mChunk;
+};
+
+inline CellWalker::CellWalker(const TileLayer &layer, QPoint start, QPoint step)
+    : mLayer(layer)
+    , mPosition(start)
+    , mStep(step)
+{
+    enterChunk();
+}
+
+/**
+ * Returns the cell at the current position.
+ */
+inline const Cell &CellWalker::cell() const
+{
+    if (!mChunk)
+        return Cell::empty;
+    return mChunk->cellAt(mPosition.x() & CHUNK_MASK, mPosition.y() & CHUNK_MASK);
+}
+
+/**
+ * Returns the number of steps that can be taken from the current position
+ * while only passing over empty cells, without leaving the current chunk.
+ * Returns 0 when the current cell is not empty.
+ *
+ * The cells are checked using the occupancy bitmap of the chunk, so runs of
+ * empty cells are skipped without looking at the cells themselves. When the
+ * current chunk is absent, this is the number of steps needed to leave it.
+ */
+inline int CellWalker::emptyStepsAhead() const
+{
+    int localX = mPosition.x() - mChunkOrigin.x();
+    int localY = mPosition.y() - mChunkOrigin.y();
+    int steps = 0;
+
+    while (localX >= 0 && localX < CHUNK_SIZE && localY >= 0 && localY < CHUNK_SIZE) {
+        if (mChunk && (mChunk->occupiedCells(localY) & (1 << localX)))
+            break;
+
+        ++steps;
+
+        if (mStep.isNull())
+            break;
+
+        localX += mStep.x();
+        localY += mStep.y();
+    }
+
+    return steps;
+}
+
+/**
+ * Moves the given number of \a steps along the line.
+ */
+inline void CellWalker::advance(int steps)
+{
+    mPosition += mStep * steps;
+
+    const int localX = mPosition.x() - mChunkOrigin.x();
+    const int localY = mPosition.y() - mChunkOrigin.y();
+
+    if (localX < 0 || localX >= CHUNK_SIZE || localY < 0 || localY >= CHUNK_SIZE)
+        enterChunk();
+}
+
+inline void CellWalker::enterChunk()
+{
+    mChunkOrigin = QPoint(mPosition.x() & ~CHUNK_MASK,
+                          mPosition.y() & ~CHUNK_MASK);
+    mChunk = mLayer.findChunk(mPosition.x(), mPosition.y());
+}
+
+} // namespace Tiled
@@ -0,0 +1,130 @@
+/*
+ * chunkimagecache.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "chunkimagecache.h"
+
+#include "tile.h"
+
+namespace Tiled {
+
+// Limits the memory used by the cache, which otherwise keeps growing as
+// layers are deleted or maps are closed
+static const int MaxEntries = 1 << 16;
+
+/**
+ * Returns the image of the given \a chunk of \a layer, which has its
+ * top-left cell at \a chunkOrigin.
+ */
+const QImage &ChunkImageCache::image(const TileLayer *layer,
+                                     QPoint chunkOrigin,
+                                     const Chunk &chunk)
+{
+    const auto key = qMakePair(layer->id(), chunkOrigin);
+
+    if (mEntries.size() >= MaxEntries && !mEntries.contains(key))
+        mEntries.clear();
+
+    Entry &entry = mEntries[key];
+    if (!entry.image.isNull() && entry.revision == chunk.revision())
+        return entry.image;
+
+    entry.revision = chunk.revision();
+    entry.image = QImage(CHUNK_SIZE, CHUNK_SIZE, QImage::Format_ARGB32_Premultiplied);
+
+    for (int y = 0; y < CHUNK_SIZE; ++y) {
+        QRgb *line = reinterpret_cast<QRgb*>(entry.image.scanLine(y));
+        for (int x = 0; x < CHUNK_SIZE; ++x) {
+            const Cell &cell = chunk.cellAt(x, y);
+            line[x] = cell.isEmpty() ? 0 : averageColor(cell.tile());
+        }
+    }
+
+    return entry.image;
+}
+
+/**
+ * Discards all cached images. Needs to be called when tile images changed.
+ */
+void ChunkImageCache::clear()
+{
+    mEntries.clear();
+    mAverageColors.clear();
+    mAverageImageColors.clear();
+}
+
+/**
+ * Returns the premultiplied average color of the image of \a tile.
+ */
+QRgb ChunkImageCache::averageColor(const Tile *tile)
+{
+    if (!tile)
+        return 0;
+
+    // Off the GUI thread, tile images that were never shown are still
+    // pending, since they can't be converted to a pixmap there
+    const QImage pendingImage = tile->pendingImage();
+    const bool pending = !pendingImage.isNull();
+    if (!pending && tile->image().isNull())
+        return 0;
+
+    // Images and pixmaps are numbered separately, hence the separate caches
+    auto &averageColors = pending ? mAverageImageColors : mAverageColors;
+    const qint64 key = pending ? pendingImage.cacheKey() : tile->image().cacheKey();
+
+    auto it = averageColors.constFind(key);
+    if (it != averageColors.constEnd())
+        return it.value();
+
+    if (averageColors.size() >= MaxEntries)
+        averageColors.clear();
+
+    const QImage image = (pending ? pendingImage : tile->image().toImage())
+            .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    quint64 red = 0, green = 0, blue = 0, alpha = 0;
+
+    for (int y = 0; y < image.height(); ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            red += qRed(line[x]);
+            green += qGreen(line[x]);
+            blue += qBlue(line[x]);
+            alpha += qAlpha(line[x]);
+        }
+    }
+
+    const quint64 count = quint64(image.width()) * image.height();
+    const QRgb color = qRgba(int(red / count),
+                             int(green / count),
+                             int(blue / count),
+                             int(alpha / count));
+
+    averageColors.insert(key, color);
+    return color;
+}
+
+} // namespace Tiled
@@ -0,0 +1,74 @@
+/*
+ * chunkimagecache.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tilelayer.h"
+
+#include <QHash>
+#include <QImage>
+#include <QPair>
+
+namespace Tiled {
+
+class Tile;
+
+/**
+ * Caches down-sampled images of the chunks of tile layers, with one pixel
+ * for each tile. Used by the renderers to draw tile layers when zoomed out
+ * so far that the individual tiles can no longer be distinguished.
+ *
+ * Each pixel has the average color of the tile. The images are stored by
+ * layer ID and chunk position, along with the revision of the chunk they
+ * were generated from. An image is regenerated when the revision of its
+ * chunk has changed.
+ *
+ * The cache is not thread-safe.
+ */
+class ChunkImageCache
+{
+public:
+    const QImage &image(const TileLayer *layer, QPoint chunkOrigin, const Chunk &chunk);
+
+    void clear();
+
+private:
+    QRgb averageColor(const Tile *tile);
+
+    struct Entry
+    {
+        quint64 revision = 0;
+        QImage image;
+    };
+
+    QHash<QPair<int, QPoint>, Entry> mEntries;
+    QHash<qint64, QRgb> mAverageColors;
+    QHash<qint64, QRgb> mAverageImageColors;
+};
+
+} // namespace Tiled
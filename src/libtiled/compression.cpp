@@ -231,3 +231,173 @@ QByteArray Tiled::compress(const QByteArray &data,
         return QByteArray();
     }
 }
+
+
+struct Decompressor::Stream
+{
+    CompressionMethod method;
+    OutputFunction output;
+    bool initialized = false;
+    bool failed = false;
+    bool atEnd = false;
+
+    z_stream zlib;
+#ifdef TILED_ZSTD_SUPPORT
+    ZSTD_DStream *zstd = nullptr;
+#endif
+
+    char buffer[16384];
+};
+
+/**
+ * Creates a decompressor for the given compression \a method, which passes
+ * the decompressed data to \a output. When the output function returns
+ * false, decompressing is aborted.
+ */
+Decompressor::Decompressor(CompressionMethod method, OutputFunction output)
+    : mStream(new Stream)
+{
+    mStream->method = method;
+    mStream->output = std::move(output);
+
+    if (method == Zlib || method == Gzip) {
+        z_stream &strm = mStream->zlib;
+
+        strm.zalloc = Z_NULL;
+        strm.zfree = Z_NULL;
+        strm.opaque = Z_NULL;
+        strm.next_in = Z_NULL;
+        strm.avail_in = 0;
+
+        const int ret = inflateInit2(&strm, 15 + 32);
+        if (ret != Z_OK)
+            logZlibError(ret);
+
+        mStream->initialized = ret == Z_OK;
+#ifdef TILED_ZSTD_SUPPORT
+    } else if (method == Zstandard) {
+        mStream->zstd = ZSTD_createDStream();
+        mStream->initialized = mStream->zstd && !ZSTD_isError(ZSTD_initDStream(mStream->zstd));
+        if (!mStream->initialized)
+            qDebug() << "error initializing decompression stream";
+#endif
+    } else {
+        qDebug() << "compression not supported:" << method;
+    }
+
+    mStream->failed = !mStream->initialized;
+}
+
+Decompressor::~Decompressor()
+{
+    if (mStream->method == Zlib || mStream->method == Gzip) {
+        if (mStream->initialized)
+            inflateEnd(&mStream->zlib);
+#ifdef TILED_ZSTD_SUPPORT
+    } else if (mStream->method == Zstandard) {
+        ZSTD_freeDStream(mStream->zstd);
+#endif
+    }
+}
+
+/**
+ * Decompresses the next part of the compressed data. Returns false when the
+ * data is corrupt, when there is data beyond the end of the compressed
+ * stream or when the output function aborted.
+ */
+bool Decompressor::write(const char *data, int size)
+{
+    Stream &s = *mStream;
+
+    if (s.failed)
+        return false;
+    if (size == 0)
+        return true;
+
+    if (s.method == Zlib || s.method == Gzip) {
+        z_stream &strm = s.zlib;
+
+        if (s.atEnd) {
+            logZlibError(Z_DATA_ERROR);
+            s.failed = true;
+            return false;
+        }
+
+        strm.next_in = (Bytef *) data;
+        strm.avail_in = size;
+
+        do {
+            strm.next_out = (Bytef *) s.buffer;
+            strm.avail_out = sizeof(s.buffer);
+
+            int ret = inflate(&strm, Z_NO_FLUSH);
+            Q_ASSERT(ret != Z_STREAM_ERROR);
+
+            switch (ret) {
+                case Z_NEED_DICT:
+                    ret = Z_DATA_ERROR;
+                    Q_FALLTHROUGH();
+                case Z_DATA_ERROR:
+                case Z_MEM_ERROR:
+                    logZlibError(ret);
+                    s.failed = true;
+                    return false;
+            }
+
+            const int outLength = sizeof(s.buffer) - strm.avail_out;
+            if (outLength > 0 && !s.output(s.buffer, outLength)) {
+                s.failed = true;
+                return false;
+            }
+
+            if (ret == Z_STREAM_END) {
+                s.atEnd = true;
+
+                if (strm.avail_in != 0) {
+                    logZlibError(Z_DATA_ERROR);
+                    s.failed = true;
+                    return false;
+                }
+            }
+        } while (strm.avail_in > 0 || strm.avail_out == 0);
+
+        return true;
+#ifdef TILED_ZSTD_SUPPORT
+    } else if (s.method == Zstandard) {
+        ZSTD_inBuffer in = { data, static_cast<size_t>(size), 0 };
+        ZSTD_outBuffer out;
+
+        do {
+            out = { s.buffer, sizeof(s.buffer), 0 };
+
+            const size_t ret = ZSTD_decompressStream(s.zstd, &out, &in);
+            if (ZSTD_isError(ret)) {
+                qDebug() << "error decoding:" << ZSTD_getErrorName(ret);
+                s.failed = true;
+                return false;
+            }
+
+            if (out.pos > 0 && !s.output(s.buffer, static_cast<int>(out.pos))) {
+                s.failed = true;
+                return false;
+            }
+
+            // A return value of 0 means a frame was completed, though more
+            // frames may follow
+            s.atEnd = ret == 0;
+        } while (in.pos < in.size || out.pos == out.size);
+
+        return true;
+#endif
+    }
+
+    return false;
+}
+
+/**
+ * Returns whether the end of the compressed data has been reached.
+ */
+bool Decompressor::atEnd() const
+{
+    return mStream->atEnd;
+}
@@ -30,6 +30,9 @@
 
 #include "tiled_global.h"
 
+#include <functional>
+#include <memory>
+
 class QByteArray;
 
 namespace Tiled {
@@ -69,4 +72,25 @@ QByteArray TILEDSHARED_EXPORT compress(const QByteArray &data,
                                        CompressionMethod method,
                                        int compressionLevel = -1);
 
+/**
+ * Decompresses zlib, gzip or Zstandard compressed data that is provided in
+ * parts. The decompressed data is passed on in parts as well, so that only a
+ * small buffer is needed regardless of the size of the data.
+ */
+class TILEDSHARED_EXPORT Decompressor
+{
+public:
+    using OutputFunction = std::function<bool (const char *data, int size)>;
+
+    Decompressor(CompressionMethod method, OutputFunction output);
+    ~Decompressor();
+
+    bool write(const char *data, int size);
+    bool atEnd() const;
+
+private:
+    struct Stream;
+    std::unique_ptr<Stream> mStream;
+};
+
 } // namespace Tiled
@@ -29,17 +29,52 @@
 #include "filesystemwatcher.h"
 
 #include <QDebug>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QFileSystemWatcher>
+#include <QSocketNotifier>
 #include <QStringList>
 
+#ifdef Q_OS_LINUX
+#define TILED_USE_INOTIFY
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
 namespace Tiled {
 
+// The delay before reporting changes, which is restarted by each change
+static const int ChangedPathsDelay = 500;
+
+// The maximum time changes are held back while more changes keep coming in
+static const int MaximumChangedPathsDelay = 2000;
+
+#ifdef TILED_USE_INOTIFY
+static const uint32_t InotifyMask = IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE |
+        IN_DELETE | IN_DELETE_SELF | IN_MODIFY | IN_MOVE_SELF | IN_MOVED_FROM |
+        IN_MOVED_TO | IN_ONLYDIR;
+
+// The events that change the contents of a watched directory
+static const uint32_t DirectoryEvents = IN_ATTRIB | IN_CREATE | IN_DELETE |
+        IN_DELETE_SELF | IN_MOVE_SELF | IN_MOVED_FROM | IN_MOVED_TO;
+#endif
+
+static QString joinPath(const QString &directory, const QString &name)
+{
+    if (directory.endsWith(QLatin1Char('/')))
+        return directory + name;
+    return directory + QLatin1Char('/') + name;
+}
+
 FileSystemWatcher::FileSystemWatcher(QObject *parent) :
     QObject(parent),
-    mWatcher(new QFileSystemWatcher(this))
+    mWatcher(new QFileSystemWatcher(this)),
+    mInotifyFd(-1),
+    mInotifyNotifier(nullptr)
 {
-    mChangedPathsTimer.setInterval(500);
+    mChangedPathsTimer.setInterval(ChangedPathsDelay);
     mChangedPathsTimer.setSingleShot(true);
 
     connect(mWatcher, &QFileSystemWatcher::fileChanged,
@@ -49,27 +84,53 @@ FileSystemWatcher::FileSystemWatcher(QObject *parent) :
 
     connect(&mChangedPathsTimer, &QTimer::timeout,
             this, &FileSystemWatcher::pathsChangedTimeout);
+
+#ifdef TILED_USE_INOTIFY
+    mInotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (mInotifyFd != -1) {
+        mInotifyNotifier = new QSocketNotifier(mInotifyFd, QSocketNotifier::Read, this);
+
+        // Using the string based syntax, since the signal is overloaded
+        // since Qt 5.15
+        connect(mInotifyNotifier, SIGNAL(activated(int)),
+                this, SLOT(readInotifyEvents()));
+    }
+#endif
+}
+
+FileSystemWatcher::~FileSystemWatcher()
+{
+#ifdef TILED_USE_INOTIFY
+    if (mInotifyFd != -1) {
+        delete mInotifyNotifier;
+        ::close(mInotifyFd);
+    }
+#endif
 }
 
 void FileSystemWatcher::addPath(const QString &path)
 {
-    // Just silently ignore the request when the file doesn't exist
-    if (!QFile::exists(path))
+    QHash<QString, int>::iterator entry = mWatchCount.find(path);
+    if (entry != mWatchCount.end()) {
+        // Path is already being watched, increment watch count
+        ++entry.value();
         return;
+    }
+
+    if (!watchDirectoryOf(path)) {
+        // Just silently ignore the request when the file doesn't exist
+        if (!QFile::exists(path))
+            return;
 
-    QMap<QString, int>::iterator entry = mWatchCount.find(path);
-    if (entry == mWatchCount.end()) {
         mWatcher->addPath(path);
-        mWatchCount.insert(path, 1);
-    } else {
-        // Path is already being watched, increment watch count
-        ++entry.value();
     }
+
+    mWatchCount.insert(path, 1);
 }
 
 void FileSystemWatcher::removePath(const QString &path)
 {
-    QMap<QString, int>::iterator entry = mWatchCount.find(path);
+    QHash<QString, int>::iterator entry = mWatchCount.find(path);
     if (entry == mWatchCount.end()) {
         if (QFile::exists(path))
             qWarning() << "FileSystemWatcher: Path was never added:" << path;
@@ -81,7 +142,11 @@ void FileSystemWatcher::removePath(const QString &path)
 
     if (entry.value() == 0) {
         mWatchCount.erase(entry);
-        mWatcher->removePath(path);
+
+        if (mDirectoryOfPath.contains(path))
+            unwatchDirectoryOf(path);
+        else
+            mWatcher->removePath(path);
     }
 }
 
@@ -95,43 +160,231 @@ void FileSystemWatcher::clear()
     if (!directories.isEmpty())
         mWatcher->removePaths(directories);
 
+#ifdef TILED_USE_INOTIFY
+    for (const DirectoryWatch &watch : mDirectoryWatches)
+        if (watch.descriptor != -1)
+            inotify_rm_watch(mInotifyFd, watch.descriptor);
+#endif
+
+    mDirectoryOfPath.clear();
+    mDirectoryWatches.clear();
+    mDirectoryForDescriptor.clear();
     mWatchCount.clear();
 }
 
 void FileSystemWatcher::onFileChanged(const QString &path)
 {
-    mChangedPaths.insert(path);
-    mChangedPathsTimer.start();
+    queueChangedPath(path);
 
     emit fileChanged(path);
 }
 
 void FileSystemWatcher::onDirectoryChanged(const QString &path)
 {
-    mChangedPaths.insert(path);
-    mChangedPathsTimer.start();
+    queueChangedPath(path);
 
     emit directoryChanged(path);
 }
 
+void FileSystemWatcher::queueChangedPath(const QString &path)
+{
+    if (mChangedPaths.isEmpty())
+        mChangedPathsAge.start();
+
+    mChangedPaths.insert(path);
+
+    // Wait for more changes, but don't keep postponing the notification when
+    // changes keep coming in
+    if (!mChangedPathsTimer.isActive() || mChangedPathsAge.elapsed() < MaximumChangedPathsDelay)
+        mChangedPathsTimer.start();
+}
+
 void FileSystemWatcher::pathsChangedTimeout()
 {
     const auto changedPaths = mChangedPaths.values();
 
-    // If the file was replaced, the watcher is automatically removed and needs
-    // to be re-added to keep watching it for changes. This happens commonly
-    // with applications that do atomic saving.
+    QSet<QString> watchedFiles;
+    const QStringList files = mWatcher->files();
+    for (const QString &file : files)
+        watchedFiles.insert(file);
+
     for (const QString &path : changedPaths) {
-        if (mWatchCount.contains(path) && !mWatcher->files().contains(path)) {
-            if (QFile::exists(path))
-                mWatcher->addPath(path);
+        if (!mWatchCount.contains(path))
+            continue;
+
+        // When the watched directory was removed and re-created, its watch
+        // needs to be restored
+        const auto directory = mDirectoryOfPath.constFind(path);
+        if (directory != mDirectoryOfPath.constEnd()) {
+            rewatchDirectory(directory.value());
+            continue;
         }
-    }
 
+        // If the file was replaced, the watcher is automatically removed and
+        // needs to be re-added to keep watching it for changes. This happens
+        // commonly with applications that do atomic saving.
+        if (!watchedFiles.contains(path) && QFile::exists(path))
+            mWatcher->addPath(path);
+    }
 
     emit pathsChanged(changedPaths);
 
     mChangedPaths.clear();
 }
 
+/**
+ * Watches the directory of the given \a path using inotify, or the path
+ * itself when it refers to a directory. Returns whether this succeeded.
+ */
+bool FileSystemWatcher::watchDirectoryOf(const QString &path)
+{
+#ifdef TILED_USE_INOTIFY
+    if (mInotifyFd == -1)
+        return false;
+
+    // Changes are reported by file name, so the path needs to be in a form
+    // that can be matched with the name of the directory
+    if (!QDir::isAbsolutePath(path) || QDir::cleanPath(path) != path)
+        return false;
+
+    const QFileInfo fileInfo(path);
+    const QString directory = fileInfo.isDir() ? path : fileInfo.absolutePath();
+
+    auto it = mDirectoryWatches.find(directory);
+    if (it == mDirectoryWatches.end()) {
+        const int descriptor = inotify_add_watch(mInotifyFd,
+                                                 QFile::encodeName(directory).constData(),
+                                                 InotifyMask);
+
+        // Fall back to QFileSystemWatcher when the directory doesn't exist or
+        // the limit on the number of watches was reached
+        if (descriptor == -1)
+            return false;
+
+        // The same directory may be reachable through different paths
+        if (mDirectoryForDescriptor.contains(descriptor))
+            return false;
+
+        mDirectoryForDescriptor.insert(descriptor, directory);
+        it = mDirectoryWatches.insert(directory, DirectoryWatch { descriptor, 0 });
+    }
+
+    ++it.value().count;
+    mDirectoryOfPath.insert(path, directory);
+    return true;
+#else
+    Q_UNUSED(path)
+    return false;
+#endif
+}
+
+void FileSystemWatcher::unwatchDirectoryOf(const QString &path)
+{
+    const QString directory = mDirectoryOfPath.take(path);
+
+    auto it = mDirectoryWatches.find(directory);
+    if (it == mDirectoryWatches.end())
+        return;
+
+    if (--it.value().count > 0)
+        return;
+
+#ifdef TILED_USE_INOTIFY
+    const int descriptor = it.value().descriptor;
+    if (descriptor != -1) {
+        mDirectoryForDescriptor.remove(descriptor);
+        inotify_rm_watch(mInotifyFd, descriptor);
+    }
+#endif
+
+    mDirectoryWatches.erase(it);
+}
+
+void FileSystemWatcher::rewatchDirectory(const QString &directory)
+{
+#ifdef TILED_USE_INOTIFY
+    auto it = mDirectoryWatches.find(directory);
+    if (it == mDirectoryWatches.end() || it.value().descriptor != -1)
+        return;
+
+    const int descriptor = inotify_add_watch(mInotifyFd,
+                                             QFile::encodeName(directory).constData(),
+                                             InotifyMask);
+    if (descriptor == -1 || mDirectoryForDescriptor.contains(descriptor))
+        return;
+
+    it.value().descriptor = descriptor;
+    mDirectoryForDescriptor.insert(descriptor, directory);
+#else
+    Q_UNUSED(directory)
+#endif
+}
+
+/**
+ * Reads all pending inotify events. The events are read in large blocks and
+ * only the ones affecting watched paths are reported.
+ */
+void FileSystemWatcher::readInotifyEvents()
+{
+#ifdef TILED_USE_INOTIFY
+    alignas(struct inotify_event) char buffer[16384];
+
+    for (;;) {
+        const ssize_t length = ::read(mInotifyFd, buffer, sizeof(buffer));
+        if (length == -1 && errno == EINTR)
+            continue;
+        if (length <= 0)
+            break;      // No more events available
+
+        const char *pointer = buffer;
+        while (pointer < buffer + length) {
+            const auto event = reinterpret_cast<const struct inotify_event *>(pointer);
+            pointer += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were lost, so report all paths as changed. A copy
+                // is used, since the paths may be changed in response.
+                const auto directoryOfPath = mDirectoryOfPath;
+                for (auto it = directoryOfPath.constBegin(); it != directoryOfPath.constEnd(); ++it) {
+                    if (it.key() == it.value())
+                        onDirectoryChanged(it.key());
+                    else
+                        onFileChanged(it.key());
+                }
+                continue;
+            }
+
+            const QString directory = mDirectoryForDescriptor.value(event->wd);
+            if (directory.isEmpty())
+                continue;
+
+            if (event->mask & IN_IGNORED) {
+                // The directory was removed or unmounted
+                mDirectoryForDescriptor.remove(event->wd);
+                auto it = mDirectoryWatches.find(directory);
+                if (it != mDirectoryWatches.end())
+                    it.value().descriptor = -1;
+                continue;
+            }
+
+            if ((event->mask & DirectoryEvents) && mDirectoryOfPath.value(directory) == directory)
+                onDirectoryChanged(directory);
+
+            if (event->len == 0)
+                continue;
+
+            const QString path = joinPath(directory, QFile::decodeName(event->name));
+            const auto it = mDirectoryOfPath.constFind(path);
+            if (it == mDirectoryOfPath.constEnd())
+                continue;
+
+            if (it.value() == path)
+                onDirectoryChanged(path);
+            else
+                onFileChanged(path);
+        }
+    }
+#endif
+}
+
 } // namespace Tiled
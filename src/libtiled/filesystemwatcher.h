@@ -30,12 +30,14 @@
 
 #include "tiled_global.h"
 
-#include <QMap>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QObject>
 #include <QSet>
 #include <QTimer>
 
 class QFileSystemWatcher;
+class QSocketNotifier;
 
 namespace Tiled {
 
@@ -46,9 +48,15 @@ namespace Tiled {
  *
  * It's meant to be used as drop-in replacement for QFileSystemWatcher.
  *
+ * On Linux, files are watched by watching their directory using inotify,
+ * which avoids running into the per-user limit on the number of watches
+ * when many files are watched. This requires the paths to be absolute and
+ * clean, other paths are watched using QFileSystemWatcher.
+ *
  * Optionally, the 'pathsChanged' signal can be used, which triggers at a delay
  * to avoid problems occurring when trying to reload only partially written
- * files, as well as avoiding fast consecutive reloads.
+ * files, as well as avoiding fast consecutive reloads. Changes arriving in
+ * quick succession are reported together.
  */
 class TILEDSHARED_EXPORT FileSystemWatcher : public QObject
 {
@@ -56,6 +64,7 @@ class TILEDSHARED_EXPORT FileSystemWatcher : public QObject
 
 public:
     explicit FileSystemWatcher(QObject *parent = nullptr);
+    ~FileSystemWatcher() override;
 
     void addPath(const QString &path);
     void removePath(const QString &path);
@@ -73,16 +82,38 @@ signals:
      */
     void pathsChanged(const QStringList &paths);
 
+private slots:
+    void readInotifyEvents();
+
 private:
+    struct DirectoryWatch
+    {
+        int descriptor;
+        int count;
+    };
+
     void onFileChanged(const QString &path);
     void onDirectoryChanged(const QString &path);
+    void queueChangedPath(const QString &path);
     void pathsChangedTimeout();
 
+    bool watchDirectoryOf(const QString &path);
+    void unwatchDirectoryOf(const QString &path);
+    void rewatchDirectory(const QString &directory);
+
     QFileSystemWatcher *mWatcher;
-    QMap<QString, int> mWatchCount;
+    QHash<QString, int> mWatchCount;
+
+    // Maps the paths watched using inotify to the watched directory
+    QHash<QString, QString> mDirectoryOfPath;
+    QHash<QString, DirectoryWatch> mDirectoryWatches;
+    QHash<int, QString> mDirectoryForDescriptor;
+    int mInotifyFd;
+    QSocketNotifier *mInotifyNotifier;
 
     QSet<QString> mChangedPaths;
     QTimer mChangedPathsTimer;
+    QElapsedTimer mChangedPathsAge;
 };
 
 } // namespace Tiled
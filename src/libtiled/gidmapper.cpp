@@ -33,6 +33,9 @@
 #include "tiled.h"
 #include "tileset.h"
 
+#include <algorithm>
+#include <memory>
+
 using namespace Tiled;
 
 // Bits on the far end of the 32-bit global tile ID are used for tile flags
@@ -180,16 +183,14 @@ QByteArray GidMapper::encodeLayerData(const TileLayer &tileLayer,
     return tileData.toBase64();
 }
 
-GidMapper::DecodeError GidMapper::decodeLayerData(TileLayer &tileLayer,
-                                                  const QByteArray &layerData,
-                                                  Map::LayerDataFormat format,
-                                                  QRect bounds) const
+static QByteArray decodeBase64Data(const QByteArray &layerData,
+                                   Map::LayerDataFormat format,
+                                   int size)
 {
     Q_ASSERT(format != Map::XML);
     Q_ASSERT(format != Map::CSV);
 
     QByteArray decodedData = QByteArray::fromBase64(layerData);
-    const int size = bounds.width() * bounds.height() * 4;
 
     if (format == Map::Base64Gzip)
         decodedData = decompress(decodedData, size, Gzip);
@@ -198,19 +199,255 @@ GidMapper::DecodeError GidMapper::decodeLayerData(TileLayer &tileLayer,
     else if (format == Map::Base64Zstandard)
         decodedData = decompress(decodedData, size, Zstandard);
 
+    return decodedData;
+}
+
+static inline unsigned readGid(const unsigned char *data)
+{
+    return data[0] |
+           data[1] << 8 |
+           data[2] << 16 |
+           data[3] << 24;
+}
+
+namespace {
+
+inline ushort characterCode(char c) { return static_cast<uchar>(c); }
+inline ushort characterCode(QChar c) { return c.unicode(); }
+
+/**
+ * Decodes base64 encoded text in parts. Like QByteArray::fromBase64,
+ * characters outside of the base64 alphabet are skipped.
+ */
+class Base64Decoder
+{
+public:
+    /**
+     * Decodes \a length characters of \a text into \a out, which needs room
+     * for at least length * 3 / 4 + 1 bytes. Returns the number of bytes
+     * written.
+     */
+    template<typename Char>
+    int decode(const Char *text, int length, char *out)
+    {
+        char *start = out;
+
+        for (int i = 0; i < length; ++i) {
+            const ushort c = characterCode(text[i]);
+            unsigned value;
+
+            if (c >= 'A' && c <= 'Z')
+                value = c - 'A';
+            else if (c >= 'a' && c <= 'z')
+                value = c - 'a' + 26;
+            else if (c >= '0' && c <= '9')
+                value = c - '0' + 52;
+            else if (c == '+')
+                value = 62;
+            else if (c == '/')
+                value = 63;
+            else
+                continue;
+
+            mBits = (mBits << 6) | value;
+            mBitCount += 6;
+
+            if (mBitCount >= 8) {
+                mBitCount -= 8;
+                *out++ = static_cast<char>(mBits >> mBitCount);
+                mBits &= (1u << mBitCount) - 1;
+            }
+        }
+
+        return static_cast<int>(out - start);
+    }
+
+private:
+    unsigned mBits = 0;
+    int mBitCount = 0;
+};
+
+/**
+ * Decodes base64 encoded and optionally compressed layer data in parts,
+ * setting each cell as soon as its global ID is known. This way the decoded
+ * and decompressed data never needs to be in memory as a whole.
+ */
+class LayerDataDecoder
+{
+public:
+    LayerDataDecoder(const GidMapper &gidMapper,
+                     TileLayer &tileLayer,
+                     Map::LayerDataFormat format,
+                     QRect bounds);
+
+    template<typename Char>
+    GidMapper::DecodeError decode(const Char *text, int length);
+
+    unsigned invalidTile() const { return mInvalidTile; }
+
+private:
+    bool writeGids(const char *data, int size);
+
+    const GidMapper &mGidMapper;
+    TileLayer &mTileLayer;
+    const QRect mBounds;
+    std::unique_ptr<Decompressor> mDecompressor;
+
+    GidMapper::DecodeError mError = GidMapper::NoError;
+    unsigned mInvalidTile = 0;
+
+    int mX;
+    int mY;
+    int mRemainingCells;
+    unsigned char mGidBytes[4];
+    int mGidByteCount = 0;
+};
+
+LayerDataDecoder::LayerDataDecoder(const GidMapper &gidMapper,
+                                   TileLayer &tileLayer,
+                                   Map::LayerDataFormat format,
+                                   QRect bounds)
+    : mGidMapper(gidMapper)
+    , mTileLayer(tileLayer)
+    , mBounds(bounds)
+    , mX(bounds.x())
+    , mY(bounds.y())
+    , mRemainingCells(bounds.width() * bounds.height())
+{
+    Q_ASSERT(format != Map::XML);
+    Q_ASSERT(format != Map::CSV);
+
+    const auto output = [this] (const char *data, int size) {
+        return writeGids(data, size);
+    };
+
+    if (format == Map::Base64Gzip)
+        mDecompressor.reset(new Decompressor(Gzip, output));
+    else if (format == Map::Base64Zlib)
+        mDecompressor.reset(new Decompressor(Zlib, output));
+    else if (format == Map::Base64Zstandard)
+        mDecompressor.reset(new Decompressor(Zstandard, output));
+}
+
+template<typename Char>
+GidMapper::DecodeError LayerDataDecoder::decode(const Char *text, int length)
+{
+    // The text is decoded in parts, so the buffer can be small
+    const int partLength = 4096;
+    char decoded[partLength * 3 / 4 + 1];
+    Base64Decoder base64Decoder;
+
+    for (int i = 0; i < length; i += partLength) {
+        const int decodedSize = base64Decoder.decode(text + i,
+                                                     std::min(partLength, length - i),
+                                                     decoded);
+
+        const bool ok = mDecompressor ? mDecompressor->write(decoded, decodedSize)
+                                      : writeGids(decoded, decodedSize);
+        if (!ok)
+            return mError != GidMapper::NoError ? mError : GidMapper::CorruptLayerData;
+    }
+
+    if (mRemainingCells > 0 || mGidByteCount > 0)
+        return GidMapper::CorruptLayerData;
+    if (mDecompressor && !mDecompressor->atEnd() && !mBounds.isEmpty())
+        return GidMapper::CorruptLayerData;
+
+    return GidMapper::NoError;
+}
+
+bool LayerDataDecoder::writeGids(const char *data, int size)
+{
+    bool ok;
+
+    for (int i = 0; i < size; ++i) {
+        mGidBytes[mGidByteCount++] = static_cast<unsigned char>(data[i]);
+        if (mGidByteCount < 4)
+            continue;
+
+        mGidByteCount = 0;
+
+        if (mRemainingCells == 0) {
+            mError = GidMapper::CorruptLayerData;
+            return false;
+        }
+
+        const unsigned gid = readGid(mGidBytes);
+        const Cell result = mGidMapper.gidToCell(gid, ok);
+        if (!ok) {
+            mInvalidTile = gid;
+            mError = mGidMapper.isEmpty() ? GidMapper::TileButNoTilesets
+                                          : GidMapper::InvalidTile;
+            return false;
+        }
+
+        mTileLayer.setCell(mX, mY, result);
+        --mRemainingCells;
+
+        mX++;
+        if (mX > mBounds.right()) {
+            mX = mBounds.x();
+            mY++;
+        }
+    }
+
+    return true;
+}
+
+} // anonymous namespace
+
+/**
+ * Decodes the base64 encoded \a layerData into the given \a bounds of
+ * \a tileLayer. The data is decoded and decompressed in parts, so the
+ * memory used does not depend on the size of the layer.
+ */
+GidMapper::DecodeError GidMapper::decodeLayerData(TileLayer &tileLayer,
+                                                  const QByteArray &layerData,
+                                                  Map::LayerDataFormat format,
+                                                  QRect bounds) const
+{
+    LayerDataDecoder decoder(*this, tileLayer, format, bounds);
+    const DecodeError error = decoder.decode(layerData.constData(), layerData.size());
+    mInvalidTile = decoder.invalidTile();
+    return error;
+}
+
+/**
+ * Overload that decodes the text of the layer data directly, avoiding the
+ * need to convert it to a QByteArray first.
+ */
+GidMapper::DecodeError GidMapper::decodeLayerData(TileLayer &tileLayer,
+                                                  QStringRef layerData,
+                                                  Map::LayerDataFormat format,
+                                                  QRect bounds) const
+{
+    LayerDataDecoder decoder(*this, tileLayer, format, bounds);
+    const DecodeError error = decoder.decode(layerData.unicode(), layerData.size());
+    mInvalidTile = decoder.invalidTile();
+    return error;
+}
+
+/**
+ * Decodes the base64 encoded \a chunkData of a single chunk of native size
+ * (CHUNK_SIZE by CHUNK_SIZE) into \a chunk.
+ */
+GidMapper::DecodeError GidMapper::decodeChunkData(Chunk &chunk,
+                                                  const QByteArray &chunkData,
+                                                  Map::LayerDataFormat format) const
+{
+    const int size = CHUNK_SIZE * CHUNK_SIZE * 4;
+    const QByteArray decodedData = decodeBase64Data(chunkData, format, size);
+
     if (size != decodedData.length())
         return CorruptLayerData;
 
     const unsigned char *data = reinterpret_cast<const unsigned char*>(decodedData.constData());
-    int x = bounds.x();
-    int y = bounds.y();
     bool ok;
 
-    for (int i = 0; i < size - 3; i += 4) {
-        const unsigned gid = data[i] |
-                             data[i + 1] << 8 |
-                             data[i + 2] << 16 |
-                             data[i + 3] << 24;
+    for (int index = 0; index < CHUNK_SIZE * CHUNK_SIZE; ++index) {
+        const unsigned gid = readGid(data + index * 4);
+        if (gid == 0)
+            continue;
 
         const Cell result = gidToCell(gid, ok);
         if (!ok) {
@@ -218,13 +455,7 @@ GidMapper::DecodeError GidMapper::decodeLayerData(TileLayer &tileLayer,
             return isEmpty() ? TileButNoTilesets : InvalidTile;
         }
 
-        tileLayer.setCell(x, y, result);
-
-        x++;
-        if (x > bounds.right()) {
-            x = bounds.x();
-            y++;
-        }
+        chunk.setCell(index & CHUNK_MASK, index / CHUNK_SIZE, result);
     }
 
     return NoError;
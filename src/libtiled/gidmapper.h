@@ -67,9 +67,21 @@ public:
                                 const QByteArray &layerData,
                                 Map::LayerDataFormat format,
                                 QRect bounds) const;
+    DecodeError decodeLayerData(TileLayer &tileLayer,
+                                QStringRef layerData,
+                                Map::LayerDataFormat format,
+                                QRect bounds) const;
+
+    DecodeError decodeChunkData(Chunk &chunk,
+                                const QByteArray &chunkData,
+                                Map::LayerDataFormat format) const;
 
     unsigned invalidTile() const;
 
+    QSet<SharedTileset> tilesets() const;
+
+    bool operator==(const GidMapper &other) const;
+
 private:
     QMap<unsigned, SharedTileset> mFirstGidToTileset;
 
@@ -77,6 +89,33 @@ private:
 };
 
 
+/**
+ * Decodes chunks that were stored in one of the base64 layer data formats,
+ * using a copy of the gid mapper that was in use when the chunk was read.
+ */
+class TILEDSHARED_EXPORT GidChunkDecoder : public ChunkDecoder
+{
+public:
+    GidChunkDecoder(const GidMapper &gidMapper, Map::LayerDataFormat format)
+        : mGidMapper(gidMapper)
+        , mFormat(format)
+    {}
+
+    bool decode(const QByteArray &data, Chunk &chunk) const override
+    { return mGidMapper.decodeChunkData(chunk, data, mFormat) == GidMapper::NoError; }
+
+    QSet<SharedTileset> tilesets() const override
+    { return mGidMapper.tilesets(); }
+
+    const GidMapper &gidMapper() const { return mGidMapper; }
+    Map::LayerDataFormat format() const { return mFormat; }
+
+private:
+    const GidMapper mGidMapper;
+    const Map::LayerDataFormat mFormat;
+};
+
+
 /**
  * Insert the given \a tileset with \a firstGid as its first global ID.
  */
@@ -101,6 +140,26 @@ inline bool GidMapper::isEmpty() const
     return mFirstGidToTileset.isEmpty();
 }
 
+/**
+ * Returns the set of tilesets known to this gid mapper.
+ */
+inline QSet<SharedTileset> GidMapper::tilesets() const
+{
+    QSet<SharedTileset> tilesets;
+    for (const SharedTileset &tileset : mFirstGidToTileset)
+        tilesets.insert(tileset);
+    return tilesets;
+}
+
+/**
+ * Returns whether both gid mappers assign the same global IDs to the same
+ * tilesets.
+ */
+inline bool GidMapper::operator==(const GidMapper &other) const
+{
+    return mFirstGidToTileset == other.mFirstGidToTileset;
+}
+
 /**
  * Returns the GID of the invalid tile in case decodeLayerData() returns
  * the InvalidTile error.
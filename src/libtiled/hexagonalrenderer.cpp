@@ -28,6 +28,7 @@
 
 #include "hexagonalrenderer.h"
 
+#include "cellwalker.h"
 #include "map.h"
 #include "mapobject.h"
 #include "tile.h"
@@ -324,18 +325,24 @@ void HexagonalRenderer::drawTileLayer(QPainter *painter,
         bool staggeredRow = p.doStaggerX(startTile.x() + layer->x());
 
         for (; startPos.y() < rect.bottom() && startTile.y() < endY;) {
-            QPoint rowTile = startTile;
             QPoint rowPos = startPos;
 
-            for (; rowPos.x() < rect.right() && rowTile.x() < endX; rowTile.rx() += 2) {
-                const Cell &cell = layer->cellAt(rowTile);
+            CellWalker walker(*layer, startTile, QPoint(2, 0));
 
-                if (!cell.isEmpty()) {
-                    Tile *tile = cell.tile();
-                    QSize size = tile ? tile->size() : map()->tileSize();
-                    renderer.render(cell, rowPos, size, CellRenderer::BottomLeft);
+            while (rowPos.x() < rect.right() && walker.position().x() < endX) {
+                // Skip over empty cells and absent chunks
+                if (const int steps = walker.emptyStepsAhead()) {
+                    walker.advance(steps);
+                    rowPos.rx() += steps * (p.tileWidth + p.sideLengthX);
+                    continue;
                 }
 
+                const Cell &cell = walker.cell();
+                Tile *tile = cell.tile();
+                QSize size = tile ? tile->size() : map()->tileSize();
+                renderer.render(cell, rowPos, size, CellRenderer::BottomLeft);
+
+                walker.advance();
                 rowPos.rx() += p.tileWidth + p.sideLengthX;
             }
 
@@ -366,21 +373,27 @@ void HexagonalRenderer::drawTileLayer(QPainter *painter,
             startPos.rx() -= p.columnWidth;
 
         for (; startPos.y() < rect.bottom() && startTile.y() < endY; startTile.ry()++) {
-            QPoint rowTile = startTile;
             QPoint rowPos = startPos;
 
             if (p.doStaggerY(startTile.y() + layer->y()))
                 rowPos.rx() += p.columnWidth;
 
-            for (; rowPos.x() < rect.right() && rowTile.x() < endX; rowTile.rx()++) {
-                const Cell &cell = layer->cellAt(rowTile);
+            CellWalker walker(*layer, startTile, QPoint(1, 0));
 
-                if (!cell.isEmpty()) {
-                    Tile *tile = cell.tile();
-                    QSize size = tile ? tile->size() : map()->tileSize();
-                    renderer.render(cell, rowPos, size, CellRenderer::BottomLeft);
+            while (rowPos.x() < rect.right() && walker.position().x() < endX) {
+                // Skip over empty cells and absent chunks
+                if (const int steps = walker.emptyStepsAhead()) {
+                    walker.advance(steps);
+                    rowPos.rx() += steps * (p.tileWidth + p.sideLengthX);
+                    continue;
                 }
 
+                const Cell &cell = walker.cell();
+                Tile *tile = cell.tile();
+                QSize size = tile ? tile->size() : map()->tileSize();
+                renderer.render(cell, rowPos, size, CellRenderer::BottomLeft);
+
+                walker.advance();
                 rowPos.rx() += p.tileWidth + p.sideLengthX;
             }
 
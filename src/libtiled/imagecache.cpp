@@ -35,9 +35,11 @@
 
 #include "qtcompat_p.h"
 
-#include <QBitmap>
 #include <QCoreApplication>
 #include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
 
 namespace Tiled {
 
@@ -64,9 +66,9 @@ uint qHash(const TilesheetParameters &key, uint seed) Q_DECL_NOTHROW
 
 struct CutTiles
 {
-    operator const QVector<QPixmap> &() const { return tiles; }
+    operator const QVector<QImage> &() const { return tiles; }
 
-    QVector<QPixmap> tiles;
+    QVector<QImage> tiles;
     QDateTime lastModified;
 };
 
@@ -101,8 +103,18 @@ QHash<QString, LoadedImage> ImageCache::sLoadedImages;
 QHash<QString, LoadedPixmap> ImageCache::sLoadedPixmaps;
 QHash<TilesheetParameters, CutTiles> ImageCache::sCutTiles;
 
+// Protects the above caches, since maps may be loaded on worker threads. It
+// is recursive because loading an image may involve loading other images.
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+static QRecursiveMutex sMutex;
+#else
+static QMutex sMutex(QMutex::Recursive);
+#endif
+
 LoadedImage ImageCache::loadImage(const QString &fileName)
 {
+    QMutexLocker locker(&sMutex);
+
     auto it = sLoadedImages.find(fileName);
 
     QFileInfo info(fileName);
@@ -127,6 +139,8 @@ LoadedImage ImageCache::loadImage(const QString &fileName)
 
 QPixmap ImageCache::loadPixmap(const QString &fileName)
 {
+    QMutexLocker locker(&sMutex);
+
     auto it = sLoadedPixmaps.find(fileName);
 
     bool found = it != sLoadedPixmaps.end();
@@ -140,6 +154,26 @@ QPixmap ImageCache::loadPixmap(const QString &fileName)
     return it.value();
 }
 
+/**
+ * Makes the pixels of the given \a color fully transparent. This has the
+ * same effect as setting a mask on a pixmap, but it can be done on any
+ * thread.
+ */
+static QImage applyTransparentColor(const QImage &image, const QColor &color)
+{
+    QImage result = image.convertToFormat(QImage::Format_ARGB32);
+    const QRgb transparent = color.rgb();
+
+    for (int y = 0; y < result.height(); ++y) {
+        QRgb *pixel = reinterpret_cast<QRgb*>(result.scanLine(y));
+        for (int x = 0; x < result.width(); ++x, ++pixel)
+            if (*pixel == transparent)
+                *pixel = 0;
+    }
+
+    return result;
+}
+
 static CutTiles cutTilesImpl(const TilesheetParameters &p)
 {
     Q_ASSERT(p.tileWidth > 0 && p.tileHeight > 0);
@@ -154,23 +188,22 @@ static CutTiles cutTilesImpl(const TilesheetParameters &p)
 
     for (int y = p.margin; y <= stopHeight; y += p.tileHeight + p.spacing) {
         for (int x = p.margin; x <= stopWidth; x += p.tileWidth + p.spacing) {
-            const QImage tileImage = image.copy(x, y, p.tileWidth, p.tileHeight);
-            QPixmap tilePixmap = QPixmap::fromImage(tileImage);
+            QImage tileImage = image.copy(x, y, p.tileWidth, p.tileHeight);
 
-            if (p.transparentColor.isValid()) {
-                const QImage mask = tileImage.createMaskFromColor(p.transparentColor.rgb());
-                tilePixmap.setMask(QBitmap::fromImage(mask));
-            }
+            if (p.transparentColor.isValid())
+                tileImage = applyTransparentColor(tileImage, p.transparentColor);
 
-            result.tiles.append(tilePixmap);
+            result.tiles.append(tileImage);
         }
     }
 
     return result;
 }
 
-QVector<QPixmap> ImageCache::cutTiles(const TilesheetParameters &parameters)
+QVector<QImage> ImageCache::cutTiles(const TilesheetParameters &parameters)
 {
+    QMutexLocker locker(&sMutex);
+
     auto it = sCutTiles.find(parameters);
 
     bool found = it != sCutTiles.end();
@@ -186,6 +219,8 @@ QVector<QPixmap> ImageCache::cutTiles(const TilesheetParameters &parameters)
 
 void ImageCache::remove(const QString &fileName)
 {
+    QMutexLocker locker(&sMutex);
+
     sLoadedImages.remove(fileName);
     sLoadedPixmaps.remove(fileName);
 
@@ -199,6 +234,12 @@ void ImageCache::remove(const QString &fileName)
 
 QImage ImageCache::renderMap(const QString &fileName)
 {
+    // Reading a map involves the TilesetManager and the map format plugins,
+    // which may only be used from the main thread
+    const QCoreApplication *app = QCoreApplication::instance();
+    if (app && QThread::currentThread() != app->thread())
+        return {};
+
     static QSet<QString> loadingMaps;
 
     if (loadingMaps.contains(fileName)) {
@@ -73,7 +73,7 @@ class TILEDSHARED_EXPORT ImageCache
 public:
     static LoadedImage loadImage(const QString &fileName);
     static QPixmap loadPixmap(const QString &fileName);
-    static QVector<QPixmap> cutTiles(const TilesheetParameters &parameters);
+    static QVector<QImage> cutTiles(const TilesheetParameters &parameters);
 
     static void remove(const QString &fileName);
 
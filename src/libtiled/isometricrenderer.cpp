@@ -28,6 +28,7 @@
 
 #include "isometricrenderer.h"
 
+#include "cellwalker.h"
 #include "map.h"
 #include "mapobject.h"
 #include "tile.h"
@@ -323,20 +324,26 @@ void IsometricRenderer::drawTileLayer(QPainter *painter,
     for (int y = startPos.y() * 2; y - tileHeight * 2 < rect.bottom() * 2;
          y += tileHeight)
     {
-        QPoint columnItr = rowItr;
-
-        for (int x = startPos.x(); x < rect.right(); x += tileWidth) {
-            const Cell &cell = layer->cellAt(columnItr);
-            if (!cell.isEmpty()) {
-                Tile *tile = cell.tile();
-                QSize size = (tile && !tile->image().isNull()) ? tile->size() : map()->tileSize();
-                renderer.render(cell, QPointF(x, (qreal)y / 2), size,
-                                CellRenderer::BottomLeft);
+        // Columns advance one tile right and one tile up
+        CellWalker columnItr(*layer, rowItr, QPoint(1, -1));
+
+        for (int x = startPos.x(); x < rect.right();) {
+            // Skip over empty cells and absent chunks
+            if (const int steps = columnItr.emptyStepsAhead()) {
+                columnItr.advance(steps);
+                x += steps * tileWidth;
+                continue;
             }
 
+            const Cell &cell = columnItr.cell();
+            Tile *tile = cell.tile();
+            QSize size = (tile && !tile->size().isEmpty()) ? tile->size() : map()->tileSize();
+            renderer.render(cell, QPointF(x, (qreal)y / 2), size,
+                            CellRenderer::BottomLeft);
+
             // Advance to the next column
-            ++columnItr.rx();
-            --columnItr.ry();
+            columnItr.advance();
+            x += tileWidth;
         }
 
         // Advance to the next row
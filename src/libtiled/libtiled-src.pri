@@ -1,6 +1,7 @@
 INCLUDEPATH += $$PWD
 
-SOURCES += $$PWD/compression.cpp \
+SOURCES += $$PWD/chunkimagecache.cpp \
+    $$PWD/compression.cpp \
     $$PWD/filesystemwatcher.cpp \
     $$PWD/fileformat.cpp \
     $$PWD/gidmapper.cpp \
@@ -29,7 +30,9 @@ SOURCES += $$PWD/compression.cpp \
     $$PWD/orthogonalrenderer.cpp \
     $$PWD/plugin.cpp \
     $$PWD/pluginmanager.cpp \
+    $$PWD/pngwriter.cpp \
     $$PWD/properties.cpp \
+    $$PWD/regionbuilder.cpp \
     $$PWD/savefile.cpp \
     $$PWD/staggeredrenderer.cpp \
     $$PWD/templatemanager.cpp \
@@ -43,7 +46,9 @@ SOURCES += $$PWD/compression.cpp \
     $$PWD/varianttomapconverter.cpp \
     $$PWD/wangset.cpp \
     $$PWD/worldmanager.cpp
-HEADERS += $$PWD/compression.h \
+HEADERS += $$PWD/cellwalker.h \
+    $$PWD/chunkimagecache.h \
+    $$PWD/compression.h \
     $$PWD/containerhelpers.h \
     $$PWD/filesystemwatcher.h \
     $$PWD/fileformat.h \
@@ -73,7 +78,9 @@ HEADERS += $$PWD/compression.h \
     $$PWD/orthogonalrenderer.h \
     $$PWD/plugin.h \
     $$PWD/pluginmanager.h \
+    $$PWD/pngwriter.h \
     $$PWD/properties.h \
+    $$PWD/regionbuilder.h \
     $$PWD/savefile.h \
     $$PWD/staggeredrenderer.h \
     $$PWD/templatemanager.h \
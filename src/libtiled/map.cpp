@@ -387,15 +387,29 @@ Layer *Map::findLayerById(int layerId) const
     return nullptr;
 }
 
+/**
+ * Returns the object with the given \a objectId, or nullptr if no such
+ * object is part of this map.
+ *
+ * The objects are looked up in an index that is kept up to date as objects
+ * and object layers are added to or removed from the map, and as the IDs of
+ * objects change.
+ */
 MapObject *Map::findObjectById(int objectId) const
 {
-    for (Layer *layer : objectGroups()) {
-        for (MapObject *mapObject : static_cast<ObjectGroup*>(layer)->objects()) {
-            if (mapObject->id() == objectId)
-                return mapObject;
-        }
-    }
-    return nullptr;
+    return mObjectsById.value(objectId);
+}
+
+void Map::addToObjectIndex(MapObject *mapObject)
+{
+    if (mapObject->id() != 0)
+        mObjectsById.insert(mapObject->id(), mapObject);
+}
+
+void Map::removeFromObjectIndex(MapObject *mapObject)
+{
+    if (mapObject->id() != 0)
+        mObjectsById.remove(mapObject->id(), mapObject);
 }
 
 QRegion Map::tileRegion() const
@@ -36,6 +36,7 @@
 
 #include <QColor>
 #include <QList>
+#include <QMultiHash>
 #include <QMargins>
 #include <QSharedPointer>
 #include <QSize>
@@ -479,9 +480,14 @@ signals:
 
 private:
     friend class GroupLayer;    // so it can call adoptLayer
+    friend class MapObject;     // so it can update the object index
+    friend class ObjectGroup;   // so it can update the object index
 
     void adoptLayer(Layer &layer);
 
+    void addToObjectIndex(MapObject *mapObject);
+    void removeFromObjectIndex(MapObject *mapObject);
+
     void recomputeDrawMargins() const;
 
     Orientation mOrientation;
@@ -504,6 +510,7 @@ private:
     LayerDataFormat mLayerDataFormat;
     int mNextLayerId;
     int mNextObjectId;
+    QMultiHash<int, MapObject*> mObjectsById;
 };
 
 
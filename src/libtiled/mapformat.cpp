@@ -71,10 +71,13 @@ std::unique_ptr<Map> readMap(const QString &fileName, QString *error)
 
 MapFormat *findSupportingMapFormat(const QString &fileName)
 {
-    const auto mapFormats = PluginManager::objects<MapFormat>();
-    for (MapFormat *format : mapFormats)
-        if (format->supportsFile(fileName))
-            return format;
+    do {
+        const auto mapFormats = PluginManager::objects<MapFormat>();
+        for (MapFormat *format : mapFormats)
+            if (format->supportsFile(fileName))
+                return format;
+    } while (PluginManager::loadPluginsOnDemand(fileName));
+
     return nullptr;
 }
 
@@ -86,17 +86,54 @@ MapObject::MapObject(const QString &name, const QString &type,
     mSize(size),
     mObjectTemplate(nullptr),
     mObjectGroup(nullptr),
+    mIndex(-1),
     mRotation(0.0),
     mVisible(true),
     mTemplateBase(false)
 {
 }
 
+/**
+ * Sets the id of this object.
+ */
+void MapObject::setId(int id)
+{
+    if (mId == id)
+        return;
+
+    Map *map = mObjectGroup ? mObjectGroup->map() : nullptr;
+    if (map)
+        map->removeFromObjectIndex(this);
+
+    mId = id;
+
+    if (map)
+        map->addToObjectIndex(this);
+}
+
+/**
+ * Returns the position of this object within its object group, or -1 when
+ * it is not part of an object group.
+ *
+ * The position is cached. When the cached position turns out to be outdated,
+ * for example because objects were inserted, removed or reordered, the
+ * positions of all objects in the group are updated at once. This makes
+ * looking up the positions of many objects a linear operation.
+ */
 int MapObject::index() const
 {
-    if (mObjectGroup)
-        return mObjectGroup->objects().indexOf(const_cast<MapObject*>(this));
-    return -1;
+    if (!mObjectGroup)
+        return -1;
+
+    const QList<MapObject*> &objects = mObjectGroup->objects();
+
+    if (mIndex < 0 || mIndex >= objects.size() || objects.at(mIndex) != this) {
+        mIndex = -1;
+        for (int i = 0; i < objects.size(); ++i)
+            objects.at(i)->mIndex = i;
+    }
+
+    return mIndex;
 }
 
 /**
@@ -236,6 +236,7 @@ private:
     Cell mCell;
     const ObjectTemplate *mObjectTemplate;
     ObjectGroup *mObjectGroup;
+    mutable int mIndex;         // cached position within mObjectGroup
     qreal mRotation;
     bool mVisible;
     bool mTemplateBase;
@@ -249,12 +250,6 @@ private:
 inline int MapObject::id() const
 { return mId; }
 
-/**
- * Sets the id of this object.
- */
-inline void MapObject::setId(int id)
-{ mId = id; }
-
 /**
  * Sets the id back to 0. Mostly used when a new id should be assigned
  * after the object has been cloned.
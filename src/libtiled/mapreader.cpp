@@ -106,9 +106,13 @@ private:
                            QStringRef encoding,
                            QRect bounds);
     void decodeBinaryLayerData(TileLayer &tileLayer,
-                               const QByteArray &data,
+                               QStringRef text,
                                Map::LayerDataFormat format,
                                QRect bounds);
+    bool storeEncodedChunk(TileLayer &tileLayer,
+                           QStringRef text,
+                           Map::LayerDataFormat format,
+                           QRect bounds);
     void decodeCSVLayerData(TileLayer &tileLayer,
                             QStringRef text,
                             QRect bounds);
@@ -144,6 +148,7 @@ private:
     QDir mPath;
     std::unique_ptr<Map> mMap;
     GidMapper mGidMapper;
+    QSharedPointer<GidChunkDecoder> mChunkDecoder;
     bool mReadingExternalTileset;
 
     QXmlStreamReader xml;
@@ -167,6 +172,7 @@ std::unique_ptr<Map> MapReaderPrivate::readMap(QIODevice *device, const QString
     }
 
     mGidMapper.clear();
+    mChunkDecoder.reset();
     return map;
 }
 
@@ -506,7 +512,7 @@ void MapReaderPrivate::readTilesetTile(Tileset &tileset)
         } else if (xml.name() == QLatin1String("image")) {
             ImageReference imageReference = readImage();
             if (imageReference.hasImage()) {
-                QPixmap image = imageReference.create();
+                QImage image = imageReference.createImage();
                 if (image.isNull()) {
                     if (imageReference.source.isEmpty())
                         xml.raiseError(tr("Error reading embedded image for tile %1").arg(id));
@@ -901,10 +907,8 @@ void MapReaderPrivate::readTileLayerRect(TileLayer &tileLayer,
             }
         } else if (xml.isCharacters() && !xml.isWhitespace()) {
             if (encoding == QLatin1String("base64")) {
-                decodeBinaryLayerData(tileLayer,
-                                      xml.text().toLatin1(),
-                                      layerDataFormat,
-                                      bounds);
+                if (!storeEncodedChunk(tileLayer, xml.text(), layerDataFormat, bounds))
+                    decodeBinaryLayerData(tileLayer, xml.text(), layerDataFormat, bounds);
             } else if (encoding == QLatin1String("csv")) {
                 decodeCSVLayerData(tileLayer, xml.text(), bounds);
             }
@@ -912,14 +916,18 @@ void MapReaderPrivate::readTileLayerRect(TileLayer &tileLayer,
     }
 }
 
+/**
+ * Decodes the base64 encoded layer data directly from the \a text of the
+ * element, without making a copy of it.
+ */
 void MapReaderPrivate::decodeBinaryLayerData(TileLayer &tileLayer,
-                                             const QByteArray &data,
+                                             QStringRef text,
                                              Map::LayerDataFormat format,
                                              QRect bounds)
 {
     GidMapper::DecodeError error;
 
-    error = mGidMapper.decodeLayerData(tileLayer, data, format, bounds);
+    error = mGidMapper.decodeLayerData(tileLayer, text, format, bounds);
 
     switch (error) {
     case GidMapper::CorruptLayerData:
@@ -936,6 +944,38 @@ void MapReaderPrivate::decodeBinaryLayerData(TileLayer &tileLayer,
     }
 }
 
+/**
+ * Chunks of infinite maps that match the native chunk size are not decoded
+ * while reading. Instead, their data is stored in the layer, which decodes
+ * each chunk when it is first accessed.
+ *
+ * Since the data is not validated here, corrupt chunks are only reported
+ * once they are decoded.
+ *
+ * Returns whether the chunk was stored.
+ */
+bool MapReaderPrivate::storeEncodedChunk(TileLayer &tileLayer,
+                                         QStringRef text,
+                                         Map::LayerDataFormat format,
+                                         QRect bounds)
+{
+    if (!mMap->infinite())
+        return false;
+    if (bounds.width() != CHUNK_SIZE || bounds.height() != CHUNK_SIZE)
+        return false;
+    if ((bounds.x() & CHUNK_MASK) || (bounds.y() & CHUNK_MASK))
+        return false;
+
+    // All chunks with the same format share a decoder
+    if (!mChunkDecoder || mChunkDecoder->format() != format)
+        mChunkDecoder = QSharedPointer<GidChunkDecoder>::create(mGidMapper, format);
+
+    const QPoint chunkCoordinates(bounds.x() / CHUNK_SIZE, bounds.y() / CHUNK_SIZE);
+    tileLayer.setEncodedChunk(chunkCoordinates,
+                              EncodedChunk { text.trimmed().toLatin1(), mChunkDecoder });
+    return true;
+}
+
 void MapReaderPrivate::decodeCSVLayerData(TileLayer &tileLayer,
                                           QStringRef text,
                                           QRect bounds)
@@ -1094,7 +1134,7 @@ std::unique_ptr<MapObject> MapReaderPrivate::readObject()
 
     if (!templateFileName.isEmpty()) { // This object is a template instance
         const QString absoluteFileName = p->resolveReference(templateFileName, mPath);
-        auto objectTemplate = TemplateManager::instance()->loadObjectTemplate(absoluteFileName);
+        auto objectTemplate = p->readExternalObjectTemplate(absoluteFileName);
         object->setObjectTemplate(objectTemplate);
     }
 
@@ -1424,3 +1464,8 @@ SharedTileset MapReader::readExternalTileset(const QString &source,
 {
     return TilesetManager::instance()->loadTileset(source, error);
 }
+
+ObjectTemplate *MapReader::readExternalObjectTemplate(const QString &fileName)
+{
+    return TemplateManager::instance()->loadObjectTemplate(fileName);
+}
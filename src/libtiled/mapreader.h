@@ -117,6 +117,15 @@ protected:
     virtual SharedTileset readExternalTileset(const QString &source,
                                               QString *error);
 
+    /**
+     * Called when a template instance is encountered while a map is loaded.
+     * The default implementation asks the TemplateManager.
+     *
+     * The returned template is not owned by the map, so it needs to stay
+     * alive for as long as the map is used.
+     */
+    virtual ObjectTemplate *readExternalObjectTemplate(const QString &fileName);
+
 private:
     Q_DISABLE_COPY(MapReader)
 
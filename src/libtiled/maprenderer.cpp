@@ -28,6 +28,7 @@
 
 #include "maprenderer.h"
 
+#include "chunkimagecache.h"
 #include "imagelayer.h"
 #include "isometricrenderer.h"
 #include "map.h"
@@ -37,49 +38,119 @@
 #include "tilelayer.h"
 #include "objectgroup.h"
 
+#include <QCoreApplication>
 #include <QPaintEngine>
 #include <QPainter>
+#include <QThread>
 #include <QVector2D>
 
 #include "qtcompat_p.h"
 
 #include <cmath>
+#include <functional>
 #include <memory>
 
 using namespace Tiled;
 
-static QPixmap tinted(const QPixmap &pixmap, const QColor &color)
+static bool isTint(const QColor &color)
 {
-    if (!color.isValid() || color == QColor(255, 255, 255, 255))
-        return pixmap;
-
-    QPixmap resultImage = pixmap;
-    QPainter painter(&resultImage);
+    return color.isValid() && color != QColor(255, 255, 255, 255);
+}
 
+/**
+ * Tints the image painted on by \a painter, which covers \a rect. The
+ * \a drawOriginal function draws the original image, which is used to
+ * restore its alpha.
+ */
+static void tint(QPainter &painter, const QRect &rect, const QColor &color,
+                 const std::function<void()> &drawOriginal)
+{
     QColor fullOpacity = color;
     fullOpacity.setAlpha(255);
     // tint the final color (this will will mess up the alpha which we will fix
     // in the next lines)
     painter.setCompositionMode(QPainter::CompositionMode_Multiply);
-    painter.fillRect(resultImage.rect(), fullOpacity);
+    painter.fillRect(rect, fullOpacity);
 
     // apply the original alpha to the final image
     painter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
-    painter.drawPixmap(0, 0, pixmap);
+    drawOriginal();
 
     // apply the alpha of the tint color so that we can use it to make the image
     // transparent instead of just increasing or decreasing the tint effect
     painter.setCompositionMode(QPainter::CompositionMode_DestinationIn);
-    painter.fillRect(resultImage.rect(), color);
+    painter.fillRect(rect, color);
 
     painter.end();
+}
 
+static QPixmap tinted(const QPixmap &pixmap, const QColor &color)
+{
+    if (!isTint(color))
+        return pixmap;
+
+    QPixmap resultImage = pixmap;
+    QPainter painter(&resultImage);
+    tint(painter, resultImage.rect(), color, [&] { painter.drawPixmap(0, 0, pixmap); });
     return resultImage;
 }
 
+/**
+ * Overload used for tile images that are drawn on other threads than the GUI
+ * thread before they were converted to a pixmap.
+ */
+static QImage tinted(const QImage &image, const QColor &color)
+{
+    if (!isTint(color))
+        return image;
+
+    QImage resultImage = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&resultImage);
+    tint(painter, resultImage.rect(), color, [&] { painter.drawImage(0, 0, image); });
+    return resultImage;
+}
+
+MapRenderer::MapRenderer(const Map *map)
+    : mMap(map)
+    , mFlags(nullptr)
+    , mObjectLineWidth(2)
+    , mPainterScale(1)
+{}
+
 MapRenderer::~MapRenderer()
 {}
 
+/**
+ * Discards the down-sampled images used for drawing tile layers when zoomed
+ * out far. Needs to be called when the images of tiles have changed.
+ */
+void MapRenderer::clearLevelOfDetailCache()
+{
+    if (mChunkImageCache)
+        mChunkImageCache->clear();
+}
+
+/**
+ * Returns whether tile layers should be drawn using down-sampled images,
+ * which is the case when the UseLevelOfDetail flag is set and tiles would
+ * be drawn at a size of less than two pixels.
+ */
+bool MapRenderer::useLevelOfDetail() const
+{
+    if (!testFlag(UseLevelOfDetail))
+        return false;
+
+    const int tileSize = qMin(mMap->tileWidth(), mMap->tileHeight());
+    return tileSize * mPainterScale < 2;
+}
+
+ChunkImageCache &MapRenderer::chunkImageCache() const
+{
+    if (!mChunkImageCache)
+        mChunkImageCache.reset(new ChunkImageCache);
+    return *mChunkImageCache;
+}
+
 QRectF MapRenderer::boundingRect(const ImageLayer *imageLayer) const
 {
     return QRectF(QPointF(), imageLayer->image().size());
@@ -252,11 +323,18 @@ static bool hasOpenGLEngine(const QPainter *painter)
             type == QPaintEngine::OpenGL2);
 }
 
+static bool isGuiThread()
+{
+    const QCoreApplication *app = QCoreApplication::instance();
+    return app && QThread::currentThread() == app->thread();
+}
+
 CellRenderer::CellRenderer(QPainter *painter, const MapRenderer *renderer, const QColor &tintColor, CellType cellType)
     : mPainter(painter)
     , mRenderer(renderer)
     , mTile(nullptr)
     , mIsOpenGL(hasOpenGLEngine(painter))
+    , mTintImages(isTint(tintColor) && !isGuiThread())
     , mCellType(cellType)
     , mTintColor(tintColor)
 {
@@ -280,7 +358,7 @@ void CellRenderer::render(const Cell &cell, const QPointF &pos, const QSizeF &si
     if (tile)
         tile = tile->currentFrameTile();
 
-    if (!tile || tile->image().isNull()) {
+    if (!tile || tile->size().isEmpty()) {
         QRectF target { pos, size };
 
         if (origin == BottomLeft)
@@ -295,10 +373,14 @@ void CellRenderer::render(const Cell &cell, const QPointF &pos, const QSizeF &si
     if (mTile != tile || mFragments.size() == USHRT_MAX)
         flush();
 
-    const QPixmap &image = tile->image();
-    const QSizeF imageSize = image.size();
-    if (imageSize.isEmpty())
-        return;
+    // On other threads than the GUI thread, tile images that were never
+    // shown are not converted to a pixmap, so the image is drawn instead.
+    // Tinting also creates a pixmap, so there tinted tiles are drawn from an
+    // image as well.
+    QImage image = tile->pendingImage();
+    if (image.isNull() && mTintImages)
+        image = tile->image().toImage();
+    const QSizeF imageSize = tile->size();
 
     const QSizeF scale(size.width() / imageSize.width(), size.height() / imageSize.height());
     const QPoint offset = tile->offset();
@@ -348,14 +430,15 @@ void CellRenderer::render(const Cell &cell, const QPointF &pos, const QSizeF &si
     fragment.scaleX = scale.width() * (flippedHorizontally ? -1 : 1);
     fragment.scaleY = scale.height() * (flippedVertically ? -1 : 1);
 
-    if (mIsOpenGL || (fragment.scaleX > 0 && fragment.scaleY > 0)) {
+    if (image.isNull() && (mIsOpenGL || (fragment.scaleX > 0 && fragment.scaleY > 0))) {
         mTile = tile;
         mFragments.append(fragment);
         return;
     }
 
     // The Raster paint engine as of Qt 4.8.4 / 5.0.2 does not support
-    // drawing fragments with a negative scaling factor.
+    // drawing fragments with a negative scaling factor. Fragments can also
+    // only be drawn from a pixmap.
 
     flush(); // make sure we drew all tiles so far
 
@@ -370,7 +453,10 @@ void CellRenderer::render(const Cell &cell, const QPointF &pos, const QSizeF &si
     const QRectF source(0, 0, fragment.width, fragment.height);
 
     mPainter->setTransform(transform);
-    mPainter->drawPixmap(target, tinted(image, mTintColor), source);
+    if (image.isNull())
+        mPainter->drawPixmap(target, tinted(tile->image(), mTintColor), source);
+    else
+        mPainter->drawImage(target, tinted(image, mTintColor), source);
     mPainter->setTransform(oldTransform);
 
     // A bit of a hack to still draw tile collision shapes when requested
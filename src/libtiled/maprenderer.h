@@ -32,11 +32,14 @@
 
 #include <QPainter>
 
+#include <memory>
+
 namespace Tiled {
 
 class Cell;
 class Layer;
 class Map;
+class ChunkImageCache;
 class MapObject;
 class Tile;
 class TileLayer;
@@ -44,7 +47,8 @@ class ImageLayer;
 
 enum RenderFlag {
     ShowTileObjectOutlines = 0x1,
-    ShowTileCollisionShapes = 0x2
+    ShowTileCollisionShapes = 0x2,
+    UseLevelOfDetail = 0x4
 };
 
 Q_DECLARE_FLAGS(RenderFlags, RenderFlag)
@@ -53,16 +57,15 @@ Q_DECLARE_FLAGS(RenderFlags, RenderFlag)
  * This interface is used for rendering tile layers and retrieving associated
  * metrics. The different implementations deal with different map
  * orientations.
+ *
+ * A renderer is not reentrant when the UseLevelOfDetail flag is set, since
+ * drawing then updates a cache of down-sampled chunk images. Such a renderer
+ * should only be used from one thread at a time.
  */
 class TILEDSHARED_EXPORT MapRenderer
 {
 public:
-    MapRenderer(const Map *map)
-        : mMap(map)
-        , mFlags(nullptr)
-        , mObjectLineWidth(2)
-        , mPainterScale(1)
-    {}
+    MapRenderer(const Map *map);
 
     virtual ~MapRenderer();
 
@@ -246,15 +249,21 @@ public:
 
     static QPolygonF lineToPolygon(const QPointF &start, const QPointF &end);
 
+    void clearLevelOfDetailCache();
+
 protected:
     QPen makeGridPen(const QPaintDevice *device, QColor color) const;
 
+    bool useLevelOfDetail() const;
+    ChunkImageCache &chunkImageCache() const;
+
 private:
     const Map *mMap;
 
     RenderFlags mFlags;
     qreal mObjectLineWidth;
     qreal mPainterScale;
+    mutable std::unique_ptr<ChunkImageCache> mChunkImageCache;
 };
 
 inline const Map *MapRenderer::map() const
@@ -316,6 +325,7 @@ private:
     const Tile *mTile;
     QVector<QPainter::PixmapFragment> mFragments;
     const bool mIsOpenGL;
+    const bool mTintImages;
     const CellType mCellType;
     const QColor mTintColor;
 };
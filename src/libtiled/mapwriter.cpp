@@ -461,7 +461,11 @@ void MapWriterPrivate::writeTileset(QXmlStreamWriter &w, const Tileset &tileset,
                                      QLatin1String("base64"));
 
                     QBuffer buffer;
-                    tile->image().save(&buffer, "png");
+                    const QImage pendingImage = tile->pendingImage();
+                    if (!pendingImage.isNull())
+                        pendingImage.save(&buffer, "png");
+                    else
+                        tile->image().save(&buffer, "png");
                     w.writeCharacters(QString::fromLatin1(buffer.data().toBase64()));
                     w.writeEndElement(); // </data>
                 } else {
@@ -667,10 +671,22 @@ void MapWriterPrivate::writeTileLayerData(QXmlStreamWriter &w,
 
         w.writeCharacters(chunkData);
     } else {
-        QByteArray chunkData = mGidMapper.encodeLayerData(tileLayer,
-                                                          mLayerDataFormat,
-                                                          bounds,
-                                                          mCompressionlevel);
+        QByteArray chunkData;
+
+        // Chunks that were never decoded can be written out unchanged, as
+        // long as the format and the global tile IDs are still the same
+        if (const EncodedChunk *encodedChunk = tileLayer.findEncodedChunk(bounds)) {
+            auto decoder = dynamic_cast<const GidChunkDecoder*>(encodedChunk->decoder.data());
+            if (decoder && decoder->format() == mLayerDataFormat && decoder->gidMapper() == mGidMapper)
+                chunkData = encodedChunk->data;
+        }
+
+        if (chunkData.isEmpty()) {
+            chunkData = mGidMapper.encodeLayerData(tileLayer,
+                                                   mLayerDataFormat,
+                                                   bounds,
+                                                   mCompressionlevel);
+        }
 
         if (!mMinimize)
             w.writeCharacters(QLatin1String("\n   "));
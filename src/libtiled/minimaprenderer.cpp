@@ -141,10 +141,21 @@ static void extendMapRect(QRect &mapBoundingRect, const MapRenderer &renderer)
 }
 
 void MiniMapRenderer::renderToImage(QImage& image, RenderFlags renderFlags) const
+{
+    renderToImage(image, renderFlags, image.size(), QPoint());
+}
+
+/**
+ * Renders the part of a map image of the given \a size that starts at
+ * \a offset into \a image. This makes it possible to render an image that
+ * is too large to allocate in several parts.
+ */
+void MiniMapRenderer::renderToImage(QImage &image, RenderFlags renderFlags,
+                                    QSize size, QPoint offset) const
 {
     if (!mMap)
         return;
-    if (image.isNull())
+    if (image.isNull() || size.isEmpty())
         return;
 
     bool drawObjects = renderFlags.testFlag(RenderFlag::DrawMapObjects);
@@ -164,8 +175,8 @@ void MiniMapRenderer::renderToImage(QImage& image, RenderFlags renderFlags) cons
     mapSize.setHeight(mapSize.height() + margins.top() + margins.bottom());
 
     // Determine the largest possible scale
-    qreal scale = qMin(static_cast<qreal>(image.width()) / mapSize.width(),
-                       static_cast<qreal>(image.height()) / mapSize.height());
+    qreal scale = qMin(static_cast<qreal>(size.width()) / mapSize.width(),
+                       static_cast<qreal>(size.height()) / mapSize.height());
 
     if (renderFlags.testFlag(DrawBackground) && mMap->backgroundColor().isValid())
         image.fill(mMap->backgroundColor());
@@ -177,9 +188,10 @@ void MiniMapRenderer::renderToImage(QImage& image, RenderFlags renderFlags) cons
 
     // Center the map in the requested size
     QSize scaledMapSize = mapSize * scale;
-    QPointF centerOffset((image.width() - scaledMapSize.width()) / 2,
-                         (image.height() - scaledMapSize.height()) / 2);
+    QPointF centerOffset((size.width() - scaledMapSize.width()) / 2,
+                         (size.height() - scaledMapSize.height()) / 2);
 
+    painter.translate(-offset);
     painter.translate(centerOffset);
     painter.scale(scale, scale);
     painter.translate(margins.left(), margins.top());
@@ -192,16 +204,17 @@ void MiniMapRenderer::renderToImage(QImage& image, RenderFlags renderFlags) cons
         if (visibleLayersOnly && layer->isHidden())
             continue;
 
-        const auto offset = layer->totalOffset();
+        const auto layerOffset = layer->totalOffset();
 
         painter.setOpacity(layer->effectiveOpacity());
-        painter.translate(offset);
+        painter.translate(layerOffset);
 
         switch (layer->layerType()) {
         case Layer::TileLayerType: {
             if (drawTileLayers) {
                 const TileLayer *tileLayer = static_cast<const TileLayer*>(layer);
-                mRenderer->drawTileLayer(&painter, tileLayer);
+                const QRectF exposed = painter.transform().inverted().mapRect(QRectF(image.rect()));
+                mRenderer->drawTileLayer(&painter, tileLayer, exposed);
             }
             break;
         }
@@ -247,7 +260,7 @@ void MiniMapRenderer::renderToImage(QImage& image, RenderFlags renderFlags) cons
             break;
         }
 
-        painter.translate(-offset);
+        painter.translate(-layerOffset);
     }
 
     if (drawTileGrid)
@@ -65,6 +65,8 @@ public:
     QImage render(QSize size, RenderFlags renderFlags) const;
 
     void renderToImage(QImage &image, RenderFlags renderFlags) const;
+    void renderToImage(QImage &image, RenderFlags renderFlags,
+                       QSize size, QPoint offset) const;
 
 private:
     const Map *mMap;
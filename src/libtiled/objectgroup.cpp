@@ -71,8 +71,13 @@ void ObjectGroup::insertObject(int index, MapObject *object)
 {
     mObjects.insert(index, object);
     object->setObjectGroup(this);
-    if (mMap && object->id() == 0)
-        object->setId(mMap->takeNextObjectId());
+
+    if (mMap) {
+        if (object->id() == 0)
+            object->setId(mMap->takeNextObjectId());   // also adds it to the index
+        else
+            mMap->addToObjectIndex(object);
+    }
 }
 
 int ObjectGroup::removeObject(MapObject *object)
@@ -88,6 +93,8 @@ int ObjectGroup::removeObject(MapObject *object)
 void ObjectGroup::removeObjectAt(int index)
 {
     MapObject *object = mObjects.takeAt(index);
+    if (mMap)
+        mMap->removeFromObjectIndex(object);
     object->setObjectGroup(nullptr);
 }
 
@@ -216,6 +223,22 @@ ObjectGroup *ObjectGroup::clone() const
     return initializeClone(new ObjectGroup(mName, mX, mY));
 }
 
+void ObjectGroup::setMap(Map *map)
+{
+    if (mMap == map)
+        return;
+
+    if (mMap)
+        for (MapObject *object : qAsConst(mObjects))
+            mMap->removeFromObjectIndex(object);
+
+    Layer::setMap(map);
+
+    if (mMap)
+        for (MapObject *object : qAsConst(mObjects))
+            mMap->addToObjectIndex(object);
+}
+
 /**
  * Resets the ids of all objects to 0. Mostly used when new ids should be
  * assigned after the object group has been cloned.
@@ -48,10 +48,13 @@ std::unique_ptr<ObjectTemplate> readObjectTemplate(const QString &fileName, QStr
 
 ObjectTemplateFormat *findSupportingTemplateFormat(const QString &fileName)
 {
-    const auto formats = PluginManager::objects<ObjectTemplateFormat>();
-    for (ObjectTemplateFormat *format : formats)
-        if (format->supportsFile(fileName))
-            return format;
+    do {
+        const auto formats = PluginManager::objects<ObjectTemplateFormat>();
+        for (ObjectTemplateFormat *format : formats)
+            if (format->supportsFile(fileName))
+                return format;
+    } while (PluginManager::loadPluginsOnDemand(fileName));
+
     return nullptr;
 }
 
@@ -28,6 +28,8 @@
 
 #include "orthogonalrenderer.h"
 
+#include "cellwalker.h"
+#include "chunkimagecache.h"
 #include "map.h"
 #include "mapobject.h"
 #include "tile.h"
@@ -305,6 +307,13 @@ void OrthogonalRenderer::drawTileLayer(QPainter *painter,
     const QTransform savedTransform = painter->transform();
     painter->translate(layerPos);
 
+    if (useLevelOfDetail()) {
+        drawChunkImages(painter, layer, QRect(QPoint(startX, startY),
+                                              QPoint(endX, endY)));
+        painter->setTransform(savedTransform);
+        return;
+    }
+
     CellRenderer renderer(painter, this, layer->effectiveTintColor());
 
     Map::RenderOrder renderOrder = map()->renderOrder();
@@ -333,17 +342,27 @@ void OrthogonalRenderer::drawTileLayer(QPainter *painter,
     endY += incY;
 
     for (int y = startY; y != endY; y += incY) {
-        for (int x = startX; x != endX; x += incX) {
-            const Cell &cell = layer->cellAt(x, y);
-            if (cell.isEmpty())
+        CellWalker walker(*layer, QPoint(startX, y), QPoint(incX, 0));
+
+        for (int x = startX; x != endX;) {
+            // Skip over empty cells and absent chunks
+            if (const int steps = walker.emptyStepsAhead()) {
+                const int skip = qMin(steps, (endX - x) * incX);
+                x += skip * incX;
+                walker.advance(skip);
                 continue;
+            }
 
+            const Cell &cell = walker.cell();
             Tile *tile = cell.tile();
-            QSize size = (tile && !tile->image().isNull()) ? tile->size() : map()->tileSize();
+            QSize size = (tile && !tile->size().isEmpty()) ? tile->size() : map()->tileSize();
             renderer.render(cell,
                             QPointF(x * tileWidth, (y + 1) * tileHeight),
                             size,
                             CellRenderer::BottomLeft);
+
+            x += incX;
+            walker.advance();
         }
     }
 
@@ -352,6 +371,32 @@ void OrthogonalRenderer::drawTileLayer(QPainter *painter,
     painter->setTransform(savedTransform);
 }
 
+/**
+ * Draws the chunks of \a layer that overlap \a tileRect using their
+ * down-sampled images, in which each tile is a single pixel.
+ */
+void OrthogonalRenderer::drawChunkImages(QPainter *painter,
+                                         const TileLayer *layer,
+                                         const QRect &tileRect) const
+{
+    const int tileWidth = map()->tileWidth();
+    const int tileHeight = map()->tileHeight();
+    ChunkImageCache &cache = chunkImageCache();
+
+    for (int y = tileRect.top() & ~CHUNK_MASK; y <= tileRect.bottom(); y += CHUNK_SIZE) {
+        for (int x = tileRect.left() & ~CHUNK_MASK; x <= tileRect.right(); x += CHUNK_SIZE) {
+            const Chunk *chunk = layer->findChunk(x, y);
+            if (!chunk || chunk->isNull())
+                continue;
+
+            const QRectF target(x * tileWidth, y * tileHeight,
+                                CHUNK_SIZE * tileWidth, CHUNK_SIZE * tileHeight);
+
+            painter->drawImage(target, cache.image(layer, QPoint(x, y), *chunk));
+        }
+    }
+}
+
 void OrthogonalRenderer::drawTileSelection(QPainter *painter,
                                            const QRegion &region,
                                            const QColor &color,
@@ -81,6 +81,10 @@ public:
 
     using MapRenderer::pixelToScreenCoords;
     QPointF pixelToScreenCoords(qreal x, qreal y) const override;
+
+private:
+    void drawChunkImages(QPainter *painter, const TileLayer *layer,
+                         const QRect &tileRect) const;
 };
 
 } // namespace Tiled
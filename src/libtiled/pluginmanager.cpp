@@ -35,7 +35,10 @@
 #include <QDebug>
 #include <QDir>
 #include <QDirIterator>
+#include <QFileInfo>
+#include <QJsonArray>
 #include <QPluginLoader>
+#include <QThread>
 
 namespace Tiled {
 
@@ -63,6 +66,32 @@ QString PluginFile::errorString() const
     return QString();
 }
 
+bool PluginFile::isEnabled() const
+{
+    return state == PluginEnabled || state == PluginStatic ||
+            (defaultEnable && state != PluginDisabled);
+}
+
+bool PluginFile::declaresFormats() const
+{
+    return !formats.isEmpty() || !extensions.isEmpty();
+}
+
+bool PluginFile::providesFormat(const QString &formatOrSuffix) const
+{
+    return formats.contains(formatOrSuffix, Qt::CaseInsensitive) ||
+            extensions.contains(formatOrSuffix, Qt::CaseInsensitive);
+}
+
+static QStringList toStringList(const QJsonValue &value)
+{
+    QStringList result;
+    const QJsonArray array = value.toArray();
+    for (const QJsonValue &v : array)
+        result.append(v.toString());
+    return result;
+}
+
 
 PluginManager *PluginManager::mInstance;
 
@@ -113,11 +142,7 @@ bool PluginManager::loadPlugin(PluginFile *plugin)
     plugin->instance = plugin->loader->instance();
 
     if (plugin->instance) {
-        if (Plugin *p = qobject_cast<Plugin*>(plugin->instance))
-            p->initialize();
-        else
-            addObject(plugin->instance);
-
+        initializePlugin(plugin->instance);
         return true;
     } else {
         qWarning().noquote() << "Error:" << plugin->loader->errorString();
@@ -173,15 +198,25 @@ void PluginManager::removeObject(QObject *object)
 
 void PluginManager::loadPlugins()
 {
+    scanPlugins();
+
+    for (PluginFile &plugin : mPlugins)
+        if (!plugin.instance && plugin.isEnabled())
+            loadPlugin(&plugin);
+}
+
+void PluginManager::scanPlugins()
+{
+    if (mScanned)
+        return;
+
+    mScanned = true;
+
     // Load static plugins
     const QObjectList &staticPluginInstances = QPluginLoader::staticInstances();
     for (QObject *instance : staticPluginInstances) {
         mPlugins.append(PluginFile(PluginStatic, instance));
-
-        if (Plugin *plugin = qobject_cast<Plugin*>(instance))
-            plugin->initialize();
-        else
-            addObject(instance);
+        initializePlugin(instance);
     }
 
     // Determine the plugin path based on the application location
@@ -199,7 +234,7 @@ void PluginManager::loadPlugins()
     pluginPath += QLatin1String("/../lib/tiled/plugins");
 #endif
 
-    // Load dynamic plugins
+    // Index dynamic plugins. Reading the metadata does not load the library.
     QDirIterator iterator(pluginPath, QDir::Files | QDir::Readable);
     while (iterator.hasNext()) {
         const QString &pluginFile = iterator.next();
@@ -213,27 +248,105 @@ void PluginManager::loadPlugins()
         auto metaData = loader->metaData().value(QStringLiteral("MetaData")).toObject();
         bool defaultEnable = metaData.value(QStringLiteral("defaultEnable")).toBool();
 
-        bool enable = state == PluginEnabled || (defaultEnable && state != PluginDisabled);
+        PluginFile plugin(state, nullptr, loader, defaultEnable);
+        plugin.formats = toStringList(metaData.value(QStringLiteral("formats")));
+        plugin.extensions = toStringList(metaData.value(QStringLiteral("extensions")));
 
-        QObject *instance = nullptr;
+        mPlugins.append(plugin);
+    }
+}
 
-        if (enable) {
-            instance = loader->instance();
+void PluginManager::loadPluginsProviding(const QString &formatOrSuffix)
+{
+    scanPlugins();
 
-            if (!instance)
-                qWarning().noquote() << "Error:" << loader->errorString();
-        }
+    if (!loadPluginsDeclaring(formatOrSuffix))
+        loadUndeclaringPlugins();
+}
 
-        mPlugins.append(PluginFile(state, instance, loader, defaultEnable));
+void PluginManager::loadPluginsForFile(const QString &fileName)
+{
+    scanPlugins();
+
+    // Try "tmx.gz" before "gz", like the matching of export formats
+    QString suffix = QFileInfo(fileName).completeSuffix();
+    while (!suffix.isEmpty()) {
+        if (loadPluginsDeclaring(suffix))
+            return;
+
+        const int dot = suffix.indexOf(QLatin1Char('.'));
+        if (dot == -1)
+            break;
+        suffix.remove(0, dot + 1);
+    }
 
-        if (!instance)
-            continue;
+    loadUndeclaringPlugins();
+}
+
+bool PluginManager::loadPluginsOnDemand(const QString &fileName)
+{
+    if (!mInstance || !mInstance->mLoadPluginsOnDemand)
+        return false;
+    if (QThread::currentThread() != mInstance->thread())
+        return false;
+
+    const int objectCount = mInstance->mObjects.size();
+
+    // Since formats are not necessarily recognized by their suffix, fall back
+    // to loading all remaining plugins
+    mInstance->loadPluginsForFile(fileName);
+    if (mInstance->mObjects.size() == objectCount)
+        mInstance->loadPlugins();
+
+    return mInstance->mObjects.size() != objectCount;
+}
+
+/**
+ * Loads the enabled plugins declaring support for the given format or suffix.
+ * Returns whether the format is available, either because it was already
+ * provided (which is the case for the built-in formats) or because a plugin
+ * declaring it was found.
+ */
+bool PluginManager::loadPluginsDeclaring(const QString &formatOrSuffix)
+{
+    const QString wildcard = QLatin1String("*.") + formatOrSuffix;
+    const bool available = find<FileFormat>([&] (FileFormat *format) {
+        return format->shortName().compare(formatOrSuffix, Qt::CaseInsensitive) == 0 ||
+                format->nameFilter().contains(wildcard, Qt::CaseInsensitive);
+    });
+    if (available)
+        return true;
+
+    bool found = false;
 
-        if (Plugin *plugin = qobject_cast<Plugin*>(instance))
-            plugin->initialize();
-        else
-            addObject(instance);
+    for (PluginFile &plugin : mPlugins) {
+        if (plugin.isEnabled() && plugin.providesFormat(formatOrSuffix)) {
+            if (!plugin.instance)
+                loadPlugin(&plugin);
+            found = true;
+        }
     }
+
+    return found;
+}
+
+/**
+ * Plugins that don't declare their formats (like the Python plugin, which
+ * provides formats based on scripts) may still support any format.
+ */
+void PluginManager::loadUndeclaringPlugins()
+{
+    for (PluginFile &plugin : mPlugins)
+        if (!plugin.instance && plugin.isEnabled() && !plugin.declaresFormats())
+            loadPlugin(&plugin);
+}
+
+void PluginManager::initializePlugin(QObject *instance)
+{
+    if (Plugin *plugin = qobject_cast<Plugin*>(instance))
+        plugin->initialize();
+    else
+        addObject(instance);
 }
 
 PluginFile *PluginManager::pluginByFileName(const QString &fileName)
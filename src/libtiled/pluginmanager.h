@@ -34,6 +34,7 @@
 #include <QMap>
 #include <QObject>
 #include <QString>
+#include <QStringList>
 
 #include "qtcompat_p.h"
 
@@ -67,10 +68,22 @@ struct TILEDSHARED_EXPORT PluginFile
     bool hasError() const;
     QString errorString() const;
 
+    bool isEnabled() const;
+    bool declaresFormats() const;
+    bool providesFormat(const QString &formatOrSuffix) const;
+
     PluginState state;
     QObject *instance;
     QPluginLoader *loader;
     bool defaultEnable;
+
+    /**
+     * The short names and file extensions of the formats provided by this
+     * plugin, as declared in its metadata. Used to find the plugin that
+     * needs to be loaded for a certain format without loading all plugins.
+     */
+    QStringList formats;
+    QStringList extensions;
 };
 
 
@@ -94,6 +107,41 @@ public:
      */
     void loadPlugins();
 
+    /**
+     * Scans the plugin directory for plugins and reads their metadata,
+     * without loading any of them. Static plugins are always loaded.
+     */
+    void scanPlugins();
+
+    /**
+     * Loads the enabled plugins declaring support for the format with the
+     * given short name or file extension. When no plugin declares it, the
+     * plugins that don't declare their formats are loaded instead.
+     */
+    void loadPluginsProviding(const QString &formatOrSuffix);
+
+    /**
+     * Loads the plugins needed for the given file name, based on its complete
+     * suffix (like "tmx.gz") and falling back to its last suffix.
+     */
+    void loadPluginsForFile(const QString &fileName);
+
+    /**
+     * Sets whether the remaining plugins get loaded once no loaded format
+     * supports a file. Used when only the plugins needed for the files named
+     * on the command line were loaded, since a map may still reference
+     * tilesets or templates in other formats.
+     */
+    void setLoadPluginsOnDemand(bool onDemand) { mLoadPluginsOnDemand = onDemand; }
+
+    /**
+     * Loads the remaining enabled plugins when plugins are loaded on demand
+     * and this is called from the thread of the plugin manager. Returns
+     * whether any plugin was loaded, in which case looking for a format
+     * supporting \a fileName is worth another try.
+     */
+    static bool loadPluginsOnDemand(const QString &fileName);
+
     /**
      * Returns the list of plugins found by the plugin manager.
      */
@@ -167,12 +215,17 @@ private:
     ~PluginManager();
 
     bool loadPlugin(PluginFile *plugin);
+    void initializePlugin(QObject *instance);
     bool unloadPlugin(PluginFile *plugin);
+    bool loadPluginsDeclaring(const QString &formatOrSuffix);
+    void loadUndeclaringPlugins();
 
     static PluginManager *mInstance;
 
     QList<PluginFile> mPlugins;
     QMap<QString, PluginState> mPluginStates;
+    bool mScanned = false;
+    bool mLoadPluginsOnDemand = false;
     QObjectList mObjects;
 };
 
@@ -0,0 +1,214 @@
+/*
+ * pngwriter.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "pngwriter.h"
+
+#if defined(Q_OS_WIN) && defined(Q_CC_MSVC)
+#include "QtZlib/zlib.h"
+#else
+#include <zlib.h>
+#endif
+
+#include <QCoreApplication>
+#include <QIODevice>
+#include <QImage>
+
+#include <cstring>
+
+using namespace Tiled;
+
+// The size of the IDAT chunks that are written
+static const int ChunkSize = 1 << 16;
+
+struct PngWriter::Stream
+{
+    z_stream z {};
+};
+
+static void appendUInt32(QByteArray &data, quint32 value)
+{
+    data.append(static_cast<char>(value >> 24));
+    data.append(static_cast<char>(value >> 16));
+    data.append(static_cast<char>(value >> 8));
+    data.append(static_cast<char>(value));
+}
+
+PngWriter::PngWriter(QIODevice *device)
+    : mDevice(device)
+{
+}
+
+PngWriter::~PngWriter()
+{
+    if (mStream)
+        deflateEnd(&mStream->z);
+}
+
+/**
+ * Writes the PNG signature and header for an image of the given \a size.
+ * The \a compressionLevel is passed on to zlib.
+ */
+bool PngWriter::begin(QSize size, int compressionLevel)
+{
+    Q_ASSERT(!mStream);
+
+    if (size.isEmpty()) {
+        mError = QCoreApplication::translate("PngWriter", "Invalid image size");
+        return false;
+    }
+
+    mSize = size;
+    mStream = std::make_unique<Stream>();
+
+    if (deflateInit(&mStream->z, compressionLevel) != Z_OK) {
+        mError = QCoreApplication::translate("PngWriter", "Failed to initialize compression");
+        mStream.reset();
+        return false;
+    }
+
+    static const char signature[] = { '\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n' };
+    if (mDevice->write(signature, sizeof(signature)) != sizeof(signature)) {
+        mError = mDevice->errorString();
+        return false;
+    }
+
+    QByteArray header;
+    appendUInt32(header, static_cast<quint32>(size.width()));
+    appendUInt32(header, static_cast<quint32>(size.height()));
+    header.append(char(8));     // bit depth
+    header.append(char(6));     // color type: RGBA
+    header.append(char(0));     // compression method
+    header.append(char(0));     // filter method
+    header.append(char(0));     // interlace method
+
+    return writeChunk("IHDR", header);
+}
+
+/**
+ * Appends the given \a rows to the image. The width of \a rows needs to
+ * match the width of the image.
+ */
+bool PngWriter::writeRows(const QImage &rows)
+{
+    Q_ASSERT(mStream);
+    Q_ASSERT(rows.width() == mSize.width());
+
+    if (mRowsWritten + rows.height() > mSize.height()) {
+        mError = QCoreApplication::translate("PngWriter", "Too many rows written");
+        return false;
+    }
+
+    const QImage rgba = rows.convertToFormat(QImage::Format_RGBA8888);
+    const int rowSize = mSize.width() * 4;
+
+    QByteArray row(rowSize + 1, Qt::Uninitialized);
+    row[0] = 0;     // filter type: none
+
+    for (int y = 0; y < rgba.height(); ++y) {
+        memcpy(row.data() + 1, rgba.constScanLine(y), static_cast<size_t>(rowSize));
+        if (!deflateData(row.constData(), row.size(), false))
+            return false;
+    }
+
+    mRowsWritten += rows.height();
+    return true;
+}
+
+/**
+ * Flushes the compressed data and writes the end of the image. Returns
+ * false when not all rows of the image have been written.
+ */
+bool PngWriter::finish()
+{
+    Q_ASSERT(mStream);
+
+    if (mRowsWritten != mSize.height()) {
+        mError = QCoreApplication::translate("PngWriter", "Not all rows were written");
+        return false;
+    }
+
+    if (!deflateData(nullptr, 0, true))
+        return false;
+
+    if (!mOutput.isEmpty() && !writeChunk("IDAT", mOutput))
+        return false;
+
+    mOutput.clear();
+    return writeChunk("IEND", QByteArray());
+}
+
+bool PngWriter::deflateData(const char *data, int size, bool finish)
+{
+    z_stream &z = mStream->z;
+    z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    z.avail_in = static_cast<uInt>(size);
+
+    int result;
+    do {
+        const int offset = mOutput.size();
+        mOutput.resize(ChunkSize);
+
+        z.next_out = reinterpret_cast<Bytef*>(mOutput.data() + offset);
+        z.avail_out = static_cast<uInt>(ChunkSize - offset);
+
+        result = ::deflate(&z, finish ? Z_FINISH : Z_NO_FLUSH);
+        if (result == Z_STREAM_ERROR) {
+            mError = QCoreApplication::translate("PngWriter", "Failed to compress image data");
+            return false;
+        }
+
+        mOutput.resize(ChunkSize - static_cast<int>(z.avail_out));
+
+        if (mOutput.size() == ChunkSize) {
+            if (!writeChunk("IDAT", mOutput))
+                return false;
+            mOutput.clear();
+        }
+    } while (z.avail_in > 0 || (finish && result != Z_STREAM_END));
+
+    return true;
+}
+
+bool PngWriter::writeChunk(const char *type, const QByteArray &data)
+{
+    QByteArray chunk;
+    chunk.reserve(data.size() + 12);
+    appendUInt32(chunk, static_cast<quint32>(data.size()));
+    chunk.append(type, 4);
+    chunk.append(data);
+
+    const auto typeAndData = reinterpret_cast<const Bytef*>(chunk.constData() + 4);
+    appendUInt32(chunk, static_cast<quint32>(crc32(0, typeAndData, static_cast<uInt>(data.size() + 4))));
+
+    if (mDevice->write(chunk) != chunk.size()) {
+        mError = mDevice->errorString();
+        return false;
+    }
+
+    return true;
+}
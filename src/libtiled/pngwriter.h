@@ -0,0 +1,77 @@
+/*
+ * pngwriter.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QByteArray>
+#include <QSize>
+#include <QString>
+
+#include <memory>
+
+class QIODevice;
+class QImage;
+
+namespace Tiled {
+
+/**
+ * Writes a PNG image incrementally, a band of rows at a time.
+ *
+ * Unlike QImageWriter, this does not require the whole image to be in
+ * memory, which makes it possible to write images that are too large to
+ * allocate. The image is always written as 8-bit RGBA, without filtering.
+ */
+class TILEDSHARED_EXPORT PngWriter
+{
+public:
+    explicit PngWriter(QIODevice *device);
+    ~PngWriter();
+
+    bool begin(QSize size, int compressionLevel = -1);
+    bool writeRows(const QImage &rows);
+    bool finish();
+
+    QString errorString() const { return mError; }
+
+private:
+    struct Stream;
+
+    bool deflateData(const char *data, int size, bool finish);
+    bool writeChunk(const char *type, const QByteArray &data);
+
+    QIODevice *mDevice;
+    std::unique_ptr<Stream> mStream;
+    QSize mSize;
+    int mRowsWritten = 0;
+    QByteArray mOutput;
+    QString mError;
+};
+
+} // namespace Tiled
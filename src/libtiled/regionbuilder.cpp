@@ -0,0 +1,108 @@
+/*
+ * regionbuilder.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "regionbuilder.h"
+
+#include <algorithm>
+
+namespace Tiled {
+
+/**
+ * Returns the region covered by the added spans.
+ */
+QRegion RegionBuilder::region() const
+{
+    if (mSpans.isEmpty())
+        return QRegion();
+
+    QVector<Span> spans = mSpans;
+    std::sort(spans.begin(), spans.end(), [] (const Span &a, const Span &b) {
+        if (a.y != b.y)
+            return a.y < b.y;
+        return a.left < b.left;
+    });
+
+    // Merge the spans that overlap or touch on each row
+    int count = 0;
+    for (int i = 0; i < spans.size(); ++i) {
+        const Span span = spans.at(i);
+        if (count > 0) {
+            Span &last = spans[count - 1];
+            if (last.y == span.y && span.left <= last.right + 1) {
+                last.right = std::max(last.right, span.right);
+                continue;
+            }
+        }
+        spans[count++] = span;
+    }
+
+    // Turn the rows into bands, extending the previous band downwards when
+    // a row has the same spans. This results in the rectangles being in the
+    // form expected by QRegion::setRects.
+    QVector<QRect> rects;
+    int bandStart = 0;
+    int bandBottom = 0;
+
+    for (int rowStart = 0; rowStart < count;) {
+        const int y = spans.at(rowStart).y;
+        int rowEnd = rowStart + 1;
+        while (rowEnd < count && spans.at(rowEnd).y == y)
+            ++rowEnd;
+
+        const int rowSize = rowEnd - rowStart;
+        bool sameAsBand = !rects.isEmpty() &&
+                bandBottom == y - 1 &&
+                rects.size() - bandStart == rowSize;
+
+        for (int i = 0; sameAsBand && i < rowSize; ++i) {
+            const QRect &rect = rects.at(bandStart + i);
+            const Span &span = spans.at(rowStart + i);
+            sameAsBand = rect.left() == span.left && rect.right() == span.right;
+        }
+
+        if (sameAsBand) {
+            for (int i = bandStart; i < rects.size(); ++i)
+                rects[i].setBottom(y);
+        } else {
+            bandStart = rects.size();
+            for (int i = rowStart; i < rowEnd; ++i) {
+                const Span &span = spans.at(i);
+                rects.append(QRect(QPoint(span.left, y), QPoint(span.right, y)));
+            }
+        }
+
+        bandBottom = y;
+        rowStart = rowEnd;
+    }
+
+    QRegion region;
+    region.setRects(rects.constData(), rects.size());
+    return region;
+}
+
+} // namespace Tiled
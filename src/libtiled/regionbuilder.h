@@ -0,0 +1,68 @@
+/*
+ * regionbuilder.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of libtiled.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *    1. Redistributions of source code must retain the above copyright notice,
+ *       this list of conditions and the following disclaimer.
+ *
+ *    2. Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE CONTRIBUTORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "tiled_global.h"
+
+#include <QRegion>
+#include <QVector>
+
+namespace Tiled {
+
+/**
+ * Builds a QRegion out of horizontal spans of cells.
+ *
+ * Adding many small rectangles to a QRegion one by one is slow, since each
+ * addition computes a new union. Instead, the spans are collected, sorted
+ * and merged in one go, after which the region is set from the resulting
+ * list of rectangles.
+ */
+class TILEDSHARED_EXPORT RegionBuilder
+{
+public:
+    /**
+     * Adds the cells from \a left to \a right (inclusive) on row \a y.
+     */
+    void addSpan(int y, int left, int right)
+    { mSpans.append(Span { y, left, right }); }
+
+    QRegion region() const;
+
+private:
+    struct Span
+    {
+        int y;
+        int left;
+        int right;
+    };
+
+    QVector<Span> mSpans;
+};
+
+} // namespace Tiled
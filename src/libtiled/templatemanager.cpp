@@ -51,8 +51,8 @@ TemplateManager::TemplateManager(QObject *parent)
     : QObject(parent),
       mWatcher(new FileSystemWatcher(this))
 {
-    connect(mWatcher, &FileSystemWatcher::fileChanged,
-            this, &TemplateManager::fileChanged);
+    connect(mWatcher, &FileSystemWatcher::pathsChanged,
+            this, &TemplateManager::filesChanged);
 }
 
 TemplateManager::~TemplateManager()
@@ -83,19 +83,21 @@ ObjectTemplate *TemplateManager::loadObjectTemplate(const QString &fileName, QSt
     return objectTemplate;
 }
 
-void TemplateManager::fileChanged(const QString &fileName)
+void TemplateManager::filesChanged(const QStringList &fileNames)
 {
-    ObjectTemplate *objectTemplate = findObjectTemplate(fileName);
-
-    // Most likely the file was removed.
-    if (!objectTemplate)
-        return;
-
-    auto newTemplate = readObjectTemplate(fileName);
-    if (newTemplate) {
-        objectTemplate->setObject(newTemplate->object());
-        emit objectTemplateChanged(objectTemplate);
-    } else {
-        ERROR(tr("Unable to reload template file: %1").arg(fileName));
+    for (const QString &fileName : fileNames) {
+        ObjectTemplate *objectTemplate = findObjectTemplate(fileName);
+
+        // Most likely the file was removed.
+        if (!objectTemplate)
+            continue;
+
+        auto newTemplate = readObjectTemplate(fileName);
+        if (newTemplate) {
+            objectTemplate->setObject(newTemplate->object());
+            emit objectTemplateChanged(objectTemplate);
+        } else {
+            ERROR(tr("Unable to reload template file: %1").arg(fileName));
+        }
     }
 }
@@ -58,7 +58,7 @@ private:
     TemplateManager(QObject *parent = nullptr);
     ~TemplateManager();
 
-    void fileChanged(const QString &fileName);
+    void filesChanged(const QStringList &fileNames);
 
     QHash<QString, ObjectTemplate*> mObjectTemplates;
     FileSystemWatcher *mWatcher;
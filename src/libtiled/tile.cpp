@@ -30,6 +30,12 @@
 
 #include "objectgroup.h"
 #include "tileset.h"
+#include "wangset.h"
+
+#include <QCoreApplication>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
 
 using namespace Tiled;
 
@@ -49,6 +55,7 @@ Tile::Tile(const QPixmap &image, int id, Tileset *tileset):
     mId(id),
     mTileset(tileset),
     mImage(image),
+    mImageSize(image.size()),
     mImageStatus(image.isNull() ? LoadingError : LoadingReady),
     mTerrain(-1),
     mProbability(1.0),
@@ -56,10 +63,108 @@ Tile::Tile(const QPixmap &image, int id, Tileset *tileset):
     mUnusedTime(0)
 {}
 
+/**
+ * Creates a tile with the given \a image, which is only converted to a
+ * pixmap when it is first needed. This allows tiles to be created on other
+ * threads than the GUI thread.
+ */
+Tile::Tile(const QImage &image, int id, Tileset *tileset):
+    Tile(id, tileset)
+{
+    setImage(image);
+}
+
 Tile::~Tile()
 {
 }
 
+/**
+ * Protects the images of the tiles, since tiles of shared tilesets may be
+ * rendered from multiple threads.
+ */
+static QMutex &pendingImageMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+static bool isGuiThread()
+{
+    const QCoreApplication *app = QCoreApplication::instance();
+    return app && QThread::currentThread() == app->thread();
+}
+
+/**
+ * Sets the image of this tile.
+ */
+void Tile::setImage(const QPixmap &image)
+{
+    QMutexLocker locker(&pendingImageMutex());
+
+    mImage = image;
+    mPendingImage = QImage();
+    mHasPendingImage.storeRelease(0);
+    mImageSize = image.size();
+    mImageStatus = image.isNull() ? LoadingError : LoadingReady;
+}
+
+/**
+ * Sets the image of this tile. The image is converted to a pixmap when it
+ * is first needed on the GUI thread.
+ */
+void Tile::setImage(const QImage &image)
+{
+    QMutexLocker locker(&pendingImageMutex());
+
+    mImage = QPixmap();
+    mPendingImage = image;
+    mHasPendingImage.storeRelease(image.isNull() ? 0 : 1);
+    mImageSize = image.size();
+    mImageStatus = image.isNull() ? LoadingError : LoadingReady;
+}
+
+/**
+ * Returns the image of this tile when it was set as a QImage and could not
+ * be converted to a pixmap yet, because this function was not called from
+ * the GUI thread. Otherwise a null image is returned and image() returns the
+ * pixmap.
+ *
+ * Can be called from any thread.
+ */
+QImage Tile::pendingImage() const
+{
+    if (!mHasPendingImage.loadAcquire())
+        return QImage();
+
+    if (isGuiThread())
+        convertPendingImage();
+
+    QMutexLocker locker(&pendingImageMutex());
+    return mPendingImage;
+}
+
+/**
+ * Converts the pending image to a pixmap. Does nothing when not called from
+ * the GUI thread, since pixmaps can't be created on other threads.
+ */
+void Tile::convertPendingImage() const
+{
+    const bool guiThread = isGuiThread();
+    Q_ASSERT_X(guiThread, "Tile::image()",
+               "image not converted yet, use pendingImage() off the GUI thread");
+    if (!guiThread)
+        return;
+
+    QMutexLocker locker(&pendingImageMutex());
+
+    if (!mHasPendingImage.loadAcquire())
+        return;
+
+    mImage = QPixmap::fromImage(mPendingImage);
+    mPendingImage = QImage();
+    mHasPendingImage.storeRelease(0);
+}
+
 /**
  * Returns the tileset that this tile is part of as a shared pointer.
  */
@@ -111,6 +216,19 @@ void Tile::setTerrain(unsigned terrain)
     mTileset->markTerrainDistancesDirty();
 }
 
+/**
+ * Set the relative probability of this tile appearing while painting.
+ */
+void Tile::setProbability(qreal probability)
+{
+    mProbability = probability;
+
+    // The probability affects the lookup tables of the terrains and Wang sets
+    mTileset->markTerrainIndexDirty();
+    for (WangSet *wangSet : mTileset->wangSets())
+        wangSet->clearMatchCache();
+}
+
 /**
  * Sets \a objectGroup to be the group of objects associated with this tile.
  * The Tile takes ownership over the ObjectGroup and it can't also be part of
@@ -193,7 +311,9 @@ bool Tile::advanceAnimation(int ms)
  */
 Tile *Tile::clone(Tileset *tileset) const
 {
-    Tile *c = new Tile(mImage, mId, tileset);
+    const QImage pending = pendingImage();
+    Tile *c = pending.isNull() ? new Tile(image(), mId, tileset)
+                               : new Tile(pending, mId, tileset);
     c->setProperties(properties());
 
     c->mImageSource = mImageSource;
@@ -32,6 +32,8 @@
 #include "object.h"
 #include "tiled.h"
 
+#include <QAtomicInt>
+#include <QImage>
 #include <QPixmap>
 #include <QSharedPointer>
 #include <QUrl>
@@ -99,6 +101,7 @@ class TILEDSHARED_EXPORT Tile : public Object
 public:
     Tile(int id, Tileset *tileset);
     Tile(const QPixmap &image, int id, Tileset *tileset);
+    Tile(const QImage &image, int id, Tileset *tileset);
 
     ~Tile();
 
@@ -108,7 +111,9 @@ public:
     QSharedPointer<Tileset> sharedTileset() const;
 
     const QPixmap &image() const;
+    QImage pendingImage() const;
     void setImage(const QPixmap &image);
+    void setImage(const QImage &image);
 
     const Tile *currentFrameTile() const;
 
@@ -152,9 +157,14 @@ public:
     Tile *clone(Tileset *tileset) const;
 
 private:
+    void convertPendingImage() const;
+
     int mId;
     Tileset *mTileset;
-    QPixmap mImage;
+    mutable QPixmap mImage;
+    mutable QImage mPendingImage;
+    mutable QAtomicInt mHasPendingImage;
+    QSize mImageSize;
     QUrl mImageSource;
     LoadingStatus mImageStatus;
     QString mType;
@@ -187,21 +197,22 @@ inline Tileset *Tile::tileset() const
 
 /**
  * Returns the image of this tile.
+ *
+ * When the image was set as a QImage, it is converted to a pixmap on the
+ * first call from the GUI thread. Since pixmaps can only be created on the
+ * GUI thread, other threads get a null pixmap until then.
+ *
+ * \warning Code that may run on other threads than the GUI thread needs to
+ *          call pendingImage() first, and only use this function when that
+ *          returns a null image. Debug builds assert this.
  */
 inline const QPixmap &Tile::image() const
 {
+    if (Q_UNLIKELY(mHasPendingImage.loadAcquire()))
+        convertPendingImage();
     return mImage;
 }
 
-/**
- * Sets the image of this tile.
- */
-inline void Tile::setImage(const QPixmap &image)
-{
-    mImage = image;
-    mImageStatus = image.isNull() ? LoadingError : LoadingReady;
-}
-
 /**
  * Returns the URL of the external image that represents this tile.
  * When this tile doesn't refer to an external image, an empty URL is
@@ -222,7 +233,7 @@ inline void Tile::setImageSource(const QUrl &imageSource)
  */
 inline int Tile::width() const
 {
-    return mImage.width();
+    return mImageSize.width();
 }
 
 /**
@@ -230,7 +241,7 @@ inline int Tile::width() const
  */
 inline int Tile::height() const
 {
-    return mImage.height();
+    return mImageSize.height();
 }
 
 /**
@@ -238,7 +249,7 @@ inline int Tile::height() const
  */
 inline QSize Tile::size() const
 {
-    return mImage.size();
+    return mImageSize;
 }
 
 /**
@@ -292,14 +303,6 @@ inline qreal Tile::probability() const
     return mProbability;
 }
 
-/**
- * Set the relative probability of this tile appearing while painting.
- */
-inline void Tile::setProbability(qreal probability)
-{
-    mProbability = probability;
-}
-
 /**
  * @return The group of objects associated with this tile. This is generally
  *         expected to be used for editing collision shapes.
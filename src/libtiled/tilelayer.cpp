@@ -31,80 +31,172 @@
 
 #include "tile.h"
 #include "hex.h"
+#include "logginginterface.h"
 
 #include <algorithm>
+#include <atomic>
 #include <memory>
 
+#include <QCoreApplication>
 #include <QSet>
 
 using namespace Tiled;
 
 Cell Cell::empty;
 
-QRegion Chunk::region(std::function<bool (const Cell &)> condition) const
+/**
+ * Returns the region of the cells in this chunk that are not empty.
+ */
+QRegion Chunk::region() const
 {
-    QRegion region;
+    RegionBuilder builder;
+    addToRegion(builder, QPoint());
+    return builder.region();
+}
 
+/**
+ * Adds the spans of non-empty cells in this chunk to \a builder, offset
+ * by \a offset. The spans are found by scanning the occupancy bitmap.
+ */
+void Chunk::addToRegion(RegionBuilder &builder, QPoint offset) const
+{
     for (int y = 0; y < CHUNK_SIZE; ++y) {
-        for (int x = 0; x < CHUNK_SIZE; ++x) {
-            if (condition(cellAt(x, y))) {
-                const int rangeStart = x;
-                for (++x; x <= CHUNK_SIZE; ++x) {
-                    if (x == CHUNK_SIZE || !condition(cellAt(x, y))) {
-                        const int rangeEnd = x;
-                        region += QRect(rangeStart, y, rangeEnd - rangeStart, 1);
-                        break;
-                    }
-                }
+        unsigned bits = mOccupied[y];
+        int x = 0;
+
+        while (bits) {
+            // Skip the empty cells, then find the end of the occupied span
+            while (!(bits & 1)) {
+                bits >>= 1;
+                ++x;
             }
+
+            const int rangeStart = x;
+            while (bits & 1) {
+                bits >>= 1;
+                ++x;
+            }
+
+            builder.addSpan(offset.y() + y, offset.x() + rangeStart, offset.x() + x - 1);
         }
     }
-
-    return region;
 }
 
 void Chunk::setCell(int x, int y, const Cell &cell)
 {
+    if (mGrid.isEmpty()) {
+        if (cell == Cell::empty && !cell.checked())
+            return;
+        mGrid.resize(CHUNK_SIZE * CHUNK_SIZE);
+    }
+
     int index = x + y * CHUNK_SIZE;
 
-    mGrid[index] = cell;
-}
+    Tileset *oldTileset = mGrid.at(index).tileset();
+    Tileset *newTileset = cell.tileset();
 
-bool Chunk::isEmpty() const
-{
-    for (int y = 0; y < CHUNK_SIZE; ++y) {
-        for (int x = 0; x < CHUNK_SIZE; ++x) {
-            if (!cellAt(x, y).isEmpty())
-                return false;
-        }
+    if (oldTileset != newTileset) {
+        if (oldTileset)
+            removeTilesetReference(oldTileset);
+        if (newTileset)
+            addTilesetReference(newTileset);
     }
 
-    return true;
+    if (newTileset)
+        mOccupied[y] |= 1 << x;
+    else
+        mOccupied[y] &= ~(1 << x);
+
+    mGrid[index] = cell;
+    touch();
 }
 
-bool Chunk::hasCell(std::function<bool (const Cell &)> condition) const
+/**
+ * Returns the tilesets referred to by the cells of this chunk.
+ */
+QVector<Tileset*> Chunk::usedTilesets() const
 {
-    for (const Cell &cell : mGrid)
-        if (condition(cell))
-            return true;
-
-    return false;
+    QVector<Tileset*> tilesets;
+    tilesets.reserve(mTilesetCounts.size());
+    for (const TilesetCount &tilesetCount : mTilesetCounts)
+        tilesets.append(tilesetCount.tileset);
+    return tilesets;
 }
 
 void Chunk::removeReferencesToTileset(Tileset *tileset)
 {
+    auto it = std::find_if(mTilesetCounts.begin(), mTilesetCounts.end(),
+                           [=] (const TilesetCount &tilesetCount) { return tilesetCount.tileset == tileset; });
+    if (it == mTilesetCounts.end())
+        return;
+
+    mTilesetCounts.erase(it);
+
     for (int i = 0, i_end = mGrid.size(); i < i_end; ++i) {
-        if (mGrid.at(i).tileset() == tileset)
+        if (mGrid.at(i).tileset() == tileset) {
             mGrid.replace(i, Cell::empty);
+            mOccupied[i / CHUNK_SIZE] &= ~(1 << (i & CHUNK_MASK));
+        }
     }
+
+    touch();
 }
 
 void Chunk::replaceReferencesToTileset(Tileset *oldTileset, Tileset *newTileset)
 {
+    if (oldTileset == newTileset)
+        return;
+
+    auto it = std::find_if(mTilesetCounts.begin(), mTilesetCounts.end(),
+                           [=] (const TilesetCount &tilesetCount) { return tilesetCount.tileset == oldTileset; });
+    if (it == mTilesetCounts.end())
+        return;
+
+    const int count = it->count;
+    mTilesetCounts.erase(it);
+
+    auto newIt = std::find_if(mTilesetCounts.begin(), mTilesetCounts.end(),
+                              [=] (const TilesetCount &tilesetCount) { return tilesetCount.tileset == newTileset; });
+    if (newIt != mTilesetCounts.end())
+        newIt->count += count;
+    else
+        mTilesetCounts.append(TilesetCount { newTileset, count });
+
     for (Cell &cell : mGrid) {
         if (cell.tileset() == oldTileset)
             cell.setTile(newTileset, cell.tileId());
     }
+
+    touch();
+}
+
+quint64 Chunk::nextRevision()
+{
+    static std::atomic<quint64> revision { 0 };
+    return revision.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void Chunk::addTilesetReference(Tileset *tileset)
+{
+    for (TilesetCount &tilesetCount : mTilesetCounts) {
+        if (tilesetCount.tileset == tileset) {
+            ++tilesetCount.count;
+            return;
+        }
+    }
+
+    mTilesetCounts.append(TilesetCount { tileset, 1 });
+}
+
+void Chunk::removeTilesetReference(Tileset *tileset)
+{
+    for (int i = 0; i < mTilesetCounts.size(); ++i) {
+        if (mTilesetCounts.at(i).tileset == tileset) {
+            if (--mTilesetCounts[i].count == 0)
+                mTilesetCounts.remove(i);
+            return;
+        }
+    }
 }
 
 TileLayer::TileLayer(const QString &name, int x, int y, int width, int height)
@@ -147,25 +239,43 @@ static QMargins computeDrawMargins(const QSet<SharedTileset> &tilesets)
 
 QMargins TileLayer::drawMargins() const
 {
-    return computeDrawMargins(usedTilesets());
+    if (mEncodedChunks.isEmpty())
+        return computeDrawMargins(usedTilesets());
+
+    // Avoid decoding all chunks by assuming the encoded ones may use any of
+    // the tilesets known to their decoder.
+    updateUsedTilesets();
+
+    QSet<SharedTileset> tilesets = mUsedTilesets;
+    QSet<const ChunkDecoder*> decoders;
+
+    for (const EncodedChunk &encodedChunk : qAsConst(mEncodedChunks)) {
+        const ChunkDecoder *decoder = encodedChunk.decoder.data();
+        if (!decoders.contains(decoder)) {
+            decoders.insert(decoder);
+            tilesets.unite(decoder->tilesets());
+        }
+    }
+
+    return computeDrawMargins(tilesets);
 }
 
 /**
- * Calculates the region of cells in this tile layer for which the given
- * \a condition returns true.
+ * Calculates the region occupied by the tiles of this layer. Similar to
+ * Layer::bounds(), but leaves out the regions without tiles.
  */
-QRegion TileLayer::region(std::function<bool (const Cell &)> condition) const
+QRegion TileLayer::region() const
 {
-    QRegion region;
+    decodeAllChunks();
 
-    QHashIterator<QPoint, Chunk> it(mChunks);
-    while (it.hasNext()) {
-        it.next();
-        region += it.value().region(condition).translated(it.key().x() * CHUNK_SIZE + mX,
-                                                          it.key().y() * CHUNK_SIZE + mY);
+    RegionBuilder builder;
+
+    for (auto it = mChunks.cbegin(), it_end = mChunks.cend(); it != it_end; ++it) {
+        it.value().addToRegion(builder, QPoint(it.key().x() * CHUNK_SIZE + mX,
+                                               it.key().y() * CHUNK_SIZE + mY));
     }
 
-    return region;
+    return builder.region();
 }
 
 /**
@@ -197,6 +307,16 @@ void Tiled::TileLayer::setCell(int x, int y, const Cell &cell)
         }
     }
 
+    if (mTileIndexValid) {
+        const Cell &oldCell = _chunk.cellAt(x & CHUNK_MASK, y & CHUNK_MASK);
+        if (oldCell.tileset() != cell.tileset() || oldCell.tileId() != cell.tileId()) {
+            const QPoint chunkCoordinates((x - (x & CHUNK_MASK)) / CHUNK_SIZE,
+                                          (y - (y & CHUNK_MASK)) / CHUNK_SIZE);
+            removeFromTileIndex(oldCell, chunkCoordinates);
+            addToTileIndex(cell, chunkCoordinates);
+        }
+    }
+
     _chunk.setCell(x & CHUNK_MASK, y & CHUNK_MASK, cell);
 }
 
@@ -211,16 +331,12 @@ std::unique_ptr<TileLayer> TileLayer::copy(const QRegion &region) const
 
 #if QT_VERSION < 0x050800
     const auto rects = regionWithContents.rects();
-    for (const QRect &rect : rects) {
+    for (const QRect &rect : rects)
 #else
-    for (const QRect &rect : regionWithContents) {
+    for (const QRect &rect : regionWithContents)
 #endif
-        for (int x = rect.left(); x <= rect.right(); ++x)
-            for (int y = rect.top(); y <= rect.bottom(); ++y)
-                copied->setCell(x - regionBounds.x(),
-                                y - regionBounds.y(),
-                                cellAt(x, y));
-    }
+        copied->copyCells(*this, -regionBounds.topLeft(),
+                          rect.translated(-regionBounds.topLeft()));
 
     return copied;
 }
@@ -250,9 +366,7 @@ void TileLayer::setCells(int x, int y, const TileLayer *layer,
 #else
     for (const QRect &rect : area)
 #endif
-        for (int _x = rect.left(); _x <= rect.right(); ++_x)
-            for (int _y = rect.top(); _y <= rect.bottom(); ++_y)
-                setCell(_x, _y, layer->cellAt(_x - x, _y - y));
+        copyCells(*layer, QPoint(x, y), rect);
 }
 
 /**
@@ -285,13 +399,109 @@ void TileLayer::erase(const QRegion &region)
 
 #if QT_VERSION < 0x050800
     const auto rects = regionWithContents.rects();
-    for (const QRect &rect : rects)
+    for (const QRect &rect : rects) {
 #else
-    for (const QRect &rect : regionWithContents)
+    for (const QRect &rect : regionWithContents) {
 #endif
-        for (int x = rect.left(); x <= rect.right(); ++x)
-            for (int y = rect.top(); y <= rect.bottom(); ++y)
-                setCell(x, y, Cell::empty);
+        const int startX = rect.left() - (rect.left() & CHUNK_MASK);
+        const int startY = rect.top() - (rect.top() & CHUNK_MASK);
+
+        for (int chunkY = startY; chunkY <= rect.bottom(); chunkY += CHUNK_SIZE) {
+            for (int chunkX = startX; chunkX <= rect.right(); chunkX += CHUNK_SIZE) {
+                if (!findChunk(chunkX, chunkY))
+                    continue;
+
+                const QRect chunkRect(chunkX, chunkY, CHUNK_SIZE, CHUNK_SIZE);
+                const QRect block = chunkRect & rect;
+
+                if (block != chunkRect) {
+                    for (int y = block.top(); y <= block.bottom(); ++y)
+                        for (int x = block.left(); x <= block.right(); ++x)
+                            setCell(x, y, Cell::empty);
+
+                    if (!findChunk(chunkX, chunkY)->isEmpty())
+                        continue;
+                }
+
+                // Release chunks that no longer contain any tiles
+                setChunk(QPoint(chunkX / CHUNK_SIZE, chunkY / CHUNK_SIZE), nullptr);
+            }
+        }
+    }
+}
+
+/**
+ * Replaces the chunk at \a chunkCoordinates with a shared copy of \a chunk.
+ * The chunk is removed when \a chunk is nullptr or empty.
+ */
+void TileLayer::setChunk(QPoint chunkCoordinates, const Chunk *chunk)
+{
+    mEncodedChunks.remove(chunkCoordinates);
+    mCorruptChunks.remove(chunkCoordinates);
+
+    if (mTileIndexValid) {
+        auto it = mChunks.constFind(chunkCoordinates);
+        if (it != mChunks.constEnd())
+            for (const Cell &cell : it.value())
+                removeFromTileIndex(cell, chunkCoordinates);
+
+        if (chunk)
+            for (const Cell &cell : *chunk)
+                addToTileIndex(cell, chunkCoordinates);
+    }
+
+    if (chunk && !chunk->isEmpty()) {
+        mChunks.insert(chunkCoordinates, *chunk);
+        mBounds = mBounds.united(QRect(chunkCoordinates.x() * CHUNK_SIZE,
+                                       chunkCoordinates.y() * CHUNK_SIZE,
+                                       CHUNK_SIZE, CHUNK_SIZE));
+    } else {
+        mChunks.remove(chunkCoordinates);
+    }
+
+    mUsedTilesetsDirty = true;
+}
+
+/**
+ * Sets the cells within \a rect to the cells of \a layer, which are offset
+ * by \a offset.
+ *
+ * When the offset is aligned to the chunk size, whole chunks covered by
+ * \a rect are shared with \a layer instead of being copied cell by cell.
+ */
+void TileLayer::copyCells(const TileLayer &layer, QPoint offset, QRect rect)
+{
+    const bool aligned = !(offset.x() & CHUNK_MASK) && !(offset.y() & CHUNK_MASK);
+
+    const int startX = rect.left() - (rect.left() & CHUNK_MASK);
+    const int startY = rect.top() - (rect.top() & CHUNK_MASK);
+
+    for (int chunkY = startY; chunkY <= rect.bottom(); chunkY += CHUNK_SIZE) {
+        for (int chunkX = startX; chunkX <= rect.right(); chunkX += CHUNK_SIZE) {
+            const QRect chunkRect(chunkX, chunkY, CHUNK_SIZE, CHUNK_SIZE);
+            const QRect block = chunkRect & rect;
+            const QRect sourceBlock = block.translated(-offset);
+
+            if (aligned && block == chunkRect) {
+                setChunk(QPoint(chunkX / CHUNK_SIZE, chunkY / CHUNK_SIZE),
+                         layer.findChunk(sourceBlock.x(), sourceBlock.y()));
+                continue;
+            }
+
+            // Nothing to do when both source and destination are empty
+            if (!findChunk(chunkX, chunkY) &&
+                    !layer.findChunk(sourceBlock.left(), sourceBlock.top()) &&
+                    !layer.findChunk(sourceBlock.right(), sourceBlock.top()) &&
+                    !layer.findChunk(sourceBlock.left(), sourceBlock.bottom()) &&
+                    !layer.findChunk(sourceBlock.right(), sourceBlock.bottom())) {
+                continue;
+            }
+
+            for (int y = block.top(); y <= block.bottom(); ++y)
+                for (int x = block.left(); x <= block.right(); ++x)
+                    setCell(x, y, layer.cellAt(x - offset.x(), y - offset.y()));
+        }
+    }
 }
 
 /**
@@ -300,13 +510,18 @@ void TileLayer::erase(const QRegion &region)
 void TileLayer::clear()
 {
     mChunks.clear();
+    mEncodedChunks.clear();
+    mCorruptChunks.clear();
     mBounds = QRect();
     mUsedTilesets.clear();
     mUsedTilesetsDirty = false;
+    invalidateTileIndex();
 }
 
 void TileLayer::flip(FlipDirection direction)
 {
+    decodeAllChunks();
+
     const auto newLayer = std::make_unique<TileLayer>(QString(), 0, 0, mWidth, mHeight);
 
     Q_ASSERT(direction == FlipHorizontally || direction == FlipVertically);
@@ -336,11 +551,15 @@ void TileLayer::flip(FlipDirection direction)
     }
 
     mChunks = newLayer->mChunks;
+    mCorruptChunks.clear();
+    invalidateTileIndex();
     mBounds = newLayer->mBounds;
 }
 
 void TileLayer::flipHexagonal(FlipDirection direction)
 {
+    decodeAllChunks();
+
     const auto newLayer = std::make_unique<TileLayer>(QString(), 0, 0, mWidth, mHeight);
 
     Q_ASSERT(direction == FlipHorizontally || direction == FlipVertically);
@@ -386,11 +605,15 @@ void TileLayer::flipHexagonal(FlipDirection direction)
     }
 
     mChunks = newLayer->mChunks;
+    mCorruptChunks.clear();
+    invalidateTileIndex();
     mBounds = newLayer->mBounds;
 }
 
 void TileLayer::rotate(RotateDirection direction)
 {
+    decodeAllChunks();
+
     static const unsigned char rotateRightMask[8] = { 5, 4, 1, 0, 7, 6, 3, 2 };
     static const unsigned char rotateLeftMask[8]  = { 3, 2, 7, 6, 1, 0, 5, 4 };
 
@@ -436,11 +659,15 @@ void TileLayer::rotate(RotateDirection direction)
     mWidth = newWidth;
     mHeight = newHeight;
     mChunks = newLayer->mChunks;
+    mCorruptChunks.clear();
+    invalidateTileIndex();
     mBounds = newLayer->mBounds;
 }
 
 void TileLayer::rotateHexagonal(RotateDirection direction, Map *map)
 {
+    decodeAllChunks();
+
     Map::StaggerIndex staggerIndex = map->staggerIndex();
     Map::StaggerAxis staggerAxis = map->staggerAxis();
 
@@ -525,6 +752,8 @@ void TileLayer::rotateHexagonal(RotateDirection direction, Map *map)
     mWidth = newWidth;
     mHeight = newHeight;
     mChunks = newLayer->mChunks;
+    mCorruptChunks.clear();
+    invalidateTileIndex();
     mBounds = newLayer->mBounds;
 
     QRect filledRect = region().boundingRect();
@@ -542,54 +771,178 @@ void TileLayer::rotateHexagonal(RotateDirection direction, Map *map)
 
 
 QSet<SharedTileset> TileLayer::usedTilesets() const
+{
+    decodeAllChunks();
+    updateUsedTilesets();
+    return mUsedTilesets;
+}
+
+/**
+ * Updates the set of used tilesets based on the decoded chunks.
+ */
+void TileLayer::updateUsedTilesets() const
 {
     if (mUsedTilesetsDirty) {
         QSet<SharedTileset> tilesets;
 
         for (const Chunk &chunk : mChunks) {
-            for (const Cell &cell : chunk)
-                if (const Tile *tile = cell.tile())
-                    tilesets.insert(tile->sharedTileset());
+            const auto chunkTilesets = chunk.usedTilesets();
+            for (Tileset *tileset : chunkTilesets)
+                tilesets.insert(tileset->sharedPointer());
         }
 
         mUsedTilesets.swap(tilesets);
         mUsedTilesetsDirty = false;
     }
+}
 
-    return mUsedTilesets;
+bool TileLayer::referencesTileset(const Tileset *tileset) const
+{
+    return usedTilesets().contains(tileset->sharedPointer());
 }
 
-bool TileLayer::hasCell(std::function<bool (const Cell &)> condition) const
+/**
+ * Returns the region of the cells matching \a condition, looking only at the
+ * chunks that the tile index lists for the given tile.
+ */
+template<typename Condition>
+QRegion TileLayer::indexedRegion(Tileset *tileset, int tileId, Condition condition) const
 {
-    for (const Chunk &chunk : mChunks) {
-        if (chunk.hasCell(condition))
-            return true;
+    updateTileIndex();
+
+    const auto chunks = mTileIndex.value(qMakePair(tileset, tileId));
+    RegionBuilder builder;
+
+    for (auto it = chunks.cbegin(), it_end = chunks.cend(); it != it_end; ++it) {
+        const Chunk chunk = mChunks.value(it.key());
+        const int startX = it.key().x() * CHUNK_SIZE + mX;
+        const int startY = it.key().y() * CHUNK_SIZE + mY;
+
+        for (int y = 0; y < CHUNK_SIZE; ++y) {
+            for (int x = 0; x < CHUNK_SIZE; ++x) {
+                if (condition(chunk.cellAt(x, y))) {
+                    const int rangeStart = x;
+                    while (x + 1 < CHUNK_SIZE && condition(chunk.cellAt(x + 1, y)))
+                        ++x;
+                    builder.addSpan(startY + y, startX + rangeStart, startX + x);
+                }
+            }
+        }
     }
 
-    return false;
+    return builder.region();
 }
 
-bool TileLayer::referencesTileset(const Tileset *tileset) const
+/**
+ * Returns the region of the cells in this tile layer that are equal to
+ * \a cell, including their flags.
+ *
+ * Uses the tile index to only look at the chunks that refer to the tile.
+ */
+QRegion TileLayer::regionOf(const Cell &cell) const
 {
-    return usedTilesets().contains(tileset->sharedPointer());
+    if (cell.isEmpty())
+        return region([&] (const Cell &c) { return c == cell; });
+
+    return indexedRegion(cell.tileset(), cell.tileId(),
+                         [&] (const Cell &c) { return c == cell; });
+}
+
+/**
+ * Returns the region of the cells in this tile layer that refer to \a tile,
+ * regardless of their flags.
+ *
+ * Uses the tile index to only look at the chunks that refer to the tile.
+ */
+QRegion TileLayer::regionOf(const Tile *tile) const
+{
+    return indexedRegion(tile->tileset(), tile->id(),
+                         [=] (const Cell &c) { return c.refersTile(tile); });
+}
+
+/**
+ * Returns whether any cell in this tile layer refers to \a tile.
+ */
+bool TileLayer::referencesTile(const Tile *tile) const
+{
+    updateTileIndex();
+    return mTileIndex.contains(qMakePair(tile->tileset(), tile->id()));
 }
 
 void TileLayer::removeReferencesToTileset(Tileset *tileset)
 {
+    decodeAllChunks();
+
     for (Chunk &chunk : mChunks)
         chunk.removeReferencesToTileset(tileset);
 
     mUsedTilesets.remove(tileset->sharedPointer());
+    invalidateTileIndex();
 }
 
 void TileLayer::replaceReferencesToTileset(Tileset *oldTileset,
                                            Tileset *newTileset)
 {
+    decodeAllChunks();
+
     for (Chunk &chunk : mChunks)
         chunk.replaceReferencesToTileset(oldTileset, newTileset);
 
     if (mUsedTilesets.remove(oldTileset->sharedPointer()))
         mUsedTilesets.insert(newTileset->sharedPointer());
+    invalidateTileIndex();
+}
+
+/**
+ * Builds the tile index when it is not valid. Once built, it is kept up to
+ * date by setCell() and setChunk(), while operations that replace many
+ * cells at once invalidate it.
+ */
+void TileLayer::updateTileIndex() const
+{
+    decodeAllChunks();
+
+    if (mTileIndexValid)
+        return;
+
+    mTileIndex.clear();
+    mTileIndexValid = true;
+
+    for (auto it = mChunks.cbegin(), it_end = mChunks.cend(); it != it_end; ++it)
+        for (const Cell &cell : it.value())
+            addToTileIndex(cell, it.key());
+}
+
+void TileLayer::invalidateTileIndex()
+{
+    mTileIndex.clear();
+    mTileIndexValid = false;
+}
+
+void TileLayer::addToTileIndex(const Cell &cell, QPoint chunkCoordinates) const
+{
+    if (!cell.isEmpty())
+        ++mTileIndex[qMakePair(cell.tileset(), cell.tileId())][chunkCoordinates];
+}
+
+void TileLayer::removeFromTileIndex(const Cell &cell, QPoint chunkCoordinates) const
+{
+    if (cell.isEmpty())
+        return;
+
+    auto it = mTileIndex.find(qMakePair(cell.tileset(), cell.tileId()));
+    if (it == mTileIndex.end())
+        return;
+
+    auto chunkIt = it.value().find(chunkCoordinates);
+    if (chunkIt == it.value().end())
+        return;
+
+    if (--chunkIt.value() == 0) {
+        it.value().erase(chunkIt);
+        if (it.value().isEmpty())
+            mTileIndex.erase(it);
+    }
 }
 
 void TileLayer::resize(QSize size, QPoint offset)
@@ -597,15 +950,17 @@ void TileLayer::resize(QSize size, QPoint offset)
     if (this->size() == size && offset.isNull())
         return;
 
+    decodeAllChunks();
+
     const auto newLayer = std::make_unique<TileLayer>(QString(), 0, 0, size.width(), size.height());
 
     // Copy over the preserved part
     QRect area = mBounds.translated(offset).intersected(newLayer->rect());
-    for (int y = area.top(); y <= area.bottom(); ++y)
-        for (int x = area.left(); x <= area.right(); ++x)
-            newLayer->setCell(x, y, cellAt(x - offset.x(), y - offset.y()));
+    newLayer->copyCells(*this, offset, area);
 
     mChunks = newLayer->mChunks;
+    mCorruptChunks.clear();
+    invalidateTileIndex();
     mBounds = newLayer->mBounds;
     setSize(size);
 }
@@ -624,6 +979,8 @@ void TileLayer::offsetTiles(QPoint offset,
     if (offset.isNull())
         return;
 
+    decodeAllChunks();
+
     const std::unique_ptr<TileLayer> newLayer(clone());
 
     for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
@@ -649,12 +1006,17 @@ void TileLayer::offsetTiles(QPoint offset,
     }
 
     mChunks = newLayer->mChunks;
+    mCorruptChunks.clear();
+    invalidateTileIndex();
     mBounds = newLayer->mBounds;
 }
 
 void TileLayer::offsetTiles(QPoint offset)
 {
+    decodeAllChunks();
+
     const auto newLayer = std::make_unique<TileLayer>(QString(), 0, 0, 0, 0);
+    const bool aligned = !(offset.x() & CHUNK_MASK) && !(offset.y() & CHUNK_MASK);
 
     // Process only the allocated chunks
     QHashIterator<QPoint, Chunk> it(mChunks);
@@ -663,6 +1025,15 @@ void TileLayer::offsetTiles(QPoint offset)
 
         const QPoint p = it.key();
         const Chunk &chunk = it.value();
+        if (chunk.isNull())
+            continue;
+
+        // Chunks moved by a multiple of the chunk size can be shared
+        if (aligned) {
+            newLayer->setChunk(p + offset / CHUNK_SIZE, &chunk);
+            continue;
+        }
+
         const QRect r(p.x() * CHUNK_SIZE,
                       p.y() * CHUNK_SIZE,
                       CHUNK_SIZE, CHUNK_SIZE);
@@ -677,6 +1048,8 @@ void TileLayer::offsetTiles(QPoint offset)
     }
 
     mChunks = newLayer->mChunks;
+    mCorruptChunks.clear();
+    invalidateTileIndex();
     mBounds = newLayer->mBounds;
 }
 
@@ -701,37 +1074,84 @@ Layer *TileLayer::mergedWith(const Layer *other) const
 
 QRegion TileLayer::computeDiffRegion(const TileLayer *other) const
 {
-    QRegion ret;
+    RegionBuilder builder;
 
     const int dx = other->x() - mX;
     const int dy = other->y() - mY;
+    const bool aligned = !(dx & CHUNK_MASK) && !(dy & CHUNK_MASK);
 
     const QRect r = bounds().united(other->bounds()).translated(-position());
 
-    for (int y = r.top(); y <= r.bottom(); ++y) {
-        for (int x = r.left(); x <= r.right(); ++x) {
-            if (cellAt(x, y) != other->cellAt(x - dx, y - dy)) {
-                const int rangeStart = x;
-                while (x <= r.right() &&
-                       cellAt(x, y) != other->cellAt(x - dx, y - dy)) {
-                    ++x;
+    const int startX = r.left() - (r.left() & CHUNK_MASK);
+    const int startY = r.top() - (r.top() & CHUNK_MASK);
+
+    auto isEmptyChunk = [] (const Chunk *chunk) { return !chunk || chunk->isEmpty(); };
+
+    for (int chunkY = startY; chunkY <= r.bottom(); chunkY += CHUNK_SIZE) {
+        for (int chunkX = startX; chunkX <= r.right(); chunkX += CHUNK_SIZE) {
+            const QRect block = QRect(chunkX, chunkY, CHUNK_SIZE, CHUNK_SIZE) & r;
+            const QRect otherBlock = block.translated(-dx, -dy);
+            const Chunk *chunk = findChunk(chunkX, chunkY);
+
+            // Skip blocks that are empty on both layers
+            if (isEmptyChunk(chunk) &&
+                    isEmptyChunk(other->findChunk(otherBlock.left(), otherBlock.top())) &&
+                    isEmptyChunk(other->findChunk(otherBlock.right(), otherBlock.top())) &&
+                    isEmptyChunk(other->findChunk(otherBlock.left(), otherBlock.bottom())) &&
+                    isEmptyChunk(other->findChunk(otherBlock.right(), otherBlock.bottom()))) {
+                continue;
+            }
+
+            // Skip chunks that are still shared between the layers
+            if (aligned && chunk) {
+                const Chunk *otherChunk = other->findChunk(otherBlock.left(), otherBlock.top());
+                if (otherChunk && chunk->sharesCellsWith(*otherChunk))
+                    continue;
+            }
+
+            for (int y = block.top(); y <= block.bottom(); ++y) {
+                for (int x = block.left(); x <= block.right(); ++x) {
+                    if (cellAt(x, y) != other->cellAt(x - dx, y - dy)) {
+                        const int rangeStart = x;
+                        while (x < block.right() &&
+                               cellAt(x + 1, y) != other->cellAt(x + 1 - dx, y - dy)) {
+                            ++x;
+                        }
+                        builder.addSpan(y, rangeStart, x);
+                    }
                 }
-                const int rangeEnd = x;
-                ret += QRect(rangeStart, y, rangeEnd - rangeStart, 1);
             }
         }
     }
 
-    return ret;
+    return builder.region();
 }
 
 bool TileLayer::isEmpty() const
 {
+    // Check the decoded chunks first, which may avoid decoding the rest
     for (const Chunk &chunk : mChunks)
         if (!chunk.isEmpty())
             return false;
 
-    return true;
+    if (mEncodedChunks.isEmpty())
+        return true;
+
+    decodeAllChunks();
+    return isEmpty();
+}
+
+/**
+ * Returns the number of decoded chunks whose cells are not shared with a
+ * copy of this layer, which is a measure of the memory owned by this layer.
+ */
+int TileLayer::unsharedChunkCount() const
+{
+    int count = 0;
+    for (const Chunk &chunk : mChunks)
+        if (!chunk.isNull() && !chunk.isShared())
+            ++count;
+    return count;
 }
 
 static bool compareRectPos(const QRect &a, const QRect &b)
@@ -756,8 +1176,21 @@ QVector<QRect> TileLayer::sortedChunksToWrite(QSize chunkSize) const
     bool isNativeChunkSize = (chunkSize.width() == CHUNK_SIZE &&
                               chunkSize.height() == CHUNK_SIZE);
 
-    if (isNativeChunkSize)
-        chunksToWrite.reserve(mChunks.size());
+    if (isNativeChunkSize) {
+        chunksToWrite.reserve(mChunks.size() + mEncodedChunks.size() + mCorruptChunks.size());
+
+        // Chunks that were never decoded can be written as-is, as well as
+        // chunks that failed to decode and were not changed since
+        for (auto chunks : { &mEncodedChunks, &mCorruptChunks }) {
+            for (auto it = chunks->cbegin(); it != chunks->cend(); ++it) {
+                chunksToWrite.append(QRect(it.key().x() * CHUNK_SIZE,
+                                           it.key().y() * CHUNK_SIZE,
+                                           CHUNK_SIZE, CHUNK_SIZE));
+            }
+        }
+    } else {
+        decodeAllChunks();
+    }
 
     QHashIterator<QPoint, Chunk> it(mChunks);
     while (it.hasNext()) {
@@ -822,6 +1255,114 @@ QVector<QRect> TileLayer::sortedChunksToWrite(QSize chunkSize) const
     return chunksToWrite;
 }
 
+/**
+ * Records the still encoded data of the chunk at \a chunkCoordinates. The
+ * chunk is only decoded once it is accessed. Any cells previously set within
+ * this chunk are replaced.
+ *
+ * Since the data is not validated up front, any errors are only reported
+ * once the chunk is decoded.
+ */
+void TileLayer::setEncodedChunk(QPoint chunkCoordinates,
+                                const EncodedChunk &encodedChunk)
+{
+    Q_ASSERT(encodedChunk.decoder);
+
+    mChunks.remove(chunkCoordinates);
+    mCorruptChunks.remove(chunkCoordinates);
+    mEncodedChunks.insert(chunkCoordinates, encodedChunk);
+    mBounds = mBounds.united(QRect(chunkCoordinates.x() * CHUNK_SIZE,
+                                   chunkCoordinates.y() * CHUNK_SIZE,
+                                   CHUNK_SIZE, CHUNK_SIZE));
+    mUsedTilesetsDirty = true;
+    invalidateTileIndex();
+}
+
+/**
+ * Returns the encoded data of the chunk that covers exactly \a rect, as long
+ * as that chunk has not been decoded yet, or failed to decode and was not
+ * changed since. Returns nullptr otherwise.
+ *
+ * This allows chunks that were never touched to be saved without decoding
+ * and encoding them again, and avoids losing the data of corrupt chunks.
+ */
+const EncodedChunk *TileLayer::findEncodedChunk(QRect rect) const
+{
+    if (mEncodedChunks.isEmpty() && mCorruptChunks.isEmpty())
+        return nullptr;
+    if (rect.width() != CHUNK_SIZE || rect.height() != CHUNK_SIZE)
+        return nullptr;
+    if ((rect.x() & CHUNK_MASK) || (rect.y() & CHUNK_MASK))
+        return nullptr;
+
+    const QPoint chunkCoordinates(rect.x() / CHUNK_SIZE, rect.y() / CHUNK_SIZE);
+
+    auto it = mEncodedChunks.constFind(chunkCoordinates);
+    if (it != mEncodedChunks.constEnd())
+        return &it.value();
+
+    it = mCorruptChunks.constFind(chunkCoordinates);
+    return it != mCorruptChunks.constEnd() ? &it.value() : nullptr;
+}
+
+/**
+ * Decodes \a encodedChunk into \a chunk. When the data turns out to be
+ * corrupt, the error is reported and the chunk is left empty. Its data is
+ * kept, so that it can still be saved unchanged.
+ */
+void TileLayer::decodeInto(QPoint chunkCoordinates,
+                           const EncodedChunk &encodedChunk,
+                           Chunk &chunk) const
+{
+    if (encodedChunk.decoder->decode(encodedChunk.data, chunk))
+        return;
+
+    chunk = Chunk();
+    mCorruptChunks.insert(chunkCoordinates, encodedChunk);
+
+    ERROR(QCoreApplication::translate("Tiled::TileLayer",
+                                      "Corrupt layer data for chunk %1,%2 of layer '%3'")
+          .arg(chunkCoordinates.x() * CHUNK_SIZE)
+          .arg(chunkCoordinates.y() * CHUNK_SIZE)
+          .arg(mName));
+}
+
+/**
+ * Decodes the encoded chunk at \a chunkCoordinates and returns the resulting
+ * chunk. Returns nullptr when there is no encoded chunk at this location.
+ */
+Chunk *TileLayer::decodeChunk(QPoint chunkCoordinates) const
+{
+    auto it = mEncodedChunks.find(chunkCoordinates);
+    if (it == mEncodedChunks.end())
+        return nullptr;
+
+    const EncodedChunk encodedChunk = it.value();
+    mEncodedChunks.erase(it);
+
+    // Decoding only changes the representation of the layer, not its contents
+    auto &chunks = const_cast<QHash<QPoint, Chunk>&>(mChunks);
+    Chunk &chunk = chunks[chunkCoordinates];
+    decodeInto(chunkCoordinates, encodedChunk, chunk);
+
+    mUsedTilesetsDirty = true;
+    return &chunk;
+}
+
+void TileLayer::decodeEncodedChunks() const
+{
+    QHash<QPoint, EncodedChunk> encodedChunks;
+    encodedChunks.swap(mEncodedChunks);
+
+    auto &chunks = const_cast<QHash<QPoint, Chunk>&>(mChunks);
+    chunks.reserve(chunks.size() + encodedChunks.size());
+
+    for (auto it = encodedChunks.cbegin(); it != encodedChunks.cend(); ++it)
+        decodeInto(it.key(), it.value(), chunks[it.key()]);
+
+    mUsedTilesetsDirty = true;
+}
+
 /**
  * Returns a duplicate of this TileLayer.
  *
@@ -836,6 +1377,8 @@ TileLayer *TileLayer::initializeClone(TileLayer *clone) const
 {
     Layer::initializeClone(clone);
     clone->mChunks = mChunks;
+    clone->mEncodedChunks = mEncodedChunks;
+    clone->mCorruptChunks = mCorruptChunks;
     clone->mBounds = mBounds;
     clone->mUsedTilesets = mUsedTilesets;
     clone->mUsedTilesetsDirty = mUsedTilesetsDirty;
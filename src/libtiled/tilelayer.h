@@ -32,18 +32,20 @@
 #include "tiled_global.h"
 
 #include "layer.h"
+#include "regionbuilder.h"
 #include "tiled.h"
 #include "tile.h"
 #include "tileset.h"
 
 #include <QHash>
 #include <QMargins>
+#include <QPair>
 #include <QPoint>
 #include <QSharedPointer>
 #include <QString>
 #include <QVector>
 
-#include <functional>
+#include <array>
 
 inline uint qHash(QPoint key, uint seed = 0) Q_DECL_NOTHROW
 {
@@ -168,40 +170,104 @@ inline bool Cell::refersTile(const Tile *tile) const
 
 /**
  * A Chunk is a grid of cells of size CHUNK_SIZExCHUNK_SIZE.
+ *
+ * The cells are implicitly shared, so copies of a chunk are cheap until one
+ * of them is modified. No memory is allocated for the cells until a cell
+ * that isn't empty is set.
+ *
+ * Each chunk keeps a bitmap of its non-empty cells and counts how many of
+ * its cells refer to each tileset, which are updated by setCell(). Cells
+ * should therefore not be changed through the non-const iterators in a way
+ * that changes whether they are empty or which tileset they refer to.
  */
 class TILEDSHARED_EXPORT Chunk
 {
 public:
-    Chunk() :
-        mGrid(CHUNK_SIZE * CHUNK_SIZE)
-    {}
+    Chunk() {}
+
+    /**
+     * Returns whether no memory has been allocated for the cells of this
+     * chunk, in which case all its cells are empty.
+     */
+    bool isNull() const { return mGrid.isEmpty(); }
+
+    /**
+     * Returns whether this chunk shares its cells with \a other. Since the
+     * cells are implicitly shared, this is the case for a copy of a chunk
+     * until either of them is changed.
+     */
+    bool sharesCellsWith(const Chunk &other) const
+    { return mGrid.constData() == other.mGrid.constData(); }
+
+    /**
+     * Returns whether the cells of this chunk are currently shared with a
+     * copy of it.
+     */
+    bool isShared() const { return !mGrid.isEmpty() && !mGrid.isDetached(); }
+
+    /**
+     * Returns a stamp identifying the contents of this chunk. A new stamp is
+     * taken whenever the chunk is changed, so it is only equal for copies of
+     * a chunk that have not been changed since.
+     */
+    quint64 revision() const { return mRevision; }
+
+    template<typename Condition>
+    QRegion region(Condition condition) const;
+    QRegion region() const;
 
-    QRegion region(std::function<bool (const Cell &)> condition) const;
+    void addToRegion(RegionBuilder &builder, QPoint offset) const;
 
     const Cell &cellAt(int x, int y) const;
     const Cell &cellAt(QPoint point) const;
 
     void setCell(int x, int y, const Cell &cell);
 
+    /**
+     * Returns the bitmap of the non-empty cells on row \a y, in which bit
+     * \c x is set when the cell at \c x is not empty.
+     */
+    quint16 occupiedCells(int y) const { return mOccupied[y]; }
+
     bool isEmpty() const;
 
-    bool hasCell(std::function<bool (const Cell &)> condition) const;
+    template<typename Condition>
+    bool hasCell(Condition condition) const;
+
+    QVector<Tileset*> usedTilesets() const;
 
     void removeReferencesToTileset(Tileset *tileset);
 
     void replaceReferencesToTileset(Tileset *oldTileset, Tileset *newTileset);
 
-    QVector<Cell>::iterator begin() { return mGrid.begin(); }
-    QVector<Cell>::iterator end() { return mGrid.end(); }
+    QVector<Cell>::iterator begin() { touch(); return mGrid.begin(); }
+    QVector<Cell>::iterator end() { touch(); return mGrid.end(); }
     QVector<Cell>::const_iterator begin() const { return mGrid.begin(); }
     QVector<Cell>::const_iterator end() const { return mGrid.end(); }
 
 private:
+    struct TilesetCount
+    {
+        Tileset *tileset;
+        int count;
+    };
+
+    void addTilesetReference(Tileset *tileset);
+    void removeTilesetReference(Tileset *tileset);
+
+    void touch() { mRevision = nextRevision(); }
+    static quint64 nextRevision();
+
     QVector<Cell> mGrid;
+    std::array<quint16, CHUNK_SIZE> mOccupied {};
+    QVector<TilesetCount> mTilesetCounts;
+    quint64 mRevision = 0;
 };
 
 inline const Cell &Chunk::cellAt(int x, int y) const
 {
+    if (mGrid.isEmpty())
+        return Cell::empty;
     return mGrid.at(x + y * CHUNK_SIZE);
 }
 
@@ -210,12 +276,101 @@ inline const Cell &Chunk::cellAt(QPoint point) const
     return cellAt(point.x(), point.y());
 }
 
+/**
+ * Returns whether this chunk has no cells that refer to a tile.
+ */
+inline bool Chunk::isEmpty() const
+{
+    for (quint16 bits : mOccupied)
+        if (bits)
+            return false;
+    return true;
+}
+
+/**
+ * Returns the region of cells in this chunk for which the given
+ * \a condition returns true.
+ */
+template<typename Condition>
+QRegion Chunk::region(Condition condition) const
+{
+    RegionBuilder builder;
+
+    for (int y = 0; y < CHUNK_SIZE; ++y) {
+        for (int x = 0; x < CHUNK_SIZE; ++x) {
+            if (condition(cellAt(x, y))) {
+                const int rangeStart = x;
+                while (x + 1 < CHUNK_SIZE && condition(cellAt(x + 1, y)))
+                    ++x;
+                builder.addSpan(y, rangeStart, x);
+            }
+        }
+    }
+
+    return builder.region();
+}
+
+/**
+ * Returns whether this chunk has any cell for which the given \a condition
+ * returns true.
+ */
+template<typename Condition>
+bool Chunk::hasCell(Condition condition) const
+{
+    if (mGrid.isEmpty())
+        return condition(Cell::empty);
+
+    for (const Cell &cell : mGrid)
+        if (condition(cell))
+            return true;
+
+    return false;
+}
+
+/**
+ * Decodes the data of a chunk that was loaded without being decoded.
+ *
+ * \sa EncodedChunk
+ */
+class TILEDSHARED_EXPORT ChunkDecoder
+{
+public:
+    virtual ~ChunkDecoder() = default;
+
+    /**
+     * Decodes \a data into \a chunk. Returns false when the data could not
+     * be decoded, in which case the chunk may be partially filled.
+     */
+    virtual bool decode(const QByteArray &data, Chunk &chunk) const = 0;
+
+    /**
+     * Returns the tilesets that may be referenced by the decoded data.
+     */
+    virtual QSet<SharedTileset> tilesets() const = 0;
+};
+
+/**
+ * The still encoded data of a chunk, along with the decoder that knows how
+ * to interpret it. Used to load large infinite maps without decoding all
+ * their chunks up front.
+ */
+struct EncodedChunk
+{
+    QByteArray data;
+    QSharedPointer<const ChunkDecoder> decoder;
+};
+
 /**
  * A tile layer is a grid of cells. Each cell refers to a specific tile, and
  * stores how the tile is flipped.
  *
  * Coordinates and regions passed to function parameters are in local
  * coordinates and do not take into account the position of the layer.
+ *
+ * Chunks may be loaded without being decoded, in which case they are decoded
+ * when first accessed, also through const functions. Hence a tile layer
+ * can only be read from multiple threads at the same time after calling
+ * decodeAllChunks().
  */
 class TILEDSHARED_EXPORT TileLayer : public Layer
 {
@@ -229,8 +384,7 @@ public:
             : mChunkPointer(it)
             , mChunkEndPointer(end)
         {
-            if (it != end)
-                mCellPointer = it.value().begin();
+            skipNullChunks();
         }
 
         iterator operator++(int)
@@ -272,6 +426,7 @@ public:
 
     private:
         void advance();
+        void skipNullChunks();
 
         QHash<QPoint, Chunk>::iterator mChunkPointer;
         QHash<QPoint, Chunk>::iterator mChunkEndPointer;
@@ -285,8 +440,7 @@ public:
             : mChunkPointer(it)
             , mChunkEndPointer(end)
         {
-            if (it != end)
-                mCellPointer = it.value().begin();
+            skipNullChunks();
         }
 
         const_iterator operator++(int)
@@ -328,6 +482,7 @@ public:
 
     private:
         void advance();
+        void skipNullChunks();
 
         QHash<QPoint, Chunk>::const_iterator mChunkPointer;
         QHash<QPoint, Chunk>::const_iterator mChunkEndPointer;
@@ -381,8 +536,11 @@ public:
 
     const Chunk *findChunk(int x, int y) const;
 
-    QRegion region(std::function<bool (const Cell &)> condition) const;
+    template<typename Condition>
+    QRegion region(Condition condition) const;
     QRegion region() const;
+    QRegion regionOf(const Cell &cell) const;
+    QRegion regionOf(const Tile *tile) const;
 
     const Cell &cellAt(int x, int y) const;
     const Cell &cellAt(QPoint point) const;
@@ -460,17 +618,16 @@ public:
      */
     QSet<SharedTileset> usedTilesets() const override;
 
-    /**
-     * Returns whether this tile layer has any cell for which the given
-     * \a condition returns true.
-     */
-    bool hasCell(std::function<bool (const Cell &)> condition) const;
+    template<typename Condition>
+    bool hasCell(Condition condition) const;
 
     /**
      * Returns whether this tile layer is referencing the given tileset.
      */
     bool referencesTileset(const Tileset *tileset) const override;
 
+    bool referencesTile(const Tile *tile) const;
+
     /**
      * Removes all references to the given tileset. This sets all tiles on this
      * layer that are from the given tileset to null.
@@ -523,23 +680,62 @@ public:
 
     TileLayer *clone() const override;
 
-    iterator begin() { return iterator(mChunks.begin(), mChunks.end()); }
-    iterator end() { return iterator(mChunks.end(), mChunks.end()); }
-    const_iterator begin() const { return const_iterator(mChunks.begin(), mChunks.end()); }
-    const_iterator end() const { return const_iterator(mChunks.end(), mChunks.end()); }
+    iterator begin() { decodeAllChunks(); return iterator(mChunks.begin(), mChunks.end()); }
+    iterator end() { decodeAllChunks(); return iterator(mChunks.end(), mChunks.end()); }
+    const_iterator begin() const { decodeAllChunks(); return const_iterator(mChunks.begin(), mChunks.end()); }
+    const_iterator end() const { decodeAllChunks(); return const_iterator(mChunks.end(), mChunks.end()); }
 
     QVector<QRect> sortedChunksToWrite(QSize chunkSize) const;
 
+    /**
+     * Returns the number of decoded chunks held by this layer.
+     */
+    int chunkCount() const { return mChunks.size(); }
+    int unsharedChunkCount() const;
+
+    void setEncodedChunk(QPoint chunkCoordinates, const EncodedChunk &encodedChunk);
+    const EncodedChunk *findEncodedChunk(QRect rect) const;
+
+    /**
+     * Returns whether this layer has chunks that have not been decoded yet.
+     */
+    bool hasEncodedChunks() const { return !mEncodedChunks.isEmpty(); }
+
+    void decodeAllChunks() const;
+
 protected:
     TileLayer *initializeClone(TileLayer *clone) const;
 
 private:
+    void setChunk(QPoint chunkCoordinates, const Chunk *chunk);
+    void copyCells(const TileLayer &layer, QPoint offset, QRect rect);
+
+    Chunk *decodeChunk(QPoint chunkCoordinates) const;
+    void decodeEncodedChunks() const;
+    void decodeInto(QPoint chunkCoordinates,
+                    const EncodedChunk &encodedChunk,
+                    Chunk &chunk) const;
+    void updateUsedTilesets() const;
+    void updateTileIndex() const;
+    void invalidateTileIndex();
+    void addToTileIndex(const Cell &cell, QPoint chunkCoordinates) const;
+    void removeFromTileIndex(const Cell &cell, QPoint chunkCoordinates) const;
+    template<typename Condition>
+    QRegion indexedRegion(Tileset *tileset, int tileId, Condition condition) const;
+
     int mWidth;
     int mHeight;
     QHash<QPoint, Chunk> mChunks;
+    mutable QHash<QPoint, EncodedChunk> mEncodedChunks;
+    mutable QHash<QPoint, EncodedChunk> mCorruptChunks;
     QRect mBounds;
     mutable QSet<SharedTileset> mUsedTilesets;
     mutable bool mUsedTilesetsDirty;
+
+    // Maps each tile to the chunks referring to it, along with the number of
+    // cells referring to it in each chunk. Only built once needed.
+    mutable QHash<QPair<Tileset*, int>, QHash<QPoint, int>> mTileIndex;
+    mutable bool mTileIndexValid = false;
 };
 
 inline QPoint TileLayer::iterator::key() const
@@ -557,12 +753,19 @@ inline void TileLayer::iterator::advance()
     if (mChunkPointer != mChunkEndPointer) {
         if (++mCellPointer == mChunkPointer.value().end()) {
             mChunkPointer++;
-            if (mChunkPointer != mChunkEndPointer)
-                mCellPointer = mChunkPointer.value().begin();
+            skipNullChunks();
         }
     }
 }
 
+inline void TileLayer::iterator::skipNullChunks()
+{
+    while (mChunkPointer != mChunkEndPointer && mChunkPointer.value().isNull())
+        ++mChunkPointer;
+    if (mChunkPointer != mChunkEndPointer)
+        mCellPointer = mChunkPointer.value().begin();
+}
+
 inline QPoint TileLayer::const_iterator::key() const
 {
     QPoint chunkStart = mChunkPointer.key();
@@ -578,12 +781,19 @@ inline void TileLayer::const_iterator::advance()
     if (mChunkPointer != mChunkEndPointer) {
         if (++mCellPointer == mChunkPointer.value().end()) {
             mChunkPointer++;
-            if (mChunkPointer != mChunkEndPointer)
-                mCellPointer = mChunkPointer.value().begin();
+            skipNullChunks();
         }
     }
 }
 
+inline void TileLayer::const_iterator::skipNullChunks()
+{
+    while (mChunkPointer != mChunkEndPointer && mChunkPointer.value().isNull())
+        ++mChunkPointer;
+    if (mChunkPointer != mChunkEndPointer)
+        mCellPointer = mChunkPointer.value().begin();
+}
+
 /**
  * Sets the size of this layer.
  */
@@ -607,6 +817,10 @@ inline Chunk& TileLayer::chunk(int x, int y)
 {
     QPoint chunkCoordinates(x < 0 ? (x + 1) / CHUNK_SIZE - 1 : x / CHUNK_SIZE,
                             y < 0 ? (y + 1) / CHUNK_SIZE - 1 : y / CHUNK_SIZE);
+    if (Q_UNLIKELY(!mEncodedChunks.isEmpty()))
+        decodeChunk(chunkCoordinates);
+    if (Q_UNLIKELY(!mCorruptChunks.isEmpty()))
+        mCorruptChunks.remove(chunkCoordinates);    // about to be changed
     return mChunks[chunkCoordinates];
 }
 
@@ -615,16 +829,70 @@ inline const Chunk* TileLayer::findChunk(int x, int y) const
     QPoint chunkCoordinates(x < 0 ? (x + 1) / CHUNK_SIZE - 1 : x / CHUNK_SIZE,
                             y < 0 ? (y + 1) / CHUNK_SIZE - 1 : y / CHUNK_SIZE);
     auto it = mChunks.find(chunkCoordinates);
-    return it != mChunks.end() ? &it.value() : nullptr;
+    if (it != mChunks.end())
+        return &it.value();
+    if (Q_UNLIKELY(!mEncodedChunks.isEmpty()))
+        return decodeChunk(chunkCoordinates);
+    return nullptr;
 }
 
 /**
- * Calculates the region occupied by the tiles of this layer. Similar to
- * Layer::bounds(), but leaves out the regions without tiles.
+ * Decodes any chunks that were loaded without being decoded. Needs to be
+ * called before directly iterating over all chunks, and before the layer is
+ * shared with other threads.
  */
-inline QRegion TileLayer::region() const
+inline void TileLayer::decodeAllChunks() const
 {
-    return region([] (const Cell &cell) { return !cell.isEmpty(); });
+    if (Q_UNLIKELY(!mEncodedChunks.isEmpty()))
+        decodeEncodedChunks();
+}
+
+/**
+ * Calculates the region of cells in this tile layer for which the given
+ * \a condition returns true.
+ */
+template<typename Condition>
+QRegion TileLayer::region(Condition condition) const
+{
+    decodeAllChunks();
+
+    RegionBuilder builder;
+
+    for (auto it = mChunks.cbegin(), it_end = mChunks.cend(); it != it_end; ++it) {
+        const Chunk &chunk = it.value();
+        const int startX = it.key().x() * CHUNK_SIZE + mX;
+        const int startY = it.key().y() * CHUNK_SIZE + mY;
+
+        for (int y = 0; y < CHUNK_SIZE; ++y) {
+            for (int x = 0; x < CHUNK_SIZE; ++x) {
+                if (condition(chunk.cellAt(x, y))) {
+                    const int rangeStart = x;
+                    while (x + 1 < CHUNK_SIZE && condition(chunk.cellAt(x + 1, y)))
+                        ++x;
+                    builder.addSpan(startY + y, startX + rangeStart, startX + x);
+                }
+            }
+        }
+    }
+
+    return builder.region();
+}
+
+/**
+ * Returns whether this tile layer has any cell for which the given
+ * \a condition returns true.
+ */
+template<typename Condition>
+bool TileLayer::hasCell(Condition condition) const
+{
+    decodeAllChunks();
+
+    for (const Chunk &chunk : mChunks) {
+        if (chunk.hasCell(condition))
+            return true;
+    }
+
+    return false;
 }
 
 /**
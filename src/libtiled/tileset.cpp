@@ -38,6 +38,8 @@
 
 #include <QBitmap>
 
+#include <climits>
+
 #include "qtcompat_p.h"
 
 namespace Tiled {
@@ -133,6 +135,7 @@ Tile *Tileset::findOrCreateTile(int id)
         return tile;
 
     mNextTileId = std::max(mNextTileId, id + 1);
+    markTerrainIndexDirty();
     return mTiles[id] = new Tile(id, this);
 }
 
@@ -245,6 +248,8 @@ bool Tileset::loadFromImage(const QImage &image, const QUrl &source)
     }
 
     mNextTileId = std::max(mNextTileId, tileNum);
+    mCutTileHashes.clear();
+    markTerrainIndexDirty();
 
     mImageReference.size = image.size();
     mColumnCount = columnCountForWidth(mImageReference.size.width());
@@ -279,13 +284,37 @@ bool Tileset::loadFromImage(const QString &fileName)
     return loadImage();
 }
 
+/**
+ * Returns a hash of the pixels of the given tile \a image. Only the hashes of
+ * the tiles are remembered, to find the tiles that changed when the tileset
+ * image is loaded again.
+ */
+static uint tileImageHash(const QImage &image)
+{
+    const QVector<QRgb> colorTable = image.colorTable();
+    const int lineLength = (image.width() * image.depth() + 7) / 8;
+
+    uint hash = qHash(int(image.format()));
+    hash = qHashBits(colorTable.constData(), colorTable.size() * sizeof(QRgb), hash);
+
+    // Lines are hashed separately to skip the padding at their end
+    for (int y = 0; y < image.height(); ++y)
+        hash = qHashBits(image.constScanLine(y), lineLength, hash);
+
+    return hash;
+}
+
 /**
  * Tries to load the image this tileset is referring to.
  *
+ * Tiles that look the same as when the image was last loaded keep their
+ * image, so that they don't need to be converted to a pixmap again. The
+ * tiles that did change are added to \a changedTiles, when given.
+ *
  * @return <code>true</code> if loading was successful, otherwise
  *         returns <code>false</code>
  */
-bool Tileset::loadImage()
+bool Tileset::loadImage(QList<Tile*> *changedTiles)
 {
     TilesheetParameters p;
     p.fileName = Tiled::urlToLocalFileOrQrc(mImageReference.source);
@@ -306,26 +335,55 @@ bool Tileset::loadImage()
         return false;
     }
 
-    auto tiles = ImageCache::cutTiles(p);
+    const QVector<QImage> tiles = ImageCache::cutTiles(p);
+    const QSize tileSize(p.tileWidth, p.tileHeight);
+
+    // The hashes of the previous tiles can only be compared when the tiles
+    // have the same size
+    QVector<uint> previousHashes;
+    if (mCutTileSize == tileSize)
+        previousHashes.swap(mCutTileHashes);
+
+    mCutTileHashes.resize(tiles.size());
+    mCutTileSize = tileSize;
 
     for (int tileNum = 0; tileNum < tiles.size(); ++tileNum) {
+        const QImage &tileImage = tiles.at(tileNum);
+        const uint hash = tileImageHash(tileImage);
+        mCutTileHashes[tileNum] = hash;
+
         auto it = mTiles.find(tileNum);
-        if (it != mTiles.end())
-            it.value()->setImage(tiles.at(tileNum));
-        else
-            mTiles.insert(tileNum, new Tile(tiles.at(tileNum), tileNum, this));
+        if (it != mTiles.end()) {
+            if (tileNum < previousHashes.size() && previousHashes.at(tileNum) == hash)
+                continue;
+
+            it.value()->setImage(tileImage);
+        } else {
+            it = mTiles.insert(tileNum, new Tile(tileImage, tileNum, this));
+        }
+
+        if (changedTiles)
+            changedTiles->append(it.value());
     }
 
-    QPixmap blank;
+    // Remaining tiles were already blanked by the previous load when the
+    // number and size of the tiles didn't change
+    const bool blankedBefore = !tiles.isEmpty() &&
+            previousHashes.size() == tiles.size();
+
+    QImage blank;
 
     // Blank out any remaining tiles to avoid confusion (todo: could be more clear)
     for (Tile *tile : qAsConst(mTiles)) {
-        if (tile->id() >= tiles.size()) {
+        if (tile->id() >= tiles.size() && !blankedBefore) {
             if (blank.isNull()) {
-                blank = QPixmap(mTileWidth, mTileHeight);
-                blank.fill();
+                blank = QImage(mTileWidth, mTileHeight, QImage::Format_ARGB32_Premultiplied);
+                blank.fill(Qt::white);
             }
             tile->setImage(blank);
+
+            if (changedTiles)
+                changedTiles->append(tile);
         }
     }
 
@@ -660,6 +718,108 @@ void Tileset::recalculateTerrainDistances()
 
     mMaximumTerrainDistance = maximumDistance;
     mTerrainDistancesDirty = false;
+
+    // The penalties used to rank the matching tiles may have changed
+    markTerrainIndexDirty();
+}
+
+/**
+ * Returns the index of the combination of corners included in \a mask, with
+ * one bit set for each corner.
+ */
+static int cornerCombination(unsigned mask)
+{
+    int combination = 0;
+    for (int corner = 0; corner < 4; ++corner)
+        if (mask & (0xFFu << (corner * 8)))
+            combination |= 1 << corner;
+    return combination;
+}
+
+/**
+ * Returns the mask covering the corners in the given \a combination.
+ */
+static unsigned cornerMask(int combination)
+{
+    unsigned mask = 0;
+    for (int corner = 0; corner < 4; ++corner)
+        if (combination & (1 << corner))
+            mask |= 0xFFu << (corner * 8);
+    return mask;
+}
+
+/**
+ * Returns the tiles that match \a terrain for the corners included in
+ * \a considerationMask and have the lowest transition penalty towards
+ * \a terrain for the remaining corners.
+ *
+ * The tiles are looked up in an index grouping them by the terrain of the
+ * considered corners, and the result is cached until the tiles, terrains or
+ * probabilities in this tileset change.
+ */
+const Tileset::TerrainMatches &Tileset::findBestTerrainTiles(unsigned terrain,
+                                                             unsigned considerationMask) const
+{
+    if (mTerrainDistancesDirty)
+        const_cast<Tileset*>(this)->recalculateTerrainDistances();
+
+    const quint64 key = (quint64(terrain) << 32) | considerationMask;
+    auto cached = mBestTerrainTiles.constFind(key);
+    if (cached != mBestTerrainTiles.constEnd())
+        return cached.value();
+
+    if (mTerrainIndex.isEmpty()) {
+        mTerrainIndex.resize(16);
+
+        for (int combination = 0; combination < 16; ++combination) {
+            const unsigned mask = cornerMask(combination);
+            auto &tilesByTerrain = mTerrainIndex[combination];
+
+            for (Tile *tile : mTiles)
+                tilesByTerrain[tile->terrain() & mask].append(tile);
+        }
+    }
+
+    const int combination = cornerCombination(considerationMask);
+    const QVector<Tile*> candidates = mTerrainIndex.at(combination).value(terrain & cornerMask(combination));
+
+    TerrainMatches matches;
+    int penalty = INT_MAX;
+
+    for (Tile *t : candidates) {
+        // only needed when the mask does not cover whole corners
+        if ((t->terrain() & considerationMask) != (terrain & considerationMask))
+            continue;
+
+        // calculate the tile transition penalty based on shortest distance to target terrain type
+        int tr = terrainTransitionPenalty(t->terrain() >> 24, terrain >> 24);
+        int tl = terrainTransitionPenalty((t->terrain() >> 16) & 0xFF, (terrain >> 16) & 0xFF);
+        int br = terrainTransitionPenalty((t->terrain() >> 8) & 0xFF, (terrain >> 8) & 0xFF);
+        int bl = terrainTransitionPenalty(t->terrain() & 0xFF, terrain & 0xFF);
+
+        // if there is no path to the destination terrain, this isn't a useful transition
+        if (tr < 0 || tl < 0 || br < 0 || bl < 0)
+            continue;
+
+        int transitionPenalty = tr + tl + br + bl;
+        if (transitionPenalty > penalty)
+            continue;
+
+        if (transitionPenalty < penalty) {
+            matches.tiles.clear();
+            matches.cumulativeProbabilities.clear();
+            penalty = transitionPenalty;
+        }
+
+        if (t->probability() <= 0)
+            continue;
+
+        const qreal total = matches.cumulativeProbabilities.isEmpty() ? 0.0 : matches.cumulativeProbabilities.last();
+        matches.tiles.append(t);
+        matches.cumulativeProbabilities.append(total + t->probability());
+    }
+
+    return *mBestTerrainTiles.insert(key, matches);
 }
 
 void Tileset::addWangSet(WangSet *wangSet)
@@ -706,6 +866,8 @@ Tile *Tileset::addTile(const QPixmap &image, const QUrl &source)
     newTile->setImageSource(source);
 
     mTiles.insert(newTile->id(), newTile);
+    markTerrainIndexDirty();
+
     if (mTileHeight < image.height())
         mTileHeight = image.height();
     if (mTileWidth < image.width())
@@ -725,6 +887,7 @@ void Tileset::addTiles(const QList<Tile *> &tiles)
         mTiles.insert(tile->id(), tile);
     }
 
+    markTerrainIndexDirty();
     updateTileSize();
 }
 
@@ -740,6 +903,7 @@ void Tileset::removeTiles(const QList<Tile *> &tiles)
         mTiles.remove(tile->id());
     }
 
+    markTerrainIndexDirty();
     updateTileSize();
 }
 
@@ -749,6 +913,7 @@ void Tileset::removeTiles(const QList<Tile *> &tiles)
 void Tileset::deleteTile(int id)
 {
     delete mTiles.take(id);
+    markTerrainIndexDirty();
 }
 
 /**
@@ -765,12 +930,38 @@ void Tileset::setTileImage(Tile *tile,
     Q_ASSERT(isCollection());
     Q_ASSERT(mTiles.value(tile->id()) == tile);
 
-    const QSize previousImageSize = tile->image().size();
-    const QSize newImageSize = image.size();
+    const QSize previousImageSize = tile->size();
 
     tile->setImage(image);
     tile->setImageSource(source);
 
+    tileImageSizeChanged(previousImageSize, image.size());
+}
+
+/**
+ * Overload that keeps the image as a QImage until it is first needed, which
+ * allows it to be used on other threads than the GUI thread.
+ */
+void Tileset::setTileImage(Tile *tile,
+                           const QImage &image,
+                           const QUrl &source)
+{
+    Q_ASSERT(isCollection());
+    Q_ASSERT(mTiles.value(tile->id()) == tile);
+
+    const QSize previousImageSize = tile->size();
+
+    tile->setImage(image);
+    tile->setImageSource(source);
+
+    tileImageSizeChanged(previousImageSize, image.size());
+}
+
+/**
+ * Updates the maximum tile size after the size of a tile image changed.
+ */
+void Tileset::tileImageSizeChanged(QSize previousImageSize, QSize newImageSize)
+{
     if (previousImageSize != newImageSize) {
         // Update our max. tile size
         if (previousImageSize.height() == mTileHeight ||
@@ -825,6 +1016,8 @@ void Tileset::swap(Tileset &other)
     std::swap(mExpectedRowCount, other.mExpectedRowCount);
     std::swap(mTiles, other.mTiles);
     std::swap(mNextTileId, other.mNextTileId);
+    std::swap(mCutTileHashes, other.mCutTileHashes);
+    std::swap(mCutTileSize, other.mCutTileSize);
     std::swap(mTerrainTypes, other.mTerrainTypes);
     std::swap(mWangSets, other.mWangSets);
     std::swap(mTerrainDistancesDirty, other.mTerrainDistancesDirty);
@@ -834,6 +1027,9 @@ void Tileset::swap(Tileset &other)
 
     // Don't swap mWeakPointer, since it's a reference to this.
 
+    markTerrainIndexDirty();
+    other.markTerrainIndexDirty();
+
     // Update back references from tiles and terrains
     for (auto tile : qAsConst(mTiles))
         tile->mTileset = this;
@@ -33,6 +33,7 @@
 #include "object.h"
 
 #include <QColor>
+#include <QHash>
 #include <QList>
 #include <QPixmap>
 #include <QPoint>
@@ -169,7 +170,7 @@ public:
     bool loadFromImage(const QImage &image, const QUrl &source);
     bool loadFromImage(const QImage &image, const QString &source);
     bool loadFromImage(const QString &fileName);
-    bool loadImage();
+    bool loadImage(QList<Tile*> *changedTiles = nullptr);
 
     SharedTileset findSimilarTileset(const QVector<SharedTileset> &tilesets) const;
 
@@ -195,6 +196,19 @@ public:
     int terrainTransitionPenalty(int terrainType0, int terrainType1) const;
     int maximumTerrainDistance() const;
 
+    /**
+     * The tiles best matching a certain terrain, along with the cumulative
+     * probabilities used for picking one of them at random.
+     */
+    struct TerrainMatches
+    {
+        QVector<Tile*> tiles;
+        QVector<qreal> cumulativeProbabilities;
+    };
+
+    const TerrainMatches &findBestTerrainTiles(unsigned terrain,
+                                               unsigned considerationMask) const;
+
     const QList<WangSet*> &wangSets() const;
     int wangSetCount() const;
     WangSet *wangSet(int index) const;
@@ -216,8 +230,12 @@ public:
     void setTileImage(Tile *tile,
                       const QPixmap &image,
                       const QUrl &source = QUrl());
+    void setTileImage(Tile *tile,
+                      const QImage &image,
+                      const QUrl &source = QUrl());
 
     void markTerrainDistancesDirty();
+    void markTerrainIndexDirty();
 
     SharedTileset sharedPointer() const;
 
@@ -252,6 +270,7 @@ public:
 
 private:
     void updateTileSize();
+    void tileImageSizeChanged(QSize previousImageSize, QSize newImageSize);
     void recalculateTerrainDistances();
 
     QString mName;
@@ -269,6 +288,8 @@ private:
     int mExpectedColumnCount;
     int mExpectedRowCount;
     int mNextTileId;
+    QVector<uint> mCutTileHashes;
+    QSize mCutTileSize;
     int mMaximumTerrainDistance;
     QMap<int, Tile*> mTiles;
     QList<Terrain*> mTerrainTypes;
@@ -278,6 +299,11 @@ private:
     QColor mBackgroundColor;
     QPointer<TilesetFormat> mFormat;
 
+    // Tiles grouped by their terrain, for each combination of corners
+    // considered, and the best matches found for each requested terrain
+    mutable QVector<QHash<unsigned, QVector<Tile*>>> mTerrainIndex;
+    mutable QHash<quint64, TerrainMatches> mBestTerrainTiles;
+
     QWeakPointer<Tileset> mWeakPointer;
     QWeakPointer<Tileset> mOriginalTileset;
 };
@@ -646,6 +672,16 @@ inline void Tileset::markTerrainDistancesDirty()
     mTerrainDistancesDirty = true;
 }
 
+/**
+ * Discards the index used by findBestTerrainTiles(). Used by the Tile class
+ * when its probability changes.
+ */
+inline void Tileset::markTerrainIndexDirty()
+{
+    mTerrainIndex.clear();
+    mBestTerrainTiles.clear();
+}
+
 inline SharedTileset Tileset::sharedPointer() const
 {
     return SharedTileset(mWeakPointer);
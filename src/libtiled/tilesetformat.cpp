@@ -72,10 +72,13 @@ SharedTileset readTileset(const QString &fileName, QString *error)
 
 TilesetFormat *findSupportingTilesetFormat(const QString &fileName)
 {
-    const auto tilesetFormats = PluginManager::objects<TilesetFormat>();
-    for (TilesetFormat *format : tilesetFormats)
-        if (format->supportsFile(fileName))
-            return format;
+    do {
+        const auto tilesetFormats = PluginManager::objects<TilesetFormat>();
+        for (TilesetFormat *format : tilesetFormats)
+            if (format->supportsFile(fileName))
+                return format;
+    } while (PluginManager::loadPluginsOnDemand(fileName));
+
     return nullptr;
 }
 
@@ -37,6 +37,9 @@
 
 #include "qtcompat_p.h"
 
+#include <QMutexLocker>
+#include <QThread>
+
 namespace Tiled {
 
 TilesetManager *TilesetManager::mInstance;
@@ -105,19 +108,48 @@ SharedTileset TilesetManager::loadTileset(const QString &fileName, QString *erro
  */
 SharedTileset TilesetManager::findTileset(const QString &fileName) const
 {
-    for (Tileset *tileset : mTilesets)
-        if (tileset->fileName() == fileName)
-            return tileset->sharedPointer();
+    QMutexLocker locker(&mMutex);
+
+    for (Tileset *tileset : mTilesets) {
+        if (tileset->fileName() == fileName) {
+            // May be null when the tileset is being deleted by another thread
+            if (SharedTileset sharedTileset = tileset->sharedPointer())
+                return sharedTileset;
+        }
+    }
 
     return SharedTileset();
 }
 
+/**
+ * Returns the tracked tilesets. Strong references are returned, so that the
+ * tilesets can't be deleted by other threads while they are used.
+ */
+QVector<SharedTileset> TilesetManager::tilesets() const
+{
+    QMutexLocker locker(&mMutex);
+
+    QVector<SharedTileset> tilesets;
+    tilesets.reserve(mTilesets.size());
+    for (Tileset *tileset : mTilesets)
+        if (SharedTileset sharedTileset = tileset->sharedPointer())
+            tilesets.append(sharedTileset);
+
+    return tilesets;
+}
+
 /**
  * Adds a tileset reference. This will make sure the tileset is watched for
  * changes and can be found using findTileset().
  */
 void TilesetManager::addTileset(Tileset *tileset)
 {
+    // Tilesets created by other threads are not tracked. Such tilesets are
+    // expected to be used only by the threads that load them.
+    if (QThread::currentThread() != thread())
+        return;
+
+    QMutexLocker locker(&mMutex);
     Q_ASSERT(!mTilesets.contains(tileset));
     mTilesets.append(tileset);
 }
@@ -125,14 +157,19 @@ void TilesetManager::addTileset(Tileset *tileset)
 /**
  * Removes a tileset reference. When the last reference has been removed,
  * the tileset is no longer watched for changes.
+ *
+ * Can be called from any thread, since the last reference to a tileset may
+ * be released by any thread.
  */
 void TilesetManager::removeTileset(Tileset *tileset)
 {
-    Q_ASSERT(mTilesets.contains(tileset));
-    mTilesets.removeOne(tileset);
+    QMutexLocker locker(&mMutex);
 
-    if (tileset->imageSource().isLocalFile())
-        mWatcher->removePath(tileset->imageSource().toLocalFile());
+    // Untracked when the tileset was created by another thread
+    if (!mTilesets.removeOne(tileset))
+        return;
+
+    watchImage(tileset->imageSource(), false);
 }
 
 /**
@@ -140,8 +177,11 @@ void TilesetManager::removeTileset(Tileset *tileset)
  */
 void TilesetManager::reloadImages(Tileset *tileset)
 {
-    if (!mTilesets.contains(tileset))
-        return;
+    {
+        QMutexLocker locker(&mMutex);
+        if (!mTilesets.contains(tileset))
+            return;
+    }
 
     if (tileset->isCollection()) {
         for (Tile *tile : tileset->tiles()) {
@@ -155,11 +195,28 @@ void TilesetManager::reloadImages(Tileset *tileset)
         emit tilesetImagesChanged(tileset);
     } else {
         ImageCache::remove(tileset->imageSource().toLocalFile());
-        if (tileset->loadImage())
-            emit tilesetImagesChanged(tileset);
+        reloadTilesetImage(tileset);
     }
 }
 
+/**
+ * Reloads the image of the given \a tileset. When the size of the image did
+ * not change, only the tiles that changed are updated and repainted.
+ */
+void TilesetManager::reloadTilesetImage(Tileset *tileset)
+{
+    const QSize previousImageSize(tileset->imageWidth(), tileset->imageHeight());
+    QList<Tile*> changedTiles;
+
+    if (!tileset->loadImage(&changedTiles))
+        return;
+
+    if (previousImageSize != QSize(tileset->imageWidth(), tileset->imageHeight()))
+        emit tilesetImagesChanged(tileset);
+    else if (!changedTiles.isEmpty())
+        emit tileImagesChanged(tileset, changedTiles);
+}
+
 /**
  * Sets whether tilesets are automatically reloaded when their tileset
  * image changes.
@@ -190,13 +247,36 @@ bool TilesetManager::animateTiles() const
 void TilesetManager::tilesetImageSourceChanged(const Tileset &tileset,
                                                const QUrl &oldImageSource)
 {
-    Q_ASSERT(mTilesets.contains(const_cast<Tileset*>(&tileset)));
+    QMutexLocker locker(&mMutex);
+
+    if (!mTilesets.contains(const_cast<Tileset*>(&tileset)))
+        return;
+
+    watchImage(oldImageSource, false);
+    watchImage(tileset.imageSource(), true);
+}
+
+/**
+ * Starts or stops watching the given image. The file system watcher is only
+ * used from the thread of the manager.
+ */
+void TilesetManager::watchImage(const QUrl &imageSource, bool watch)
+{
+    if (!imageSource.isLocalFile())
+        return;
 
-    if (oldImageSource.isLocalFile())
-        mWatcher->removePath(oldImageSource.toLocalFile());
+    QMetaObject::invokeMethod(this, watch ? "watchFile" : "unwatchFile",
+                              Q_ARG(QString, imageSource.toLocalFile()));
+}
 
-    if (tileset.imageSource().isLocalFile())
-        mWatcher->addPath(tileset.imageSource().toLocalFile());
+void TilesetManager::watchFile(const QString &fileName)
+{
+    mWatcher->addPath(fileName);
+}
+
+void TilesetManager::unwatchFile(const QString &fileName)
+{
+    mWatcher->removePath(fileName);
 }
 
 void TilesetManager::filesChanged(const QStringList &fileNames)
@@ -204,14 +284,16 @@ void TilesetManager::filesChanged(const QStringList &fileNames)
     if (!mReloadTilesetsOnChange)
         return;
 
-    for (const QString &fileName : fileNames)
+    QSet<QString> changedFiles;
+    for (const QString &fileName : fileNames) {
         ImageCache::remove(fileName);
+        changedFiles.insert(fileName);
+    }
 
-    for (Tileset *tileset : qAsConst(mTilesets)) {
+    for (const SharedTileset &tileset : tilesets()) {
         const QString fileName = tileset->imageSource().toLocalFile();
-        if (fileNames.contains(fileName))
-            if (tileset->loadImage())
-                emit tilesetImagesChanged(tileset);
+        if (changedFiles.contains(fileName))
+            reloadTilesetImage(tileset.data());
     }
 }
 
@@ -224,14 +306,14 @@ void TilesetManager::resetTileAnimations()
     // TODO: This could be more optimal by keeping track of the list of
     // actually animated tiles
 
-    for (Tileset *tileset : qAsConst(mTilesets)) {
+    for (const SharedTileset &tileset : tilesets()) {
         bool imageChanged = false;
 
         for (Tile *tile : tileset->tiles())
             imageChanged |= tile->resetAnimation();
 
         if (imageChanged)
-            emit repaintTileset(tileset);
+            emit repaintTileset(tileset.data());
     }
 }
 
@@ -240,14 +322,14 @@ void TilesetManager::advanceTileAnimations(int ms)
     // TODO: This could be more optimal by keeping track of the list of
     // actually animated tiles
 
-    for (Tileset *tileset : qAsConst(mTilesets)) {
+    for (const SharedTileset &tileset : tilesets()) {
         bool imageChanged = false;
 
         for (Tile *tile : tileset->tiles())
             imageChanged |= tile->advanceAnimation(ms);
 
         if (imageChanged)
-            emit repaintTileset(tileset);
+            emit repaintTileset(tileset.data());
     }
 }
 
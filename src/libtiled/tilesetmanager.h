@@ -33,7 +33,9 @@
 
 #include <QObject>
 #include <QList>
+#include <QMutex>
 #include <QString>
+#include <QVector>
 
 namespace Tiled {
 
@@ -44,6 +46,10 @@ class TileAnimationDriver;
  * The tileset manager keeps track of all tilesets used by loaded maps. It also
  * watches the tileset images for changes and will attempt to reload them when
  * they change.
+ *
+ * Only tilesets created on the thread of the manager are tracked. Tilesets
+ * may be released on any thread, but the other functions may only be used
+ * from the thread of the manager.
  */
 class TILEDSHARED_EXPORT TilesetManager : public QObject
 {
@@ -82,17 +88,38 @@ signals:
      */
     void tilesetImagesChanged(Tileset *tileset);
 
+    /**
+     * Emitted when the images of only some of the tiles in the given
+     * \a tileset have changed, after the tileset image was reloaded. The
+     * image size and the number of tiles did not change.
+     */
+    void tileImagesChanged(Tileset *tileset, const QList<Tile*> &tiles);
+
     /**
      * Emitted when any images of the tiles in the given \a tileset have
      * changed as a result of playing tile animations.
      */
     void repaintTileset(Tileset *tileset);
 
+private slots:
+    void watchFile(const QString &fileName);
+    void unwatchFile(const QString &fileName);
+
 private:
     void filesChanged(const QStringList &fileNames);
+    void reloadTilesetImage(Tileset *tileset);
 
     void advanceTileAnimations(int ms);
 
+    QVector<SharedTileset> tilesets() const;
+    void watchImage(const QUrl &imageSource, bool watch);
+
+    /**
+     * Protects the list of tilesets, since the last reference to a tileset
+     * may be released by another thread.
+     */
+    mutable QMutex mMutex;
+
     /**
      * The list of loaded tilesets (weak references).
      */
@@ -346,6 +346,8 @@ void WangSet::setEdgeColorCount(int n)
 {
     Q_ASSERT(n > 0 && n <= 15);
 
+    clearMatchCache();
+
     if (n == edgeColorCount())
         return;
 
@@ -372,6 +374,8 @@ void WangSet::setCornerColorCount(int n)
 {
     Q_ASSERT(n > 0 && n <= 15);
 
+    clearMatchCache();
+
     if (n == cornerColorCount())
         return;
 
@@ -396,6 +400,8 @@ void WangSet::setCornerColorCount(int n)
 
 void WangSet::insertWangColor(const QSharedPointer<WangColor> &wangColor)
 {
+    clearMatchCache();
+
     if (wangColor->isEdge())
         insertEdgeWangColor(wangColor);
     else
@@ -405,6 +411,8 @@ void WangSet::insertWangColor(const QSharedPointer<WangColor> &wangColor)
 
 void WangSet::addWangColor(const QSharedPointer<WangColor> &wangColor)
 {
+    clearMatchCache();
+
     if (wangColor->isEdge()) {
         wangColor->setColorIndex(mEdgeColors.size() + 1);
         insertEdgeWangColor(wangColor);
@@ -438,6 +446,8 @@ void WangSet::insertCornerWangColor(const QSharedPointer<WangColor> &wangColor)
 
 void WangSet::removeWangColorAt(int color, bool isEdge)
 {
+    clearMatchCache();
+
     if (isEdge)
         removeEdgeWangColor(color);
     else
@@ -572,6 +582,7 @@ void WangSet::addWangTile(const WangTile &wangTile)
 
     mWangIdToWangTile.insert(wangTile.wangId(), wangTile);
     mTileInfoToWangId.insert(wangTileToTileInfo(wangTile), wangTile.wangId());
+    clearMatchCache();
 }
 
 void WangSet::removeWangTile(const WangTile &wangTile)
@@ -582,6 +593,7 @@ void WangSet::removeWangTile(const WangTile &wangTile)
     w.setWangId(wangId);
 
     mWangIdToWangTile.remove(wangId, w);
+    clearMatchCache();
 
     if (wangId
             && !mWangIdToWangTile.contains(wangId)
@@ -602,17 +614,91 @@ QList<WangTile> WangSet::findMatchingWangTiles(WangId wangId) const
     if (wangId == 0)
         return mWangIdToWangTile.values();
 
-    QList<WangTile> list;
+    return matchingWangTiles(wangId).wangTiles.toList();
+}
+
+/**
+ * Returns a mask with all bits set for each color in \a wangId that is a wild
+ * card. Like WangId::variations(), zeros are only treated as wild cards for
+ * the edges or corners when the set has more than one color for them.
+ */
+static unsigned wildCardMask(WangId wangId, int edgeColors, int cornerColors)
+{
+    unsigned mask = 0;
+    for (int i = 0; i < 8; ++i) {
+        const int colors = (i & 1) ? cornerColors : edgeColors;
+        if (colors > 1 && !wangId.indexColor(i))
+            mask |= 0xfu << (i * 4);
+    }
+    return mask;
+}
+
+/**
+ * Returns the index of the combination of wild cards in \a wildCards, with
+ * one bit set for each wild card.
+ */
+static int wildCardIndex(unsigned wildCards)
+{
+    int index = 0;
+    for (int i = 0; i < 8; ++i)
+        if (wildCards & (0xfu << (i * 4)))
+            index |= 1 << i;
+    return index;
+}
 
-    for (WangId id : wangId.variations(edgeColorCount(), cornerColorCount())) {
-        auto i = mWangIdToWangTile.find(id);
-        while (i != mWangIdToWangTile.end() && i.key() == id) {
-            list.append(i.value());
-            ++i;
+/**
+ * Returns whether the colors of \a wangId at the wild cards are in range,
+ * since WangId::variations() only enumerates the valid colors.
+ */
+static bool wildCardsInRange(WangId wangId, unsigned wildCards, int edgeColors, int cornerColors)
+{
+    for (int i = 0; i < 8; ++i) {
+        if (!(wildCards & (0xfu << (i * 4))))
+            continue;
+        if (wangId.indexColor(i) > ((i & 1) ? cornerColors : edgeColors))
+            return false;
+    }
+    return true;
+}
+
+const WangSet::MatchingWangTiles &WangSet::matchingWangTiles(WangId wangId) const
+{
+    if (mMatchCache.isEmpty())
+        mMatchCache.resize(256);
+
+    const int edgeColors = edgeColorCount();
+    const int cornerColors = cornerColorCount();
+    const unsigned wildCards = wildCardMask(wangId, edgeColors, cornerColors);
+
+    QHash<unsigned, MatchingWangTiles> &table = mMatchCache[wildCardIndex(wildCards)];
+
+    // Build the table for this combination of wild cards on first use. An
+    // empty entry for the null wangId marks the table as built.
+    if (table.isEmpty()) {
+        for (auto it = mWangIdToWangTile.cbegin(); it != mWangIdToWangTile.cend(); ++it) {
+            if (!wildCardsInRange(it.key(), wildCards, edgeColors, cornerColors))
+                continue;
+
+            MatchingWangTiles &matches = table[it.key() & ~wildCards];
+            const qreal probability = qMax<qreal>(0, wangTileProbability(it.value()));
+
+            matches.wangTiles.append(it.value());
+            matches.cumulativeProbabilities.append(matches.totalProbability() + probability);
         }
+
+        if (!table.contains(0))
+            table.insert(0, MatchingWangTiles());
     }
 
-    return list;
+    static const MatchingWangTiles noMatches;
+
+    auto it = table.constFind(wangId);
+    return it != table.constEnd() ? it.value() : noMatches;
+}
+
+void WangSet::clearMatchCache()
+{
+    mMatchCache.clear();
 }
 
 WangId WangSet::wangIdFromSurrounding(WangId surroundingWangIds[]) const
@@ -738,12 +824,7 @@ bool WangSet::wildWangIdIsUsed(WangId wangId) const
     if (!wangId)
         return true;
 
-    for (WangId id : wangId.variations(edgeColorCount(), cornerColorCount())) {
-        if (wangIdIsUsed(id))
-            return true;
-    }
-
-    return false;
+    return !matchingWangTiles(wangId).isEmpty();
 }
 
 bool WangSet::isComplete() const
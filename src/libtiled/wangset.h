@@ -35,6 +35,7 @@
 #include <QMultiHash>
 #include <QString>
 #include <QList>
+#include <QVector>
 
 namespace Tiled {
 
@@ -251,7 +252,7 @@ public:
     void setName(const QString &name) { mName = name; }
     void setColor(const QColor &color) { mColor = color; }
     void setImageId(int imageId) { mImageId = imageId; }
-    void setProbability(qreal probability) { mProbability = probability; }
+    void setProbability(qreal probability);
 
     WangSet *wangSet() const { return mWangSet; }
 
@@ -277,6 +278,19 @@ class TILEDSHARED_EXPORT WangSet : public Object
     Q_OBJECT
 
 public:
+    /**
+     * The Wang tiles matching a certain wangId, along with the cumulative
+     * probabilities used for picking one of them at random.
+     */
+    struct MatchingWangTiles
+    {
+        QVector<WangTile> wangTiles;
+        QVector<qreal> cumulativeProbabilities;
+
+        bool isEmpty() const { return wangTiles.isEmpty(); }
+        qreal totalProbability() const;
+    };
+
     WangSet(Tileset *tileset,
             const QString &name,
             int imageTileId);
@@ -346,6 +360,19 @@ public:
      */
     QList<WangTile> findMatchingWangTiles(WangId wangId) const;
 
+    /* Returns the Wang tiles matching the given wangId. Like in
+     * findMatchingWangTiles(), zeros are wild cards for the edges or corners
+     * only when there is more than one color for them. The result is looked
+     * up in an index that is built on demand for each combination of wild
+     * cards, and is valid until the Wang set is changed.
+     */
+    const MatchingWangTiles &matchingWangTiles(WangId wangId) const;
+
+    /* Discards the lookup tables used by matchingWangTiles(). Needs to be
+     * called when a probability affecting this Wang set has changed.
+     */
+    void clearMatchCache();
+
     const QMultiHash<WangId, WangTile> &wangTilesByWangId() const { return mWangIdToWangTile; }
 
     /* Returns a sorted list of the wangTiles in this set.
@@ -443,8 +470,24 @@ private:
     // Tile info being the tileId, with the last three bits (32, 31, 30)
     // being info on flip (horizontal, vertical, and antidiagonal)
     QHash<unsigned, WangId> mTileInfoToWangId;
+
+    // One lookup table for each combination of wild cards, mapping the
+    // masked wangIds to the matching Wang tiles
+    mutable QVector<QHash<unsigned, MatchingWangTiles>> mMatchCache;
 };
 
+inline void WangColor::setProbability(qreal probability)
+{
+    mProbability = probability;
+    if (mWangSet)
+        mWangSet->clearMatchCache();
+}
+
+inline qreal WangSet::MatchingWangTiles::totalProbability() const
+{
+    return cumulativeProbabilities.isEmpty() ? 0.0 : cumulativeProbabilities.last();
+}
+
 } // namespace Tiled
 
 Q_DECLARE_METATYPE(Tiled::WangSet*)
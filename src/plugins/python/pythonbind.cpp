@@ -40,6 +40,7 @@ typedef enum _PyBindGenWrapperFlags {
 
 
 #include "pythonplugin.h"
+#include "gidmapper.h"
 #include "grouplayer.h"
 #include "imagelayer.h"
 #include "layer.h"
@@ -6121,6 +6122,45 @@ _wrap_PyTiledTileLayer_cellAt(PyTiledTileLayer *self, PyObject *args, PyObject *
 }
 
 
+PyObject *
+_wrap_PyTiledTileLayer_gids(PyTiledTileLayer *self, PyObject *args, PyObject *kwargs)
+{
+    int x;
+    int y;
+    int w;
+    int h;
+    const char *keywords[] = {"x", "y", "w", "h", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "iiii", (char **) keywords, &x, &y, &w, &h)) {
+        return NULL;
+    }
+    if (w < 0 || h < 0) {
+        PyErr_SetString(PyExc_ValueError, "width and height must not be negative");
+        return NULL;
+    }
+    if (x < 0 || y < 0 ||
+            (qint64) x + w > self->obj->width() ||
+            (qint64) y + h > self->obj->height()) {
+        PyErr_SetString(PyExc_ValueError, "rectangle is not within the layer");
+        return NULL;
+    }
+    Tiled::Map *map = self->obj->map();
+    if (!map) {
+        PyErr_SetString(PyExc_RuntimeError, "layer is not part of a map");
+        return NULL;
+    }
+    PyObject *py_retval = PyByteArray_FromStringAndSize(NULL, (Py_ssize_t) w * h * sizeof(quint32));
+    if (!py_retval) {
+        return NULL;
+    }
+    const Tiled::GidMapper gidMapper(map->tilesets());
+    quint32 *gids = reinterpret_cast<quint32 *>(PyByteArray_AS_STRING(py_retval));
+    for (int j = 0; j < h; ++j)
+        for (int i = 0; i < w; ++i)
+            *gids++ = gidMapper.cellToGid(self->obj->cellAt(x + i, y + j));
+    return py_retval;
+}
+
 PyObject *
 _wrap_PyTiledTileLayer_height(PyTiledTileLayer *self)
 {
@@ -6183,6 +6223,71 @@ _wrap_PyTiledTileLayer_setCell(PyTiledTileLayer *self, PyObject *args, PyObject
 }
 
 
+PyObject *
+_wrap_PyTiledTileLayer_setGids(PyTiledTileLayer *self, PyObject *args, PyObject *kwargs)
+{
+    int x;
+    int y;
+    int w;
+    int h;
+    PyObject *data;
+    Py_buffer view;
+    const char *keywords[] = {"x", "y", "w", "h", "data", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "iiiiO", (char **) keywords, &x, &y, &w, &h, &data)) {
+        return NULL;
+    }
+    if (w < 0 || h < 0) {
+        PyErr_SetString(PyExc_ValueError, "width and height must not be negative");
+        return NULL;
+    }
+    if (x < 0 || y < 0 ||
+            (qint64) x + w > self->obj->width() ||
+            (qint64) y + h > self->obj->height()) {
+        PyErr_SetString(PyExc_ValueError, "rectangle is not within the layer");
+        return NULL;
+    }
+    Tiled::Map *map = self->obj->map();
+    if (!map) {
+        PyErr_SetString(PyExc_RuntimeError, "layer is not part of a map");
+        return NULL;
+    }
+    if (PyObject_GetBuffer(data, &view, PyBUF_C_CONTIGUOUS) != 0) {
+        return NULL;
+    }
+    if (view.len != (Py_ssize_t) w * h * (Py_ssize_t) sizeof(quint32)) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_ValueError, "buffer size does not match the given rectangle");
+        return NULL;
+    }
+    const Tiled::GidMapper gidMapper(map->tilesets());
+    const char *gids = static_cast<const char *>(view.buf);
+    /* Validate all GIDs first, so that the layer is left untouched on error */
+    for (Py_ssize_t index = 0; index < (Py_ssize_t) w * h; ++index) {
+        quint32 gid;
+        memcpy(&gid, gids + index * sizeof(quint32), sizeof(quint32));
+        bool ok;
+        gidMapper.gidToCell(gid, ok);
+        if (!ok) {
+            PyBuffer_Release(&view);
+            PyErr_Format(PyExc_ValueError, "invalid global tile ID: %u", gid);
+            return NULL;
+        }
+    }
+    for (int j = 0; j < h; ++j) {
+        for (int i = 0; i < w; ++i) {
+            quint32 gid;
+            memcpy(&gid, gids, sizeof(quint32));
+            gids += sizeof(quint32);
+            bool ok;
+            self->obj->setCell(x + i, y + j, gidMapper.gidToCell(gid, ok));
+        }
+    }
+    PyBuffer_Release(&view);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
 PyObject *
 _wrap_PyTiledTileLayer_width(PyTiledTileLayer *self)
 {
@@ -6196,10 +6301,12 @@ _wrap_PyTiledTileLayer_width(PyTiledTileLayer *self)
 
 static PyMethodDef PyTiledTileLayer_methods[] = {
     {(char *) "cellAt", (PyCFunction) _wrap_PyTiledTileLayer_cellAt, METH_KEYWORDS|METH_VARARGS, "cellAt(x, y)\n\ntype: x: int\ntype: y: int" },
+    {(char *) "gids", (PyCFunction) _wrap_PyTiledTileLayer_gids, METH_VARARGS|METH_KEYWORDS, NULL },
     {(char *) "height", (PyCFunction) _wrap_PyTiledTileLayer_height, METH_NOARGS, "height()\n\n" },
     {(char *) "isEmpty", (PyCFunction) _wrap_PyTiledTileLayer_isEmpty, METH_NOARGS, "isEmpty()\n\n" },
     {(char *) "referencesTileset", (PyCFunction) _wrap_PyTiledTileLayer_referencesTileset, METH_KEYWORDS|METH_VARARGS, "referencesTileset(ts)\n\ntype: ts: Tileset *" },
     {(char *) "setCell", (PyCFunction) _wrap_PyTiledTileLayer_setCell, METH_KEYWORDS|METH_VARARGS, "setCell(x, y, c)\n\ntype: x: int\ntype: y: int\ntype: c: Cell" },
+    {(char *) "setGids", (PyCFunction) _wrap_PyTiledTileLayer_setGids, METH_VARARGS|METH_KEYWORDS, NULL },
     {(char *) "width", (PyCFunction) _wrap_PyTiledTileLayer_width, METH_NOARGS, "width()\n\n" },
     {NULL, NULL, 0, NULL}
 };
@@ -53,6 +53,7 @@ mod = Module('tiled')
 mod.functions = SimpleSortedDict()
 
 mod.add_include('"pythonplugin.h"')
+mod.add_include('"gidmapper.h"')
 mod.add_include('"grouplayer.h"')
 mod.add_include('"imagelayer.h"')
 mod.add_include('"layer.h"')
@@ -238,6 +239,124 @@ cls_tilelayer.add_method('referencesTileset', 'bool',
     [param('Tileset*','ts',transfer_ownership=False)])
 cls_tilelayer.add_method('isEmpty', 'bool', [])
 
+"""
+ Bulk access to the global tile IDs of a rectangle of a tile layer. The GIDs
+ are packed as native-endian 32-bit unsigned integers, in rows, so they can be
+ used without copying through the buffer protocol, for example using
+ numpy.frombuffer(data, dtype=numpy.uint32). The returned bytearray is
+ writable, so it can be modified in place and passed back to setGids.
+
+ Both raise ValueError when the rectangle is not within the layer. setGids
+ also raises ValueError when the buffer size does not match the rectangle or
+ when it contains an invalid GID, in which case no cells are changed.
+"""
+cls_tilelayer.add_custom_method_wrapper('gids', '_wrap_PyTiledTileLayer_gids', """
+PyObject *
+_wrap_PyTiledTileLayer_gids(PyTiledTileLayer *self, PyObject *args, PyObject *kwargs)
+{
+    int x;
+    int y;
+    int w;
+    int h;
+    const char *keywords[] = {"x", "y", "w", "h", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "iiii", (char **) keywords, &x, &y, &w, &h)) {
+        return NULL;
+    }
+    if (w < 0 || h < 0) {
+        PyErr_SetString(PyExc_ValueError, "width and height must not be negative");
+        return NULL;
+    }
+    if (x < 0 || y < 0 ||
+            (qint64) x + w > self->obj->width() ||
+            (qint64) y + h > self->obj->height()) {
+        PyErr_SetString(PyExc_ValueError, "rectangle is not within the layer");
+        return NULL;
+    }
+    Tiled::Map *map = self->obj->map();
+    if (!map) {
+        PyErr_SetString(PyExc_RuntimeError, "layer is not part of a map");
+        return NULL;
+    }
+    PyObject *py_retval = PyByteArray_FromStringAndSize(NULL, (Py_ssize_t) w * h * sizeof(quint32));
+    if (!py_retval) {
+        return NULL;
+    }
+    const Tiled::GidMapper gidMapper(map->tilesets());
+    quint32 *gids = reinterpret_cast<quint32 *>(PyByteArray_AS_STRING(py_retval));
+    for (int j = 0; j < h; ++j)
+        for (int i = 0; i < w; ++i)
+            *gids++ = gidMapper.cellToGid(self->obj->cellAt(x + i, y + j));
+    return py_retval;
+}
+""", flags=['METH_VARARGS', 'METH_KEYWORDS'])
+cls_tilelayer.add_custom_method_wrapper('setGids', '_wrap_PyTiledTileLayer_setGids', """
+PyObject *
+_wrap_PyTiledTileLayer_setGids(PyTiledTileLayer *self, PyObject *args, PyObject *kwargs)
+{
+    int x;
+    int y;
+    int w;
+    int h;
+    PyObject *data;
+    Py_buffer view;
+    const char *keywords[] = {"x", "y", "w", "h", "data", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, (char *) "iiiiO", (char **) keywords, &x, &y, &w, &h, &data)) {
+        return NULL;
+    }
+    if (w < 0 || h < 0) {
+        PyErr_SetString(PyExc_ValueError, "width and height must not be negative");
+        return NULL;
+    }
+    if (x < 0 || y < 0 ||
+            (qint64) x + w > self->obj->width() ||
+            (qint64) y + h > self->obj->height()) {
+        PyErr_SetString(PyExc_ValueError, "rectangle is not within the layer");
+        return NULL;
+    }
+    Tiled::Map *map = self->obj->map();
+    if (!map) {
+        PyErr_SetString(PyExc_RuntimeError, "layer is not part of a map");
+        return NULL;
+    }
+    if (PyObject_GetBuffer(data, &view, PyBUF_C_CONTIGUOUS) != 0) {
+        return NULL;
+    }
+    if (view.len != (Py_ssize_t) w * h * (Py_ssize_t) sizeof(quint32)) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_ValueError, "buffer size does not match the given rectangle");
+        return NULL;
+    }
+    const Tiled::GidMapper gidMapper(map->tilesets());
+    const char *gids = static_cast<const char *>(view.buf);
+    /* Validate all GIDs first, so that the layer is left untouched on error */
+    for (Py_ssize_t index = 0; index < (Py_ssize_t) w * h; ++index) {
+        quint32 gid;
+        memcpy(&gid, gids + index * sizeof(quint32), sizeof(quint32));
+        bool ok;
+        gidMapper.gidToCell(gid, ok);
+        if (!ok) {
+            PyBuffer_Release(&view);
+            PyErr_Format(PyExc_ValueError, "invalid global tile ID: %u", gid);
+            return NULL;
+        }
+    }
+    for (int j = 0; j < h; ++j) {
+        for (int i = 0; i < w; ++i) {
+            quint32 gid;
+            memcpy(&gid, gids, sizeof(quint32));
+            gids += sizeof(quint32);
+            bool ok;
+            self->obj->setCell(x + i, y + j, gidMapper.gidToCell(gid, ok));
+        }
+    }
+    PyBuffer_Release(&view);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+""", flags=['METH_VARARGS', 'METH_KEYWORDS'])
+
 cls_imagelayer = tiled.add_class('ImageLayer', cls_layer)
 cls_imagelayer.add_constructor([('QString','name'), ('int','x'), ('int','y')])
 cls_imagelayer.add_method('loadFromImage', 'bool',
@@ -246,7 +246,7 @@ void AbstractTileFillTool::updateRandomListAndMissingTilesets()
             mapDocument()->unifyTilesets(variation.map, mMissingTilesets);
             if (mFillMethod == RandomFill) {
                 for (auto layer : variation.map->tileLayers()) {
-                    for (const Cell &cell : *static_cast<TileLayer*>(layer)) {
+                    for (const Cell &cell : *static_cast<const TileLayer*>(layer)) {
                         if (const Tile *tile = cell.tile())
                             mRandomCellPicker.add(cell, tile->probability());
                     }
@@ -0,0 +1,204 @@
+/*
+ * automappingconditions.cpp
+ * Copyright 2010-2012, Stefan Beller, stefanbeller@googlemail.com
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "automappingconditions.h"
+
+#include "tilelayer.h"
+
+#include <QVarLengthArray>
+
+using namespace Tiled;
+
+static int wrap(int value, int bound)
+{
+    return (value % bound + bound) % bound;
+}
+
+/**
+ * Fills \a cells with the list of all cells which can be found within all
+ * tile layers within the given region.
+ */
+static void collectCellsInRegion(const QVector<InputLayer> &list,
+                                 const QRegion &r,
+                                 QVarLengthArray<Cell, 8> &cells)
+{
+    for (const InputLayer &inputLayer : list) {
+#if QT_VERSION < 0x050800
+        const auto rects = r.rects();
+        for (const QRect &rect : rects) {
+#else
+        for (const QRect &rect : r) {
+#endif
+            for (int x = rect.left(); x <= rect.right(); ++x) {
+                for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                    const Cell &cell = inputLayer.tileLayer->cellAt(x, y);
+                    if (!cells.contains(cell))
+                        cells.append(cell);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * This function is one of the core functions for understanding the
+ * automapping.
+ * In this function a certain region (of the set layer) is compared to
+ * several other layers (ruleSet and ruleNotSet).
+ * This comparison will determine if a rule of automapping matches,
+ * so if this rule is applied at this region given
+ * by a QRegion and Offset given by a QPoint.
+ *
+ * This compares the tile layer setLayer to several others given
+ * in the QList listYes (ruleSet) and OList listNo (ruleNotSet).
+ * The tile layer setLayer is examined at QRegion ruleRegion + offset
+ * The tile layers within listYes and listNo are examined at QRegion ruleRegion.
+ *
+ * Basically all matches between setLayer and a layer of listYes are considered
+ * good, while all matches between setLayer and listNo are considered bad and
+ * lead to canceling the comparison, returning false.
+ *
+ * The comparison is done for each position within the QRegion ruleRegion.
+ * If all positions of the region are considered "good" return true.
+ *
+ * Now there are several cases to distinguish:
+ *  - both listYes and listNo are empty:
+ *      This should not happen, because with that configuration, absolutely
+ *      no condition is given.
+ *      return false, assuming this is an errornous rule being applied
+ *
+ *  - both listYes and listNo are not empty:
+ *      When comparing a tile at a certain position of tile layer setLayer
+ *      to all available tiles in listYes, there must be at least
+ *      one layer, in which there is a match of tiles of setLayer and
+ *      listYes to consider this position good.
+ *      In listNo there must not be a match to consider this position
+ *      good.
+ *      If there are no tiles within all available tiles within all layers
+ *      of one list, all tiles in setLayer are considered good,
+ *      while inspecting this list.
+ *      All available tiles are all tiles within the whole rule region in
+ *      all tile layers of the list.
+ *
+ *  - either of both lists are not empty
+ *      When comparing a certain position of tile layer setLayer
+ *      to all Tiles at the corresponding position this can happen:
+ *      A tile of setLayer matches a tile of a layer in the list. Then this
+ *      is considered as good, if the layer is from the listYes.
+ *      Otherwise it is considered bad.
+ *
+ *      Exception, when having only the listYes:
+ *      if at the examined position there are no tiles within all Layers
+ *      of the listYes, all tiles except all used tiles within
+ *      the layers of that list are considered good.
+ *
+ *      This exception was added to have a better functionality
+ *      (need of less layers.)
+ *      It was not added to the case, when having only listNo layers to
+ *      avoid total symmetry between those lists.
+ *      It can be turned off by setting the StrictEmpty property on the input
+ *      layer.
+ *
+ * If all positions are considered good, return true.
+ * return false otherwise.
+ *
+ * @return bool, if the tile layer matches the given list of layers.
+ */
+bool Tiled::layerMatchesConditions(const TileLayer &setLayer,
+                                   const InputConditions &conditions,
+                                   const QRegion &ruleRegion,
+                                   const QPoint offset,
+                                   const AutoMapper::Options &options)
+{
+    const auto &listYes = conditions.listYes;
+    const auto &listNo = conditions.listNo;
+    if (listYes.isEmpty() && listNo.isEmpty())
+        return false;
+
+    QVarLengthArray<Cell, 8> cells;
+    if (listNo.isEmpty())
+        collectCellsInRegion(listYes, ruleRegion, cells);
+
+#if QT_VERSION < 0x050800
+    const auto rects = ruleRegion.rects();
+    for (const QRect &rect : rects) {
+#else
+    for (const QRect &rect : ruleRegion) {
+#endif
+        for (int x = rect.left(); x <= rect.right(); ++x) {
+            for (int y = rect.top(); y <= rect.bottom(); ++y) {
+                int xd = x + offset.x();
+                int yd = y + offset.y();
+
+                if (!options.matchOutsideMap && !setLayer.contains(xd, yd))
+                    return false;
+
+                // Those two options are guaranteed to be false if the map is infinite,
+                // so no "invalid" width/height accessing here.
+                if (options.wrapBorder) {
+                    xd = wrap(xd, setLayer.width());
+                    yd = wrap(yd, setLayer.height());
+                } else if (options.overflowBorder) {
+                    xd = qBound(0, xd, setLayer.width() - 1);
+                    yd = qBound(0, yd, setLayer.height() - 1);
+                }
+
+                const Cell &setCell = setLayer.cellAt(xd, yd);
+
+                // First check listNo. If any tile matches there, we can
+                // immediately know there is no match.
+                for (const InputLayer &inputNotLayer : listNo) {
+                    const Cell &noCell = inputNotLayer.tileLayer->cellAt(x, y);
+                    if ((inputNotLayer.strictEmpty || !noCell.isEmpty()) && setCell == noCell)
+                        return false;
+                }
+
+                // ruleDefinedListYes will be set when there is a tile in at
+                // least one layer. If there is a tile in at least one layer,
+                // only the given tiles in the different listYes layers are
+                // valid. Otherwise, consider all tiles not used elsewhere in
+                // the input as valid.
+                bool ruleDefinedListYes = false;
+                bool matchListYes = false;
+
+                for (const InputLayer &inputLayer : listYes) {
+                    const Cell &yesCell = inputLayer.tileLayer->cellAt(x, y);
+                    if (inputLayer.strictEmpty || !yesCell.isEmpty()) {
+                        ruleDefinedListYes = true;
+                        if (setCell == yesCell) {
+                            matchListYes = true;
+                            break;
+                        }
+                    }
+                }
+
+                if (!ruleDefinedListYes) {
+                    // if there were only layers in the listYes, check the exception
+                    if (listNo.isEmpty() && cells.contains(setCell))
+                        return false;
+                } else if (!matchListYes) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,44 @@
+/*
+ * automappingconditions.h
+ * Copyright 2010-2012, Stefan Beller, stefanbeller@googlemail.com
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "automapper.h"
+
+#include <QPoint>
+#include <QRegion>
+
+namespace Tiled {
+
+class TileLayer;
+
+/**
+ * Returns whether the rule with the given input \a conditions matches
+ * \a setLayer at \a offset. This is the core of the rule matching done by
+ * AutoMapper::autoMap(), kept separate from the AutoMapper since it does
+ * not depend on the map document.
+ */
+bool layerMatchesConditions(const TileLayer &setLayer,
+                            const InputConditions &conditions,
+                            const QRegion &ruleRegion,
+                            QPoint offset,
+                            const AutoMapper::Options &options);
+
+} // namespace Tiled
@@ -0,0 +1,350 @@
+/*
+ * batchexporter.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "batchexporter.h"
+
+#include "exporthelper.h"
+#include "map.h"
+#include "mapformat.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QTextStream>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace Tiled {
+
+namespace {
+
+/**
+ * The maps that have been written, waiting to be deleted by the thread that
+ * read them. Deleting a map releases its tilesets and the pixmaps of its
+ * image layers, which may only be done on the main thread.
+ */
+class FinishedMaps
+{
+public:
+    void add(std::unique_ptr<Map> map)
+    {
+        QMutexLocker locker(&mMutex);
+        mMaps.push_back(std::move(map));
+    }
+
+    void deleteAll()
+    {
+        // Declared before the locker, so that the maps are deleted after the
+        // mutex has been unlocked
+        std::vector<std::unique_ptr<Map>> maps;
+
+        QMutexLocker locker(&mMutex);
+        maps.swap(mMaps);
+    }
+
+private:
+    QMutex mMutex;
+    std::vector<std::unique_ptr<Map>> mMaps;
+};
+
+/**
+ * Writes a single prepared map on a worker thread. Once written, the map is
+ * handed to \a finishedMaps, to be deleted on the main thread.
+ *
+ * Map formats may keep state like their last error in members, so writes
+ * using the same format are serialized through \a formatMutex.
+ */
+class WriteMapTask : public QRunnable
+{
+public:
+    WriteMapTask(std::unique_ptr<Map> map,
+                 MapFormat *format,
+                 QMutex &formatMutex,
+                 const QString &targetFile,
+                 FileFormat::Options options,
+                 BatchExporter::Result &result,
+                 FinishedMaps &finishedMaps,
+                 QSemaphore &pending)
+        : mMap(std::move(map))
+        , mFormat(format)
+        , mFormatMutex(formatMutex)
+        , mTargetFile(targetFile)
+        , mOptions(options)
+        , mResult(result)
+        , mFinishedMaps(finishedMaps)
+        , mPending(pending)
+    {}
+
+    void run() override
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        {
+            QMutexLocker locker(&mFormatMutex);
+            mResult.success = mFormat->write(mMap.get(), mTargetFile, mOptions);
+            if (!mResult.success)
+                mResult.error = mFormat->errorString();
+        }
+
+        mResult.writeTime = timer.elapsed();
+        mFinishedMaps.add(std::move(mMap));
+        mPending.release();
+    }
+
+private:
+    std::unique_ptr<Map> mMap;
+    MapFormat *mFormat;
+    QMutex &mFormatMutex;
+    const QString mTargetFile;
+    const FileFormat::Options mOptions;
+    BatchExporter::Result &mResult;
+    FinishedMaps &mFinishedMaps;
+    QSemaphore &mPending;
+};
+
+bool isWildcardPattern(const QString &path)
+{
+    return path.contains(QLatin1Char('*')) ||
+            path.contains(QLatin1Char('?')) ||
+            path.contains(QLatin1Char('['));
+}
+
+} // anonymous namespace
+
+BatchExporter::BatchExporter(Preferences::ExportOptions options,
+                             const QString *formatFilter)
+    : mOptions(options)
+    , mHasFormatFilter(formatFilter != nullptr)
+    , mFormatFilter(formatFilter ? *formatFilter : QString())
+{
+}
+
+/**
+ * Reads the list of jobs from the given manifest \a fileName. Returns false
+ * and sets \a error when the manifest could not be read or contains a
+ * malformed line.
+ */
+bool BatchExporter::readManifest(const QString &fileName, QString *error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (error)
+            *error = tr("Could not open manifest: %1").arg(file.errorString());
+        return false;
+    }
+
+    const QDir baseDir = QFileInfo(fileName).dir();
+    QTextStream stream(&file);
+    int lineNumber = 0;
+
+    while (!stream.atEnd()) {
+        const QString line = stream.readLine().trimmed();
+        ++lineNumber;
+
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#')))
+            continue;
+
+        const QStringList parts = line.split(QLatin1Char('\t'), QString::SkipEmptyParts);
+        if (parts.size() != 2) {
+            if (error)
+                *error = tr("Line %1: expected \"<source>\\t<target>\"").arg(lineNumber);
+            return false;
+        }
+
+        const QString source = baseDir.absoluteFilePath(parts.at(0).trimmed());
+        const QString target = baseDir.absoluteFilePath(parts.at(1).trimmed());
+
+        if (!isWildcardPattern(source)) {
+            addJob(source, target);
+            continue;
+        }
+
+        const QFileInfo sourceInfo(source);
+        const QDir sourceDir = sourceInfo.dir();
+        const auto matches = sourceDir.entryInfoList(QStringList(sourceInfo.fileName()),
+                                                     QDir::Files | QDir::Readable,
+                                                     QDir::Name);
+
+        if (matches.isEmpty())
+            qWarning().noquote() << tr("Line %1: no files match %2").arg(lineNumber).arg(source);
+
+        for (const QFileInfo &match : matches) {
+            QString matchTarget = target;
+            matchTarget.replace(QLatin1Char('*'), match.completeBaseName());
+            addJob(match.absoluteFilePath(), matchTarget);
+        }
+    }
+
+    return true;
+}
+
+void BatchExporter::addJob(const QString &sourceFile, const QString &targetFile)
+{
+    mJobs.append(Job { sourceFile, targetFile });
+}
+
+int BatchExporter::exec()
+{
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
+    mResults.clear();
+    mResults.resize(mJobs.size());
+
+    const ExportHelper exportHelper(mOptions);
+    const FileFormat::Options formatOptions = exportHelper.formatOptions();
+
+    // Limits the amount of maps that are loaded but not yet written, so
+    // memory use stays bounded when reading is faster than writing.
+    QSemaphore pending(mParallelJobs * 2);
+
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(mParallelJobs);
+
+    FinishedMaps finishedMaps;
+
+    std::map<MapFormat*, std::unique_ptr<QMutex>> formatMutexes;
+
+    for (int i = 0; i < mJobs.size(); ++i) {
+        const Job &job = mJobs.at(i);
+        Result &result = mResults[i];
+
+        finishedMaps.deleteAll();
+
+        QElapsedTimer timer;
+        timer.start();
+
+        MapFormat *format = formatForTarget(job.targetFile, result.error);
+        if (!format)
+            continue;
+
+        std::unique_ptr<Map> sourceMap = readMap(job.sourceFile, &result.error);
+        if (!sourceMap) {
+            if (result.error.isEmpty())
+                result.error = tr("Failed to load source map.");
+            continue;
+        }
+
+        // Keep the tilesets alive, so that other maps referring to the same
+        // external tilesets can pick them up from the TilesetManager.
+        for (const SharedTileset &tileset : sourceMap->tilesets())
+            if (tileset->isExternal())
+                mTilesetCache.insert(tileset);
+
+        std::unique_ptr<Map> exportMap;
+        exportHelper.prepareExportMap(sourceMap.get(), exportMap);
+        if (!exportMap)
+            exportMap = std::move(sourceMap);
+
+        result.readTime = timer.elapsed();
+
+        pending.acquire();
+
+        auto &formatMutex = formatMutexes[format];
+        if (!formatMutex)
+            formatMutex.reset(new QMutex);
+
+        auto task = new WriteMapTask(std::move(exportMap), format, *formatMutex,
+                                     job.targetFile, formatOptions,
+                                     result, finishedMaps, pending);
+
+        if (mParallelJobs > 1) {
+            threadPool.start(task);
+        } else {
+            task->run();
+            delete task;
+        }
+    }
+
+    threadPool.waitForDone();
+    finishedMaps.deleteAll();
+
+    mTotalTime = totalTimer.elapsed();
+    mTilesetCache.clear();
+
+    report();
+
+    return std::count_if(mResults.cbegin(), mResults.cend(),
+                         [] (const Result &result) { return !result.success; });
+}
+
+MapFormat *BatchExporter::formatForTarget(const QString &targetFile, QString &error)
+{
+    const QString key = mHasFormatFilter ? QString()
+                                         : QFileInfo(targetFile).completeSuffix().toLower();
+
+    auto it = mFormatsBySuffix.constFind(key);
+    if (it != mFormatsBySuffix.constEnd())
+        return it.value();
+
+    MapFormat *format = findExportFormat<MapFormat>(mHasFormatFilter ? &mFormatFilter : nullptr,
+                                                    targetFile, error);
+    if (format)
+        mFormatsBySuffix.insert(key, format);
+
+    return format;
+}
+
+/**
+ * Prints one line for each job, followed by a summary. Each line has the form
+ * "<status>\t<read ms>\t<write ms>\t<source>\t<target>[\t<error>]", which
+ * makes it easy to process the output of large batches with other tools.
+ */
+void BatchExporter::report() const
+{
+    int failures = 0;
+
+    for (int i = 0; i < mJobs.size(); ++i) {
+        const Job &job = mJobs.at(i);
+        const Result &result = mResults.at(i);
+
+        QString line = QStringLiteral("%1\t%2\t%3\t%4\t%5")
+                .arg(result.success ? QStringLiteral("OK") : QStringLiteral("FAILED"))
+                .arg(result.readTime)
+                .arg(result.writeTime)
+                .arg(QDir::toNativeSeparators(job.sourceFile),
+                     QDir::toNativeSeparators(job.targetFile));
+
+        if (!result.success) {
+            line += QLatin1Char('\t') + result.error;
+            ++failures;
+        }
+
+        qWarning().noquote() << line;
+    }
+
+    qWarning().noquote() << tr("Exported %1 of %2 maps in %3 ms")
+                            .arg(mJobs.size() - failures)
+                            .arg(mJobs.size())
+                            .arg(mTotalTime);
+}
+
+} // namespace Tiled
@@ -0,0 +1,112 @@
+/*
+ * batchexporter.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "preferences.h"
+#include "tileset.h"
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+namespace Tiled {
+
+class MapFormat;
+
+/**
+ * Exports many maps within a single process.
+ *
+ * The list of maps to export is read from a manifest file. Each non-empty
+ * line that does not start with '#' has the form "<source>\t<target>". The
+ * source may be a wildcard pattern, in which case any '*' in the target is
+ * replaced by the base name of each matching source file. Relative paths
+ * are resolved against the directory of the manifest.
+ *
+ * Tilesets loaded for one map are kept alive for the duration of the batch,
+ * so that maps sharing external tilesets only load them once. Maps are read
+ * on the calling thread, since tileset resolution and image loading are not
+ * thread-safe, while writing the exported files can be spread over multiple
+ * threads. For the same reason, written maps are handed back to the calling
+ * thread to be deleted. Writes using the same map format are serialized, since formats
+ * may store state like their last error in members.
+ */
+class BatchExporter
+{
+    Q_DECLARE_TR_FUNCTIONS(BatchExporter)
+
+public:
+    struct Job
+    {
+        QString sourceFile;
+        QString targetFile;
+    };
+
+    struct Result
+    {
+        bool success = false;
+        QString error;
+        qint64 readTime = 0;
+        qint64 writeTime = 0;
+    };
+
+    BatchExporter(Preferences::ExportOptions options,
+                  const QString *formatFilter = nullptr);
+
+    bool readManifest(const QString &fileName, QString *error);
+
+    void addJob(const QString &sourceFile, const QString &targetFile);
+    const QVector<Job> &jobs() const { return mJobs; }
+
+    /**
+     * Sets the maximum number of maps that are written in parallel. The
+     * default is 1, which writes each map on the calling thread. Maps using
+     * the same format are still written one at a time, but their writing
+     * overlaps with the reading of the next maps.
+     */
+    void setParallelJobs(int count) { mParallelJobs = qMax(1, count); }
+
+    /**
+     * Runs all jobs and reports the outcome of each of them. Returns the
+     * number of failed exports.
+     */
+    int exec();
+
+    const QVector<Result> &results() const { return mResults; }
+
+private:
+    MapFormat *formatForTarget(const QString &targetFile, QString &error);
+    void report() const;
+
+    const Preferences::ExportOptions mOptions;
+    const bool mHasFormatFilter;
+    const QString mFormatFilter;
+    int mParallelJobs = 1;
+
+    QVector<Job> mJobs;
+    QVector<Result> mResults;
+    QHash<QString, MapFormat*> mFormatsBySuffix;
+    QSet<SharedTileset> mTilesetCache;
+    qint64 mTotalTime = 0;
+};
+
+} // namespace Tiled
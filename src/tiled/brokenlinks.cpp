@@ -27,6 +27,7 @@
 #include "map.h"
 #include "objectgroup.h"
 #include "preferences.h"
+#include "projectindex.h"
 #include "replacetemplate.h"
 #include "replacetileset.h"
 #include "templatemanager.h"
@@ -55,6 +56,31 @@
 
 namespace Tiled {
 
+/**
+ * Looks for a file with the same name as the missing file at \a filePath in
+ * the current project. Returns its path when exactly one such file of the
+ * given \a type was found.
+ */
+static QString findInProject(const QString &filePath, AssetInfo::Type type)
+{
+    const ProjectIndex *projectIndex = ProjectIndex::instance();
+    if (!projectIndex)
+        return QString();
+
+    QString result;
+
+    const QStringList candidates = projectIndex->filesNamed(QFileInfo(filePath).fileName());
+    for (const QString &candidate : candidates) {
+        if (projectIndex->assets().value(candidate).type != type)
+            continue;
+        if (!result.isEmpty())
+            return QString();   // ambiguous
+        result = candidate;
+    }
+
+    return result;
+}
+
 QString BrokenLink::filePath() const
 {
     switch (type) {
@@ -563,6 +589,10 @@ void LinkFixer::tryFixLink(const BrokenLink &link)
             return;
         }
 
+        const QString projectFile = findInProject(link.filePath(), AssetInfo::Image);
+        if (!projectFile.isEmpty() && tryFixLink(link, projectFile))
+            return;
+
         QUrl newFileUrl = locateImage(QFileInfo(link.filePath()).fileName());
         if (newFileUrl.isEmpty())
             return;
@@ -700,6 +730,10 @@ QString LinkFixer::locateObjectTemplate()
 
 void LinkFixer::tryFixMapTilesetReference(const SharedTileset &tileset)
 {
+    const QString projectFile = findInProject(tileset->fileName(), AssetInfo::Tileset);
+    if (!projectFile.isEmpty() && tryFixMapTilesetReference(tileset, projectFile))
+        return;
+
     QString fileName = locateTileset();
     if (!fileName.isEmpty())
         tryFixMapTilesetReference(tileset, fileName);
@@ -707,6 +741,10 @@ void LinkFixer::tryFixMapTilesetReference(const SharedTileset &tileset)
 
 void LinkFixer::tryFixObjectTemplateReference(const ObjectTemplate *objectTemplate)
 {
+    const QString projectFile = findInProject(objectTemplate->fileName(), AssetInfo::Template);
+    if (!projectFile.isEmpty() && tryFixObjectTemplateReference(objectTemplate, projectFile))
+        return;
+
     QString fileName = locateObjectTemplate();
     if (!fileName.isEmpty())
         tryFixObjectTemplateReference(objectTemplate, fileName);
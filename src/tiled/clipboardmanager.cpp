@@ -21,6 +21,8 @@
 #include "clipboardmanager.h"
 
 #include "addremovemapobject.h"
+#include "gidmapper.h"
+#include "logginginterface.h"
 #include "map.h"
 #include "mapdocument.h"
 #include "mapobject.h"
@@ -34,6 +36,7 @@
 
 #include <QApplication>
 #include <QClipboard>
+#include <QDataStream>
 #include <QJsonDocument>
 #include <QMimeData>
 #include <QSet>
@@ -42,9 +45,213 @@
 #include <algorithm>
 
 static const char * const TMX_MIMETYPE = "text/tmx";
+static const char * const MAP_MIMETYPE = "application/x-tiled-map";
 
 using namespace Tiled;
 
+namespace {
+
+const quint32 BinaryMapVersion = 2;
+
+/**
+ * Writes the given \a map in a compact binary format, used to copy maps
+ * between Tiled instances.
+ *
+ * Everything except for the tile layer data is stored as TMX. The tile
+ * layers are written as chunks of raw global tile IDs, which is a lot
+ * faster to write and read than the TMX layer data formats.
+ *
+ * The first global ID of each tileset is written as well, since another
+ * instance may not assign the same ones when its version of an external
+ * tileset has a different number of tiles.
+ */
+QByteArray mapToBinary(const Map &map)
+{
+    // Write everything except the tile layer data as TMX. Making the map
+    // infinite avoids writing the empty tile layers in full.
+    auto skeleton = map.clone();
+    skeleton->setInfinite(true);
+
+    LayerIterator skeletonIterator(skeleton.get(), Layer::TileLayerType);
+    while (Layer *layer = skeletonIterator.next())
+        static_cast<TileLayer*>(layer)->clear();
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_6);
+
+    stream << BinaryMapVersion
+           << map.infinite()
+           << TmxMapFormat().toByteArray(skeleton.get());
+
+    GidMapper gidMapper;
+    quint32 firstGid = 1;
+
+    stream << static_cast<quint32>(map.tilesetCount());
+    for (const SharedTileset &tileset : map.tilesets()) {
+        stream << firstGid;
+        gidMapper.insert(firstGid, tileset);
+        firstGid += tileset->nextTileId();
+    }
+
+    LayerIterator iterator(&map, Layer::TileLayerType);
+    while (const Layer *layer = iterator.next()) {
+        auto tileLayer = static_cast<const TileLayer*>(layer);
+        const auto chunks = tileLayer->sortedChunksToWrite(QSize(CHUNK_SIZE, CHUNK_SIZE));
+
+        stream << static_cast<qint32>(chunks.size());
+
+        for (const QRect &rect : chunks) {
+            stream << static_cast<qint32>(rect.x()) << static_cast<qint32>(rect.y());
+
+            for (int y = rect.top(); y <= rect.bottom(); ++y)
+                for (int x = rect.left(); x <= rect.right(); ++x)
+                    stream << static_cast<quint32>(gidMapper.cellToGid(tileLayer->cellAt(x, y)));
+        }
+    }
+
+    return data;
+}
+
+/**
+ * Reads a map written by mapToBinary(). Returns null when the data could
+ * not be read.
+ *
+ * Tiles that can't be found in the tilesets as loaded by this instance are
+ * left out, which is reported as a warning.
+ */
+std::unique_ptr<Map> mapFromBinary(const QByteArray &data)
+{
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_6);
+
+    quint32 version;
+    bool infinite;
+    QByteArray tmx;
+
+    stream >> version;
+    if (version != BinaryMapVersion)
+        return nullptr;
+
+    stream >> infinite >> tmx;
+    if (stream.status() != QDataStream::Ok)
+        return nullptr;
+
+    TmxMapFormat format;
+    auto map = format.fromByteArray(tmx);
+    if (!map)
+        return nullptr;
+
+    map->setInfinite(infinite);
+
+    quint32 tilesetCount;
+    stream >> tilesetCount;
+    if (stream.status() != QDataStream::Ok)
+        return nullptr;
+    if (tilesetCount != static_cast<quint32>(map->tilesetCount()))
+        return nullptr;
+
+    GidMapper gidMapper;
+    for (const SharedTileset &tileset : map->tilesets()) {
+        quint32 firstGid;
+        stream >> firstGid;
+        gidMapper.insert(firstGid, tileset);
+    }
+
+    int invalidTileCount = 0;
+    unsigned firstInvalidTile = 0;
+
+    LayerIterator iterator(map.get(), Layer::TileLayerType);
+    while (Layer *layer = iterator.next()) {
+        auto tileLayer = static_cast<TileLayer*>(layer);
+
+        qint32 chunkCount;
+        stream >> chunkCount;
+
+        for (qint32 chunk = 0; chunk < chunkCount && stream.status() == QDataStream::Ok; ++chunk) {
+            qint32 chunkX, chunkY;
+            stream >> chunkX >> chunkY;
+
+            for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; ++i) {
+                quint32 gid;
+                stream >> gid;
+                if (gid == 0)
+                    continue;
+
+                bool ok;
+                const Cell cell = gidMapper.gidToCell(gid, ok);
+                if (ok) {
+                    tileLayer->setCell(chunkX + (i & CHUNK_MASK), chunkY + i / CHUNK_SIZE, cell);
+                } else if (invalidTileCount++ == 0) {
+                    firstInvalidTile = gid;
+                }
+            }
+        }
+
+        if (stream.status() != QDataStream::Ok)
+            return nullptr;
+    }
+
+    if (invalidTileCount > 0) {
+        WARNING(ClipboardManager::tr("Pasted map refers to %n missing tile(s), starting with invalid tile: %1",
+                                     nullptr, invalidTileCount).arg(firstInvalidTile));
+    }
+
+    return map;
+}
+
+/**
+ * Holds a copied map. Its TMX and binary representations are only created
+ * when they are actually requested, which usually only happens when pasting
+ * into another application or another Tiled instance.
+ */
+class MapMimeData : public QMimeData
+{
+public:
+    explicit MapMimeData(std::unique_ptr<Map> map)
+        : mMap(std::move(map))
+    {}
+
+    const Map &map() const { return *mMap; }
+
+    QStringList formats() const override
+    {
+        return QStringList { QLatin1String(MAP_MIMETYPE),
+                             QLatin1String(TMX_MIMETYPE) };
+    }
+
+    bool hasFormat(const QString &mimeType) const override
+    {
+        return mimeType == QLatin1String(MAP_MIMETYPE) ||
+                mimeType == QLatin1String(TMX_MIMETYPE);
+    }
+
+protected:
+    QVariant retrieveData(const QString &mimeType, QVariant::Type type) const override
+    {
+        if (mimeType == QLatin1String(MAP_MIMETYPE)) {
+            if (mBinary.isEmpty())
+                mBinary = mapToBinary(*mMap);
+            return mBinary;
+        }
+
+        if (mimeType == QLatin1String(TMX_MIMETYPE)) {
+            if (mTmx.isEmpty())
+                mTmx = TmxMapFormat().toByteArray(mMap.get());
+            return mTmx;
+        }
+
+        return QMimeData::retrieveData(mimeType, type);
+    }
+
+private:
+    const std::unique_ptr<const Map> mMap;
+    mutable QByteArray mBinary;
+    mutable QByteArray mTmx;
+};
+
+} // anonymous namespace
+
 ClipboardManager::ClipboardManager()
     : mClipboard(QApplication::clipboard())
     , mHasMap(false)
@@ -71,6 +278,27 @@ ClipboardManager *ClipboardManager::instance()
 std::unique_ptr<Map> ClipboardManager::map() const
 {
     const QMimeData *mimeData = mClipboard->mimeData();
+    if (!mimeData)
+        return nullptr;
+
+    // When the map was copied by this instance, avoid serialization entirely
+    if (auto mapMimeData = dynamic_cast<const MapMimeData*>(mimeData)) {
+        auto map = mapMimeData->map().clone();
+
+        // Embedded tilesets are copied, like when the map is read from TMX
+        const auto tilesets = map->tilesets();
+        for (const SharedTileset &tileset : tilesets)
+            if (!tileset->isExternal())
+                map->replaceTileset(tileset, tileset->clone());
+
+        return map;
+    }
+
+    if (mimeData->hasFormat(QLatin1String(MAP_MIMETYPE))) {
+        if (auto map = mapFromBinary(mimeData->data(QLatin1String(MAP_MIMETYPE))))
+            return map;
+    }
+
     const QByteArray data = mimeData->data(QLatin1String(TMX_MIMETYPE));
     if (data.isEmpty())
         return nullptr;
@@ -84,12 +312,18 @@ std::unique_ptr<Map> ClipboardManager::map() const
  */
 void ClipboardManager::setMap(const Map &map)
 {
-    TmxMapFormat format;
-
-    QMimeData *mimeData = new QMimeData;
-    mimeData->setData(QLatin1String(TMX_MIMETYPE), format.toByteArray(&map));
+    setMap(map.clone());
+}
 
-    mClipboard->setMimeData(mimeData);
+/**
+ * Sets the given map on the clipboard, taking ownership of it.
+ *
+ * The map is kept in memory and is only converted to TMX or the binary
+ * format used between Tiled instances when another application asks for it.
+ */
+void ClipboardManager::setMap(std::unique_ptr<Map> map)
+{
+    mClipboard->setMimeData(new MapMimeData(std::move(map)));
 }
 
 Properties ClipboardManager::properties() const
@@ -129,11 +363,11 @@ bool ClipboardManager::copySelection(const MapDocument &mapDocument)
     const QRect selectionBounds = selectedArea.boundingRect();
 
     // Create a temporary map to write to the clipboard
-    Map copyMap(map->orientation(),
-                selectionBounds.width(),
-                selectionBounds.height(),
-                map->tileWidth(), map->tileHeight());
-    copyMap.setRenderOrder(map->renderOrder());
+    auto copyMap = std::make_unique<Map>(map->orientation(),
+                                         selectionBounds.width(),
+                                         selectionBounds.height(),
+                                         map->tileWidth(), map->tileHeight());
+    copyMap->setRenderOrder(map->renderOrder());
 
     bool tileLayerSelected = std::any_of(selectedLayers.begin(), selectedLayers.end(),
                                          [] (Layer *layer) { return layer->isTileLayer(); });
@@ -156,7 +390,7 @@ bool ClipboardManager::copySelection(const MapDocument &mapDocument)
                 copyLayer->setName(tileLayer->name());
                 copyLayer->setPosition(area.boundingRect().topLeft());
 
-                copyMap.addLayer(std::move(copyLayer));
+                copyMap->addLayer(std::move(copyLayer));
                 break;
             }
             case Layer::ObjectGroupType: // todo: maybe it makes to group selected objects by layer
@@ -176,15 +410,15 @@ bool ClipboardManager::copySelection(const MapDocument &mapDocument)
             ObjectGroup *objectGroup = new ObjectGroup;
             for (const MapObject *mapObject : selectedObjects)
                 objectGroup->addObject(mapObject->clone());
-            copyMap.addLayer(objectGroup);
+            copyMap->addLayer(objectGroup);
         }
     }
 
-    if (copyMap.layerCount() > 0) {
+    if (copyMap->layerCount() > 0) {
         // Resolve the set of tilesets used by the created map
-        copyMap.addTilesets(copyMap.usedTilesets());
+        copyMap->addTilesets(copyMap->usedTilesets());
 
-        setMap(copyMap);
+        setMap(std::move(copyMap));
         return true;
     }
 
@@ -256,7 +490,8 @@ void ClipboardManager::update()
     bool hasProperties = false;
 
     if (const QMimeData *data = mClipboard->mimeData()) {
-        hasMap = data->hasFormat(QLatin1String(TMX_MIMETYPE));
+        hasMap = data->hasFormat(QLatin1String(MAP_MIMETYPE)) ||
+                data->hasFormat(QLatin1String(TMX_MIMETYPE));
         hasProperties = data->hasFormat(QLatin1String(PROPERTIES_MIMETYPE));
     }
 
@@ -52,6 +52,7 @@ public:
     bool hasMap() const;
     std::unique_ptr<Map> map() const;
     void setMap(const Map &map);
+    void setMap(std::unique_ptr<Map> map);
 
     bool hasProperties() const;
     Properties properties() const;
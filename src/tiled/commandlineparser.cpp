@@ -47,6 +47,19 @@ void CommandLineParser::registerOption(Callback callback,
         mLongestArgument = length;
 }
 
+void CommandLineParser::registerOption(ValueCallback callback,
+                                       void *data,
+                                       const QString &longName,
+                                       const QString &valueName,
+                                       const QString &help)
+{
+    mOptions.append(Option(callback, data, longName, valueName, help));
+
+    const int length = longName.length() + valueName.length() + 1;
+    if (mLongestArgument < length)
+        mLongestArgument = length;
+}
+
 bool CommandLineParser::parse(const QStringList &arguments)
 {
     mFilesToOpen.clear();
@@ -86,7 +99,7 @@ bool CommandLineParser::parse(const QStringList &arguments)
                 continue;
             }
 
-            if (!handleLongOption(arg)) {
+            if (!handleLongOption(arg, todo)) {
                 qWarning().noquote() << tr("Unknown long argument %1: %2").arg(index).arg(arg);
                 mShowHelp = true;
                 break;
@@ -123,7 +136,13 @@ void CommandLineParser::showHelp() const
     qWarning("  -h %-*s : %s", mLongestArgument, "--help", qUtf8Printable(tr("Display this help")));
 
     for (const Option &option : mOptions) {
-        if (!option.shortName.isNull()) {
+        if (option.valueCallback) {
+            const QString argument = option.longName + QLatin1Char(' ') + option.valueName;
+            qWarning("     %-*s : %s",
+                     mLongestArgument,
+                     qUtf8Printable(argument),
+                     qUtf8Printable(option.help));
+        } else if (!option.shortName.isNull()) {
             qWarning("  -%c %-*s : %s",
                      option.shortName.toLatin1(),
                      mLongestArgument,
@@ -140,7 +159,7 @@ void CommandLineParser::showHelp() const
     qWarning();
 }
 
-bool CommandLineParser::handleLongOption(const QString &longName)
+bool CommandLineParser::handleLongOption(const QString &longName, QStringList &todo)
 {
     if (longName == QLatin1String("--help")) {
         mShowHelp = true;
@@ -148,10 +167,20 @@ bool CommandLineParser::handleLongOption(const QString &longName)
     }
 
     for (const Option &option : qAsConst(mOptions)) {
-        if (longName == option.longName) {
+        if (longName != option.longName)
+            continue;
+
+        if (option.valueCallback) {
+            if (todo.isEmpty()) {
+                qWarning().noquote() << tr("Missing value for argument %1").arg(longName);
+                mShowHelp = true;
+                return true;
+            }
+            option.valueCallback(option.data, todo.takeFirst());
+        } else {
             option.callback(option.data);
-            return true;
         }
+        return true;
     }
 
     return false;
@@ -32,6 +32,12 @@ namespace Tiled {
  */
 typedef void (*Callback)(void *data);
 
+/**
+ * C-style callback function taking an arbitrary data pointer and the value
+ * that was passed to an option.
+ */
+typedef void (*ValueCallback)(void *data, const QString &value);
+
 /**
  * A template function that will static-cast the given \a object to a type T
  * and call the member function of T given in the second template argument.
@@ -43,6 +49,16 @@ void MemberFunctionCall(void *object)
     (t->*memberFunction)();
 }
 
+/**
+ * Like MemberFunctionCall, but for member functions taking the option value.
+ */
+template<typename T, void (T::*memberFunction)(const QString &)>
+void MemberFunctionValueCall(void *object, const QString &value)
+{
+    T *t = static_cast<T*>(object);
+    (t->*memberFunction)(value);
+}
+
 
 /**
  * A simple command line parser. Options should be registered through
@@ -90,6 +106,36 @@ public:
                        help);
     }
 
+    /**
+     * Registers an option that takes a value. The value is the argument
+     * following the option, and is passed to \a callback along with \a data.
+     * Only long options can take a value.
+     */
+    void registerOption(ValueCallback callback,
+                        void *data,
+                        const QString &longName,
+                        const QString &valueName,
+                        const QString &help);
+
+    /**
+     * Convenience overload for registering an option taking a value, with a
+     * member function as callback.
+     *
+     * \overload
+     */
+    template <typename T, void (T::*memberFunction)(const QString &)>
+    void registerOption(T *handler,
+                        const QString &longName,
+                        const QString &valueName,
+                        const QString &help)
+    {
+        registerOption(&MemberFunctionValueCall<T, memberFunction>,
+                       handler,
+                       longName,
+                       valueName,
+                       help);
+    }
+
     /**
      * Parses the given \a arguments. Returns false when the application is not
      * expected to run (either there was a parsing error, or the help was
@@ -105,7 +151,7 @@ public:
 private:
     void showHelp() const;
 
-    bool handleLongOption(const QString &longName);
+    bool handleLongOption(const QString &longName, QStringList &todo);
     bool handleShortOption(QChar c);
 
     /**
@@ -115,6 +161,7 @@ private:
     {
         Option()
             : callback(nullptr)
+            , valueCallback(nullptr)
             , data(nullptr)
         {}
 
@@ -124,16 +171,32 @@ private:
                QString longName,
                QString help)
             : callback(callback)
+            , valueCallback(nullptr)
             , data(data)
             , shortName(shortName)
             , longName(std::move(longName))
             , help(std::move(help))
         {}
 
+        Option(ValueCallback valueCallback,
+               void *data,
+               QString longName,
+               QString valueName,
+               QString help)
+            : callback(nullptr)
+            , valueCallback(valueCallback)
+            , data(data)
+            , longName(std::move(longName))
+            , valueName(std::move(valueName))
+            , help(std::move(help))
+        {}
+
         Callback callback;
+        ValueCallback valueCallback;
         void *data;
         QChar shortName;
         QString longName;
+        QString valueName;
         QString help;
     };
 
@@ -133,8 +133,8 @@ DocumentManager::DocumentManager(QObject *parent)
     connect(mTabBar, &QWidget::customContextMenuRequested,
             this, &DocumentManager::tabContextMenuRequested);
 
-    connect(mFileSystemWatcher, &FileSystemWatcher::fileChanged,
-            this, &DocumentManager::fileChanged);
+    connect(mFileSystemWatcher, &FileSystemWatcher::pathsChanged,
+            this, &DocumentManager::filesChanged);
 
     connect(mBrokenLinksModel, &BrokenLinksModel::hasBrokenLinksChanged,
             mBrokenLinksWidget, &BrokenLinksWidget::setVisible);
@@ -1090,29 +1090,34 @@ void DocumentManager::tilesetNameChanged(Tileset *tileset)
         updateDocumentTab(tilesetDocument);
 }
 
-void DocumentManager::fileChanged(const QString &fileName)
+void DocumentManager::filesChanged(const QStringList &fileNames)
 {
-    const int index = findDocument(fileName);
+    bool changedOnDisk = false;
 
-    // Most likely the file was removed
-    if (index == -1)
-        return;
+    for (const QString &fileName : fileNames) {
+        const int index = findDocument(fileName);
 
-    const auto &document = mDocuments.at(index);
+        // Most likely the file was removed
+        if (index == -1)
+            continue;
 
-    // Ignore change event when it seems to be our own save
-    if (QFileInfo(fileName).lastModified() == document->lastSaved())
-        return;
+        const auto &document = mDocuments.at(index);
 
-    // Automatically reload when there are no unsaved changes
-    if (!isDocumentModified(document.data())) {
-        reloadDocumentAt(index);
-        return;
-    }
+        // Ignore change event when it seems to be our own save
+        if (QFileInfo(fileName).lastModified() == document->lastSaved())
+            continue;
+
+        // Automatically reload when there are no unsaved changes
+        if (!isDocumentModified(document.data())) {
+            reloadDocumentAt(index);
+            continue;
+        }
 
-    document->setChangedOnDisk(true);
+        document->setChangedOnDisk(true);
+        changedOnDisk = true;
+    }
 
-    if (isDocumentChangedOnDisk(currentDocument()))
+    if (changedOnDisk && isDocumentChangedOnDisk(currentDocument()))
         mFileChangedWarning->setVisible(true);
 }
 
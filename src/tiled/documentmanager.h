@@ -199,7 +199,7 @@ private:
 
     void tilesetNameChanged(Tileset *tileset);
 
-    void fileChanged(const QString &fileName);
+    void filesChanged(const QStringList &fileNames);
     void hideChangedWarning();
 
     void tilesetImagesChanged(Tileset *tileset);
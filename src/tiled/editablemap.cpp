@@ -165,6 +165,17 @@ EditableLayer *EditableMap::layerAt(int index)
     return EditableManager::instance().editableLayer(this, layer);
 }
 
+/**
+ * Returns the object with the given \a id, or null if this map has no such
+ * object.
+ */
+EditableMapObject *EditableMap::objectById(int id)
+{
+    if (MapObject *mapObject = map()->findObjectById(id))
+        return EditableManager::instance().editableMapObject(this, mapObject);
+    return nullptr;
+}
+
 void EditableMap::removeLayerAt(int index)
 {
     if (index < 0 || index >= layerCount()) {
@@ -136,6 +136,7 @@ public:
     Q_INVOKABLE void removeLayer(Tiled::EditableLayer *editableLayer);
     Q_INVOKABLE void insertLayerAt(int index, Tiled::EditableLayer *editableLayer);
     Q_INVOKABLE void addLayer(Tiled::EditableLayer *editableLayer);
+    Q_INVOKABLE Tiled::EditableMapObject *objectById(int id);
 
     Q_INVOKABLE bool addTileset(Tiled::EditableTileset *tileset);
     Q_INVOKABLE bool replaceTileset(Tiled::EditableTileset *oldEditableTileset,
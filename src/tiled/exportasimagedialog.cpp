@@ -21,6 +21,7 @@
 #include "exportasimagedialog.h"
 #include "ui_exportasimagedialog.h"
 
+#include "exportasimagejob.h"
 #include "imagelayer.h"
 #include "map.h"
 #include "mapdocument.h"
@@ -36,12 +37,17 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QImageWriter>
+#include <QProgressDialog>
 #include <QSettings>
 
 static const char * const VISIBLE_ONLY_KEY = "SaveAsImage/VisibleLayersOnly";
 static const char * const CURRENT_SCALE_KEY = "SaveAsImage/CurrentScale";
 static const char * const DRAW_GRID_KEY = "SaveAsImage/DrawGrid";
 static const char * const INCLUDE_BACKGROUND_COLOR = "SaveAsImage/IncludeBackgroundColor";
+static const char * const SPLIT_INTO_FILES = "SaveAsImage/SplitIntoFiles";
+
+// The maximum width and height of each file when splitting the image
+static const int SplitSize = 4096;
 
 using namespace Tiled;
 
@@ -97,11 +103,14 @@ ExportAsImageDialog::ExportAsImageDialog(MapDocument *mapDocument,
             s->value(QLatin1String(DRAW_GRID_KEY), false).toBool();
     const bool includeBackgroundColor =
             s->value(QLatin1String(INCLUDE_BACKGROUND_COLOR), false).toBool();
+    const bool splitIntoFiles =
+            s->value(QLatin1String(SPLIT_INTO_FILES), false).toBool();
 
     mUi->visibleLayersOnly->setChecked(visibleLayersOnly);
     mUi->currentZoomLevel->setChecked(useCurrentScale);
     mUi->drawTileGrid->setChecked(drawTileGrid);
     mUi->includeBackgroundColor->setChecked(includeBackgroundColor);
+    mUi->splitIntoFiles->setChecked(splitIntoFiles);
 
     connect(mUi->browseButton, &QAbstractButton::clicked, this, &ExportAsImageDialog::browse);
     connect(mUi->fileNameEdit, &QLineEdit::textChanged,
@@ -124,17 +133,29 @@ static bool smoothTransform(qreal scale)
 
 void ExportAsImageDialog::accept()
 {
+    if (mExportJob)
+        return;
+
     const QString fileName = mUi->fileNameEdit->text();
     if (fileName.isEmpty())
         return;
 
-    if (QFile::exists(fileName)) {
+    const bool visibleLayersOnly = mUi->visibleLayersOnly->isChecked();
+    const bool useCurrentScale = mUi->currentZoomLevel->isChecked();
+    const bool drawTileGrid = mUi->drawTileGrid->isChecked();
+    const bool includeBackgroundColor = mUi->includeBackgroundColor->isChecked();
+    const bool splitIntoFiles = mUi->splitIntoFiles->isChecked();
+
+    const QString firstFileName = splitIntoFiles ? ExportAsImageJob::splitFileName(fileName, 0, 0)
+                                                 : fileName;
+
+    if (QFile::exists(firstFileName)) {
         const QMessageBox::StandardButton button =
                 QMessageBox::warning(this,
                                      tr("Export as Image"),
                                      tr("%1 already exists.\n"
                                         "Do you want to replace it?")
-                                     .arg(QFileInfo(fileName).fileName()),
+                                     .arg(QFileInfo(firstFileName).fileName()),
                                      QMessageBox::Yes | QMessageBox::No,
                                      QMessageBox::No);
 
@@ -142,14 +163,6 @@ void ExportAsImageDialog::accept()
             return;
     }
 
-    const bool visibleLayersOnly = mUi->visibleLayersOnly->isChecked();
-    const bool useCurrentScale = mUi->currentZoomLevel->isChecked();
-    const bool drawTileGrid = mUi->drawTileGrid->isChecked();
-    const bool includeBackgroundColor = mUi->includeBackgroundColor->isChecked();
-
-    MiniMapRenderer miniMapRenderer(mMapDocument->map());
-    miniMapRenderer.setGridColor(Preferences::instance()->gridColor());
-
     MiniMapRenderer::RenderFlags renderFlags(MiniMapRenderer::DrawTileLayers |
                                              MiniMapRenderer::DrawMapObjects |
                                              MiniMapRenderer::DrawImageLayers);
@@ -174,48 +187,76 @@ void ExportAsImageDialog::accept()
     if (useCurrentScale)
         imageSize *= mCurrentScale;
 
-    try {
-        QImage image(imageSize, QImage::Format_ARGB32_Premultiplied);
-
-        if (image.isNull()) {
-            const size_t gigabyte = 1073741824;
-            const size_t memory = size_t(imageSize.width()) * size_t(imageSize.height()) * 4;
-            const double gigabytes = static_cast<double>(memory) / gigabyte;
-
-            QMessageBox::critical(this,
-                                  tr("Image too Big"),
-                                  tr("The resulting image would be %1 x %2 pixels and take %3 GB of memory. "
-                                     "Tiled is unable to create such an image. Try reducing the zoom level.")
-                                  .arg(imageSize.width())
-                                  .arg(imageSize.height())
-                                  .arg(gigabytes, 0, 'f', 2));
-            return;
-        }
-
-        miniMapRenderer.renderToImage(image, renderFlags);
+    if (imageSize.isEmpty())
+        return;
 
-        image.save(fileName);
+    ExportAsImageJob::Options options;
+    options.fileName = fileName;
+    options.imageSize = imageSize;
+    options.renderFlags = renderFlags;
+    options.gridColor = Preferences::instance()->gridColor();
+    options.splitSize = splitIntoFiles ? SplitSize : 0;
+
+    // The map is rendered on other threads, so it is copied to allow
+    // rendering it while the editor stays responsive
+    mExportJob = new ExportAsImageJob(mMapDocument->map()->clone(), options, this);
+
+    mProgressDialog = new QProgressDialog(tr("Exporting image..."), tr("Cancel"), 0, 0, this);
+    mProgressDialog->setWindowTitle(tr("Export as Image"));
+    mProgressDialog->setWindowModality(Qt::WindowModal);
+    mProgressDialog->setMinimumDuration(500);
+
+    connect(mExportJob, &ExportAsImageJob::progress, mProgressDialog, [this] (int done, int total) {
+        mProgressDialog->setMaximum(total);
+        mProgressDialog->setValue(done);
+    });
+    connect(mProgressDialog, &QProgressDialog::canceled, mExportJob, &ExportAsImageJob::cancel);
+    connect(mExportJob, &ExportAsImageJob::finished, this, &ExportAsImageDialog::exportFinished);
+    connect(mExportJob, &ExportAsImageJob::failed, this, &ExportAsImageDialog::exportFailed);
+    connect(mExportJob, &ExportAsImageJob::cancelled, this, &ExportAsImageDialog::exportCancelled);
+
+    mExportJob->start();
+}
 
-    } catch (const std::bad_alloc &) {
-        QMessageBox::critical(this,
-                              tr("Out of Memory"),
-                              tr("Could not allocate sufficient memory for the image. "
-                                 "Try reducing the zoom level or using a 64-bit version of Tiled."));
-        return;
-    }
+void ExportAsImageDialog::exportFinished()
+{
+    deleteExportJob();
 
-    mPath = QFileInfo(fileName).path();
+    mPath = QFileInfo(mUi->fileNameEdit->text()).path();
 
     // Store settings for next time
     QSettings *s = Preferences::instance()->settings();
-    s->setValue(QLatin1String(VISIBLE_ONLY_KEY), visibleLayersOnly);
-    s->setValue(QLatin1String(CURRENT_SCALE_KEY), useCurrentScale);
-    s->setValue(QLatin1String(DRAW_GRID_KEY), drawTileGrid);
-    s->setValue(QLatin1String(INCLUDE_BACKGROUND_COLOR), includeBackgroundColor);
+    s->setValue(QLatin1String(VISIBLE_ONLY_KEY), mUi->visibleLayersOnly->isChecked());
+    s->setValue(QLatin1String(CURRENT_SCALE_KEY), mUi->currentZoomLevel->isChecked());
+    s->setValue(QLatin1String(DRAW_GRID_KEY), mUi->drawTileGrid->isChecked());
+    s->setValue(QLatin1String(INCLUDE_BACKGROUND_COLOR), mUi->includeBackgroundColor->isChecked());
+    s->setValue(QLatin1String(SPLIT_INTO_FILES), mUi->splitIntoFiles->isChecked());
 
     QDialog::accept();
 }
 
+void ExportAsImageDialog::exportFailed(const QString &error)
+{
+    deleteExportJob();
+
+    QMessageBox::critical(this, tr("Export as Image"), error);
+}
+
+void ExportAsImageDialog::exportCancelled()
+{
+    deleteExportJob();
+}
+
+void ExportAsImageDialog::deleteExportJob()
+{
+    // The job may still be emitting the signal that got us here
+    mExportJob->deleteLater();
+    mExportJob = nullptr;
+
+    mProgressDialog->deleteLater();
+    mProgressDialog = nullptr;
+}
+
 void ExportAsImageDialog::browse()
 {
     // Don't confirm overwrite here, since we'll confirm when the user presses
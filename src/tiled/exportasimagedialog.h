@@ -22,12 +22,15 @@
 
 #include <QDialog>
 
+class QProgressDialog;
+
 namespace Ui {
 class ExportAsImageDialog;
 }
 
 namespace Tiled {
 
+class ExportAsImageJob;
 class MapDocument;
 
 /**
@@ -55,10 +58,16 @@ public:
 private:
     void browse();
     void updateAcceptEnabled();
+    void exportFinished();
+    void exportFailed(const QString &error);
+    void exportCancelled();
+    void deleteExportJob();
 
     Ui::ExportAsImageDialog *mUi;
     MapDocument *mMapDocument;
     qreal mCurrentScale;
+    ExportAsImageJob *mExportJob = nullptr;
+    QProgressDialog *mProgressDialog = nullptr;
 
     static QString mPath;
 };
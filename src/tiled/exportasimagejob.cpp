@@ -0,0 +1,481 @@
+/*
+ * exportasimagejob.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "exportasimagejob.h"
+
+#include "map.h"
+#include "mapobject.h"
+#include "objectgroup.h"
+#include "pngwriter.h"
+#include "savefile.h"
+#include "tilelayer.h"
+
+#include <QAtomicInt>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QImageWriter>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "qtcompat_p.h"
+
+#include <cstring>
+#include <functional>
+#include <new>
+
+namespace Tiled {
+
+// The number of pixels rendered at once for each horizontal band
+static const int BandPixels = 4 * 1024 * 1024;
+
+// The maximum number of bytes used by the parts that are being rendered or
+// are waiting to be written
+static const qint64 MaxPendingBytes = qint64(256) * 1024 * 1024;
+
+/**
+ * Renders and writes the image. Lives on the thread of the job.
+ */
+class ExportAsImageTask : public QObject
+{
+    Q_OBJECT
+
+public:
+    ExportAsImageTask(std::unique_ptr<Map> map,
+                      const ExportAsImageJob::Options &options);
+
+    void run();
+
+    void cancel() { mCancelled.storeRelease(1); }
+    bool isCancelled() const { return mCancelled.loadAcquire(); }
+
+    QImage render(const QRect &rect) const;
+
+signals:
+    void progress(int done, int total);
+    void finished();
+    void failed(const QString &error);
+    void cancelled();
+
+private:
+    using WriteFunction = std::function<bool (const QImage &image, const QRect &rect)>;
+
+    QVector<QRect> bands() const;
+
+    bool writePng();
+    bool writeImage();
+    bool writeSplit();
+    bool renderRegions(const QVector<QRect> &regions, const WriteFunction &write);
+
+    const std::unique_ptr<Map> mMap;
+    const ExportAsImageJob::Options mOptions;
+    QAtomicInt mCancelled;
+    QString mError;
+    QStringList mWrittenFiles;
+};
+
+namespace {
+
+struct RenderedRegions
+{
+    QMutex mutex;
+    QWaitCondition ready;
+    QHash<int, QImage> images;
+};
+
+/**
+ * Renders a single part of the image on a thread from the pool.
+ */
+class RenderRegionTask : public QRunnable
+{
+public:
+    RenderRegionTask(const ExportAsImageTask &task,
+                     int index,
+                     const QRect &rect,
+                     RenderedRegions &rendered)
+        : mTask(task)
+        , mIndex(index)
+        , mRect(rect)
+        , mRendered(rendered)
+    {}
+
+    void run() override
+    {
+        QImage image;
+
+        if (!mTask.isCancelled()) {
+            try {
+                image = mTask.render(mRect);
+            } catch (const std::bad_alloc &) {
+                image = QImage();
+            }
+        }
+
+        QMutexLocker locker(&mRendered.mutex);
+        mRendered.images.insert(mIndex, image);
+        mRendered.ready.wakeAll();
+    }
+
+private:
+    const ExportAsImageTask &mTask;
+    const int mIndex;
+    const QRect mRect;
+    RenderedRegions &mRendered;
+};
+
+} // anonymous namespace
+
+ExportAsImageTask::ExportAsImageTask(std::unique_ptr<Map> map,
+                                     const ExportAsImageJob::Options &options)
+    : mMap(std::move(map))
+    , mOptions(options)
+{
+    // All threads render the same map. Rendering only reads the map, except
+    // for several values that are computed on first use. These are computed
+    // here, before the map is handed to other threads. This includes
+    // decoding any lazily loaded chunks.
+    LayerIterator iterator(mMap.get());
+    while (Layer *layer = iterator.next()) {
+        if (TileLayer *tileLayer = layer->asTileLayer()) {
+            tileLayer->decodeAllChunks();
+            tileLayer->usedTilesets();
+            tileLayer->drawMargins();
+        } else if (ObjectGroup *objectGroup = layer->asObjectGroup()) {
+            if (!objectGroup->isEmpty())
+                objectGroup->objectAt(0)->index();
+        }
+    }
+
+    mMap->drawMargins();
+}
+
+void ExportAsImageTask::run()
+{
+    bool success;
+
+    try {
+        if (mOptions.splitSize > 0)
+            success = writeSplit();
+        else if (QFileInfo(mOptions.fileName).suffix().compare(QLatin1String("png"), Qt::CaseInsensitive) == 0)
+            success = writePng();
+        else
+            success = writeImage();
+    } catch (const std::bad_alloc &) {
+        mError = tr("Could not allocate sufficient memory for the image.");
+        success = false;
+    }
+
+    if (!success) {
+        for (const QString &fileName : qAsConst(mWrittenFiles))
+            QFile::remove(fileName);
+    }
+
+    if (success)
+        emit finished();
+    else if (!mError.isEmpty())
+        emit failed(mError);
+    else
+        emit cancelled();
+
+    QThread::currentThread()->quit();
+}
+
+/**
+ * Renders the given \a rect of the image. Called from the threads of the
+ * pool, so a separate renderer is used for each call, while the map is
+ * shared.
+ */
+QImage ExportAsImageTask::render(const QRect &rect) const
+{
+    QImage image(rect.size(), QImage::Format_ARGB32_Premultiplied);
+    if (image.isNull())
+        return image;
+
+    MiniMapRenderer miniMapRenderer(mMap.get());
+    miniMapRenderer.setGridColor(mOptions.gridColor);
+    miniMapRenderer.renderToImage(image, mOptions.renderFlags,
+                                  mOptions.imageSize, rect.topLeft());
+
+    return image;
+}
+
+QVector<QRect> ExportAsImageTask::bands() const
+{
+    const QSize size = mOptions.imageSize;
+    const int bandHeight = qBound(1, BandPixels / size.width(), size.height());
+
+    QVector<QRect> bands;
+    for (int y = 0; y < size.height(); y += bandHeight)
+        bands.append(QRect(0, y, size.width(), qMin(bandHeight, size.height() - y)));
+
+    return bands;
+}
+
+/**
+ * Writes the image to a single PNG file, one band at a time.
+ */
+bool ExportAsImageTask::writePng()
+{
+    SaveFile file(mOptions.fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        mError = file.errorString();
+        return false;
+    }
+
+    // Without safe saving, an incomplete file would be left behind
+    if (!SaveFile::safeSavingEnabled())
+        mWrittenFiles.append(mOptions.fileName);
+
+    PngWriter writer(file.device());
+    if (!writer.begin(mOptions.imageSize)) {
+        mError = writer.errorString();
+        return false;
+    }
+
+    const bool success = renderRegions(bands(), [&] (const QImage &image, const QRect &) {
+        if (!writer.writeRows(image)) {
+            mError = writer.errorString();
+            return false;
+        }
+        return true;
+    });
+
+    if (!success)
+        return false;
+
+    if (!writer.finish()) {
+        mError = writer.errorString();
+        return false;
+    }
+
+    if (!file.commit()) {
+        mError = file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Writes the image using QImageWriter, which requires the full image to be
+ * in memory. It is still rendered in parallel.
+ */
+bool ExportAsImageTask::writeImage()
+{
+    const QSize size = mOptions.imageSize;
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    if (image.isNull()) {
+        mError = tr("The resulting image would be %1 x %2 pixels, which is too large to create. "
+                    "Try exporting to PNG, splitting the image into multiple files or reducing the zoom level.")
+                .arg(size.width())
+                .arg(size.height());
+        return false;
+    }
+
+    const bool success = renderRegions(bands(), [&] (const QImage &band, const QRect &rect) {
+        for (int y = 0; y < band.height(); ++y)
+            std::memcpy(image.scanLine(rect.y() + y), band.constScanLine(y),
+                        static_cast<size_t>(band.bytesPerLine()));
+        return true;
+    });
+
+    if (!success)
+        return false;
+
+    QImageWriter writer(mOptions.fileName);
+    if (!writer.write(image)) {
+        mError = writer.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Writes the image to multiple files, each covering a square part of at
+ * most Options::splitSize pixels wide and high.
+ */
+bool ExportAsImageTask::writeSplit()
+{
+    const QSize size = mOptions.imageSize;
+    const int splitSize = mOptions.splitSize;
+
+    QVector<QRect> parts;
+    for (int y = 0; y < size.height(); y += splitSize) {
+        for (int x = 0; x < size.width(); x += splitSize) {
+            parts.append(QRect(x, y,
+                               qMin(splitSize, size.width() - x),
+                               qMin(splitSize, size.height() - y)));
+        }
+    }
+
+    return renderRegions(parts, [&] (const QImage &image, const QRect &rect) {
+        const QString fileName = ExportAsImageJob::splitFileName(mOptions.fileName,
+                                                                 rect.x() / splitSize,
+                                                                 rect.y() / splitSize);
+
+        QImageWriter writer(fileName);
+        if (!writer.write(image)) {
+            mError = tr("Could not write %1: %2").arg(fileName, writer.errorString());
+            return false;
+        }
+
+        mWrittenFiles.append(fileName);
+        return true;
+    });
+}
+
+static qint64 imageBytes(const QRect &rect)
+{
+    return qint64(rect.width()) * rect.height() * 4;
+}
+
+/**
+ * Renders the given \a regions in parallel and passes them to \a write in
+ * order. To bound memory usage, only a limited number of regions are
+ * rendered ahead of the one that is written next, and together they take up
+ * at most MaxPendingBytes (though at least one region is always rendered).
+ */
+bool ExportAsImageTask::renderRegions(const QVector<QRect> &regions,
+                                      const WriteFunction &write)
+{
+    QThreadPool threadPool;
+    const int maxPending = threadPool.maxThreadCount() * 2;
+
+    RenderedRegions rendered;
+    int started = 0;
+    qint64 pendingBytes = 0;
+    bool success = true;
+
+    for (int index = 0; index < regions.size(); ++index) {
+        for (; started < regions.size() && started - index < maxPending; ++started) {
+            const qint64 bytes = imageBytes(regions.at(started));
+            if (started > index && pendingBytes + bytes > MaxPendingBytes)
+                break;
+
+            pendingBytes += bytes;
+            threadPool.start(new RenderRegionTask(*this, started, regions.at(started), rendered));
+        }
+
+        QImage image;
+        {
+            QMutexLocker locker(&rendered.mutex);
+            while (!rendered.images.contains(index))
+                rendered.ready.wait(&rendered.mutex);
+            image = rendered.images.take(index);
+        }
+
+        pendingBytes -= imageBytes(regions.at(index));
+
+        if (isCancelled()) {
+            success = false;
+            break;
+        }
+
+        if (image.isNull()) {
+            mError = tr("Could not allocate sufficient memory for the image.");
+            success = false;
+            break;
+        }
+
+        if (!write(image, regions.at(index))) {
+            success = false;
+            break;
+        }
+
+        emit progress(index + 1, regions.size());
+    }
+
+    // Make sure the remaining tasks do not render anything
+    if (!success)
+        cancel();
+
+    threadPool.waitForDone();
+    return success;
+}
+
+
+/**
+ * Creates a job that exports the given \a map. The map is rendered on other
+ * threads, so it should not be shared with the editor.
+ */
+ExportAsImageJob::ExportAsImageJob(std::unique_ptr<Map> map,
+                                   const Options &options,
+                                   QObject *parent)
+    : QObject(parent)
+    , mTask(new ExportAsImageTask(std::move(map), options))
+{
+    mTask->moveToThread(&mThread);
+
+    connect(&mThread, &QThread::started, mTask.get(), &ExportAsImageTask::run);
+    connect(mTask.get(), &ExportAsImageTask::progress, this, &ExportAsImageJob::progress);
+    connect(mTask.get(), &ExportAsImageTask::finished, this, &ExportAsImageJob::finished);
+    connect(mTask.get(), &ExportAsImageTask::failed, this, &ExportAsImageJob::failed);
+    connect(mTask.get(), &ExportAsImageTask::cancelled, this, &ExportAsImageJob::cancelled);
+}
+
+ExportAsImageJob::~ExportAsImageJob()
+{
+    // The task is deleted after its thread has finished
+    cancel();
+    mThread.quit();
+    mThread.wait();
+}
+
+void ExportAsImageJob::start()
+{
+    mThread.start();
+}
+
+/**
+ * Requests the export to stop. Any files written so far are removed.
+ */
+void ExportAsImageJob::cancel()
+{
+    mTask->cancel();
+}
+
+/**
+ * Returns the name of the file used for the part at the given \a column and
+ * \a row, when splitting the image into multiple files.
+ */
+QString ExportAsImageJob::splitFileName(const QString &fileName, int column, int row)
+{
+    const QFileInfo fileInfo(fileName);
+    QString name = QStringLiteral("%1_%2_%3").arg(fileInfo.completeBaseName()).arg(column).arg(row);
+
+    if (!fileInfo.suffix().isEmpty()) {
+        name += QLatin1Char('.');
+        name += fileInfo.suffix();
+    }
+
+    return fileInfo.dir().filePath(name);
+}
+
+} // namespace Tiled
+
+#include "exportasimagejob.moc"
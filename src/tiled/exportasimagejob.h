@@ -0,0 +1,87 @@
+/*
+ * exportasimagejob.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "minimaprenderer.h"
+
+#include <QColor>
+#include <QObject>
+#include <QSize>
+#include <QThread>
+
+#include <memory>
+
+namespace Tiled {
+
+class Map;
+class ExportAsImageTask;
+
+/**
+ * Exports a map as an image on a background thread.
+ *
+ * The image is rendered in parts, which are rendered in parallel. When
+ * exporting to a single PNG file, each horizontal band is written to the
+ * file as soon as it is done, so that the full image never needs to be in
+ * memory. Other formats are written by QImageWriter, which does need the
+ * full image. Alternatively, the image can be split into multiple files.
+ */
+class ExportAsImageJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Options
+    {
+        QString fileName;
+        QSize imageSize;
+        MiniMapRenderer::RenderFlags renderFlags;
+        QColor gridColor;
+
+        /**
+         * When larger than 0, the image is split into multiple files of at
+         * most this width and height. A suffix "_<column>_<row>" is added
+         * to the base name of each file.
+         */
+        int splitSize = 0;
+    };
+
+    ExportAsImageJob(std::unique_ptr<Map> map,
+                     const Options &options,
+                     QObject *parent = nullptr);
+    ~ExportAsImageJob() override;
+
+    void start();
+    void cancel();
+
+    static QString splitFileName(const QString &fileName, int column, int row);
+
+signals:
+    void progress(int done, int total);
+    void finished();
+    void failed(const QString &error);
+    void cancelled();
+
+private:
+    QThread mThread;
+    std::unique_ptr<ExportAsImageTask> mTask;
+};
+
+} // namespace Tiled
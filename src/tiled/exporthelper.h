@@ -21,9 +21,13 @@
 #pragma once
 
 #include "fileformat.h"
+#include "pluginmanager.h"
 #include "preferences.h"
 #include "tileset.h"
 
+#include <QCoreApplication>
+#include <QFileInfo>
+
 #include <memory>
 
 namespace Tiled {
@@ -52,4 +56,54 @@ private:
     const Preferences::ExportOptions mOptions;
 };
 
+/**
+ * Used during file export, attempt to determine the output file format
+ * from the command line parameters.
+ * Query errorMsg if result is null.
+ */
+template <typename T>
+inline T *findExportFormat(const QString *filter,
+                           const QString &targetFile,
+                           QString &errorMsg)
+{
+    T *outputFormat = nullptr;
+    const auto formats = PluginManager::objects<T>();
+
+    if (filter) {
+        // Find the format supporting the given filter
+        for (T *format : formats) {
+            if (!format->hasCapabilities(T::Write))
+                continue;
+            if (format->shortName().compare(*filter, Qt::CaseInsensitive) == 0) {
+                outputFormat = format;
+                break;
+            }
+        }
+        if (!outputFormat) {
+            errorMsg = QCoreApplication::translate("Command line", "Format not recognized (see --export-formats)");
+            return nullptr;
+        }
+    } else {
+        // Find the format based on target file extension
+        QString suffix = QFileInfo(targetFile).completeSuffix();
+        for (T *format : formats) {
+            if (!format->hasCapabilities(T::Write))
+                continue;
+            if (format->nameFilter().contains(suffix, Qt::CaseInsensitive)) {
+                if (outputFormat) {
+                    errorMsg = QCoreApplication::translate("Command line", "Non-unique file extension. Can't determine correct export format.");
+                    return nullptr;
+                }
+                outputFormat = format;
+            }
+        }
+        if (!outputFormat) {
+            errorMsg = QCoreApplication::translate("Command line", "No exporter found for target file.");
+            return nullptr;
+        }
+    }
+
+    return outputFormat;
+}
+
 } // namespace Tiled
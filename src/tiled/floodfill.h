@@ -0,0 +1,48 @@
+/*
+ * floodfill.h
+ * Copyright 2009-2011, Thorbjørn Lindeijer <thorbjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "map.h"
+
+#include <QPoint>
+#include <QRegion>
+
+namespace Tiled {
+
+class TileLayer;
+
+/**
+ * Returns the region of cells within \a region that are connected to
+ * \a fillOrigin and equal to the cell at that position. The region and
+ * the origin are in local coordinates of \a layer. Returns an empty region
+ * when \a region does not contain \a fillOrigin.
+ *
+ * For staggered and hexagonal maps, the neighbors are determined based on
+ * the given stagger axis and index.
+ */
+QRegion floodFillRegion(const TileLayer *layer,
+                        const QRegion &region,
+                        QPoint fillOrigin,
+                        Map::Orientation orientation,
+                        Map::StaggerAxis staggerAxis,
+                        Map::StaggerIndex staggerIndex);
+
+} // namespace Tiled
@@ -20,6 +20,7 @@
  * this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "batchexporter.h"
 #include "commandlineparser.h"
 #include "exporthelper.h"
 #include "languagemanager.h"
@@ -37,11 +38,16 @@
 #include "tmxmapformat.h"
 
 #include <QDebug>
+#include <QDir>
 #include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QtPlugin>
 
+#include "qtcompat_p.h"
+
+#include <algorithm>
+#include <iterator>
 #include <memory>
 
 #ifdef Q_OS_WIN
@@ -67,10 +73,13 @@ public:
     CommandLineHandler();
 
     bool quit;
+    bool invalidArguments;
     bool showedVersion;
     bool disableOpenGL;
     bool exportMap;
+    bool exportMapBatch;
     bool exportTileset;
+    int exportJobs;
     bool newInstance;
     Preferences::ExportOptions exportOptions;
 
@@ -79,6 +88,8 @@ private:
     void justQuit();
     void setDisableOpenGL();
     void setExportMap();
+    void setExportMapBatch();
+    void setExportJobs(const QString &value);
     void setExportTileset();
     void setExportEmbedTilesets();
     void setExportDetachTemplateInstances();
@@ -98,6 +109,18 @@ private:
                                                            longName,
                                                            help);
     }
+
+    // Convenience wrapper around registerOption for options taking a value
+    template <void (CommandLineHandler::*memberFunction)(const QString &)>
+    void option(const QString &longName,
+                const QString &valueName,
+                const QString &help)
+    {
+        registerOption<CommandLineHandler, memberFunction>(this,
+                                                           longName,
+                                                           valueName,
+                                                           help);
+    }
 };
 
 static const QtMessageHandler QT_DEFAULT_MESSAGE_HANDLER = qInstallMessageHandler(nullptr);
@@ -124,72 +147,77 @@ static void messagesToConsole(QtMsgType type, const QMessageLogContext &context,
     (*QT_DEFAULT_MESSAGE_HANDLER)(type, context, msg);
 }
 
+enum ApplicationMode {
+    GuiMode,
+    HeadlessMode,
+    CoreMode
+};
+
+static void initializeScripting()
+{
+    static bool initialized = false;
+    if (!initialized) {
+        initialized = true;
+        ScriptManager::instance().initialize();
+    }
+}
+
 static void initializePluginsAndExtensions()
 {
     PluginManager::instance()->loadPlugins();
-    ScriptManager::instance().initialize();
+    initializeScripting();
 }
 
 /**
- * Used during file export, attempt to determine the output file format
- * from the command line parameters.
- * Query errorMsg if result is null.
+ * Loads only the plugins needed for the given format \a filter, or for the
+ * extension of \a fileName when no filter is given. The remaining plugins
+ * are loaded on demand, when a referenced tileset or template turns out to
+ * be in a format that isn't available yet.
  */
-template <typename T>
-inline T *findExportFormat(const QString *filter,
-                           const QString &targetFile,
-                           QString &errorMsg)
+static void loadPluginsFor(const QString *filter, const QString &fileName)
 {
-    T *outputFormat = nullptr;
-    const auto formats = PluginManager::objects<T>();
-
-    if (filter) {
-        // Find the format supporting the given filter
-        for (T *format : formats) {
-            if (!format->hasCapabilities(T::Write))
-                continue;
-            if (format->shortName().compare(*filter, Qt::CaseInsensitive) == 0) {
-                outputFormat = format;
-                break;
-            }
-        }
-        if (!outputFormat) {
-            errorMsg = QCoreApplication::translate("Command line", "Format not recognized (see --export-formats)");
-            return nullptr;
-        }
-    } else {
-        // Find the format based on target file extension
-        QString suffix = QFileInfo(targetFile).completeSuffix();
-        for (T *format : formats) {
-            if (!format->hasCapabilities(T::Write))
-                continue;
-            if (format->nameFilter().contains(suffix, Qt::CaseInsensitive)) {
-                if (outputFormat) {
-                    errorMsg = QCoreApplication::translate("Command line", "Non-unique file extension. Can't determine correct export format.");
-                    return nullptr;
-                }
-                outputFormat = format;
-            }
-        }
-        if (!outputFormat) {
-            errorMsg = QCoreApplication::translate("Command line", "No exporter found for target file.");
-            return nullptr;
-        }
-    }
+    PluginManager *pluginManager = PluginManager::instance();
+    pluginManager->setLoadPluginsOnDemand(true);
 
-    return outputFormat;
+    if (filter)
+        pluginManager->loadPluginsProviding(*filter);
+    else
+        pluginManager->loadPluginsForFile(fileName);
 }
 
+/**
+ * Like findExportFormat, but only loads the plugins that are expected to
+ * provide the format. Scripted extensions are only loaded when the format
+ * was not found among the plugins.
+ */
+template <typename T>
+static T *findExportFormatLazily(const QString *filter,
+                                 const QString &targetFile,
+                                 QString &errorMsg)
+{
+    loadPluginsFor(filter, targetFile);
+
+    if (T *format = findExportFormat<T>(filter, targetFile, errorMsg))
+        return format;
+
+    initializeScripting();
+    errorMsg.clear();
+
+    return findExportFormat<T>(filter, targetFile, errorMsg);
+}
 
 } // anonymous namespace
 
 
 CommandLineHandler::CommandLineHandler()
     : quit(false)
+    , invalidArguments(false)
     , showedVersion(false)
     , disableOpenGL(false)
     , exportMap(false)
+    , exportMapBatch(false)
     , exportTileset(false)
+    , exportJobs(1)
     , newInstance(false)
 {
     option<&CommandLineHandler::showVersion>(
@@ -212,6 +240,16 @@ CommandLineHandler::CommandLineHandler()
                 QLatin1String("--export-map"),
                 tr("Export the specified map file to target"));
 
+    option<&CommandLineHandler::setExportMapBatch>(
+                QChar(),
+                QLatin1String("--export-map-batch"),
+                tr("Export all maps listed in the specified manifest file"));
+
+    option<&CommandLineHandler::setExportJobs>(
+                QLatin1String("--export-jobs"),
+                QLatin1String("<count>"),
+                tr("Number of maps to write in parallel when exporting a batch"));
+
     option<&CommandLineHandler::setExportTileset>(
                 QChar(),
                 QLatin1String("--export-tileset"),
@@ -273,6 +311,24 @@ void CommandLineHandler::setExportMap()
     exportMap = true;
 }
 
+void CommandLineHandler::setExportMapBatch()
+{
+    exportMapBatch = true;
+}
+
+void CommandLineHandler::setExportJobs(const QString &value)
+{
+    bool ok;
+    const int jobs = value.toInt(&ok);
+    if (!ok || jobs < 1) {
+        qWarning().noquote() << tr("Invalid number of export jobs: %1").arg(value);
+        invalidArguments = true;
+        quit = true;
+        return;
+    }
+    exportJobs = jobs;
+}
+
 void CommandLineHandler::setExportTileset()
 {
     exportTileset = true;
@@ -335,54 +391,11 @@ void CommandLineHandler::startNewInstance()
 }
 
 
-int main(int argc, char *argv[])
+/**
+ * Handles the export options, returning the exit code.
+ */
+static int runExport(const CommandLineHandler &commandLine)
 {
-#if defined(Q_OS_WIN) && (!defined(Q_CC_MINGW) || __MINGW32_MAJOR_VERSION >= 5)
-    // Make console output work on Windows, if running in a console.
-    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
-        FILE *dummy = nullptr;
-        freopen_s(&dummy, "CONOUT$", "w", stdout);
-        freopen_s(&dummy, "CONOUT$", "w", stderr);
-    }
-#endif
-
-    qInstallMessageHandler(messagesToConsole);
-
-    QGuiApplication::setFallbackSessionManagementEnabled(false);
-
-    // Enable support for highres images (added in Qt 5.1, but off by default)
-    QCoreApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
-#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-    QCoreApplication::setAttribute(Qt::AA_DisableWindowContextHelpButton);
-#endif
-
-#ifdef Q_OS_MAC
-    QCoreApplication::setAttribute(Qt::AA_DontShowIconsInMenus);
-#endif
-
-    TiledApplication a(argc, argv);
-
-    initializeMetatypes();
-
-    // Add the built-in file formats
-    TmxMapFormat tmxMapFormat;
-    PluginManager::addObject(&tmxMapFormat);
-
-    TsxTilesetFormat tsxTilesetFormat;
-    PluginManager::addObject(&tsxTilesetFormat);
-
-    XmlObjectTemplateFormat xmlObjectTemplateFormat;
-    PluginManager::addObject(&xmlObjectTemplateFormat);
-
-    CommandLineHandler commandLine;
-
-    if (!commandLine.parse(QCoreApplication::arguments()))
-        return 0;
-    if (commandLine.quit)
-        return 0;
-    if (commandLine.disableOpenGL)
-        Preferences::instance()->setUseOpenGL(false);
-
     if (commandLine.exportMap) {
         // Get the path to the source file and target file
         if (commandLine.exportTileset || commandLine.filesToOpen().length() < 2) {
@@ -390,15 +403,15 @@ int main(int argc, char *argv[])
             return 1;
         }
 
-        initializePluginsAndExtensions();
-
         int index = 0;
         const QString *filter = commandLine.filesToOpen().length() > 2 ? &commandLine.filesToOpen().at(index++) : nullptr;
         const QString &sourceFile = commandLine.filesToOpen().at(index++);
         const QString &targetFile = commandLine.filesToOpen().at(index++);
 
+        loadPluginsFor(nullptr, sourceFile);
+
         QString errorMsg;
-        MapFormat *outputFormat = findExportFormat<MapFormat>(filter, targetFile, errorMsg);
+        MapFormat *outputFormat = findExportFormatLazily<MapFormat>(filter, targetFile, errorMsg);
         if (!outputFormat) {
             Q_ASSERT(!errorMsg.isEmpty());
             qWarning().noquote() << errorMsg;
@@ -427,6 +440,30 @@ int main(int argc, char *argv[])
         return 0;
     }
 
+    if (commandLine.exportMapBatch) {
+        if (commandLine.exportTileset || commandLine.filesToOpen().isEmpty()) {
+            qWarning().noquote() << QCoreApplication::translate("Command line", "Export syntax is --export-map-batch [format] <manifest>");
+            return 1;
+        }
+
+        initializePluginsAndExtensions();
+
+        int index = 0;
+        const QString *filter = commandLine.filesToOpen().length() > 1 ? &commandLine.filesToOpen().at(index++) : nullptr;
+        const QString &manifestFile = commandLine.filesToOpen().at(index++);
+
+        BatchExporter batchExporter(commandLine.exportOptions, filter);
+        batchExporter.setParallelJobs(commandLine.exportJobs);
+
+        QString errorMsg;
+        if (!batchExporter.readManifest(manifestFile, &errorMsg)) {
+            qWarning().noquote() << errorMsg;
+            return 1;
+        }
+
+        return batchExporter.exec() > 0 ? 1 : 0;
+    }
+
     if (commandLine.exportTileset) {
         // Get the path to the source file and target file
         if (commandLine.filesToOpen().length() < 2) {
@@ -434,15 +471,15 @@ int main(int argc, char *argv[])
             return 1;
         }
 
-        initializePluginsAndExtensions();
-
         int index = 0;
         const QString *filter = commandLine.filesToOpen().length() > 2 ? &commandLine.filesToOpen().at(index++) : nullptr;
         const QString &sourceFile = commandLine.filesToOpen().at(index++);
         const QString &targetFile = commandLine.filesToOpen().at(index++);
 
+        loadPluginsFor(nullptr, sourceFile);
+
         QString errorMsg;
-        TilesetFormat *outputFormat = findExportFormat<TilesetFormat>(filter, targetFile, errorMsg);
+        TilesetFormat *outputFormat = findExportFormatLazily<TilesetFormat>(filter, targetFile, errorMsg);
         if (!outputFormat) {
             Q_ASSERT(!errorMsg.isEmpty());
             qWarning().noquote() << errorMsg;
@@ -470,6 +507,175 @@ int main(int argc, char *argv[])
         return 0;
     }
 
+    return 0;
+}
+
+/**
+ * Determines the kind of application needed for the given arguments. This
+ * is done before creating the application, since the application type can't
+ * be changed afterwards.
+ */
+static ApplicationMode applicationMode(int argc, char *argv[])
+{
+    static const char * const exportOptions[] = {
+        "--export-map",
+        "--export-map-batch",
+        "--export-tileset",
+        "--export-formats",
+    };
+    static const char * const informationalOptions[] = {
+        "-h", "--help",
+        "-v", "--version",
+        "--quit",
+    };
+
+    bool onlyInformational = argc > 1;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (qstrcmp(arg, "--") == 0)
+            break;
+
+        for (const char *option : exportOptions)
+            if (qstrcmp(arg, option) == 0)
+                return HeadlessMode;
+
+        const auto matchesArg = [arg] (const char *option) { return qstrcmp(arg, option) == 0; };
+        if (std::none_of(std::begin(informationalOptions), std::end(informationalOptions), matchesArg))
+            onlyInformational = false;
+    }
+
+    return onlyInformational ? CoreMode : GuiMode;
+}
+
+/**
+ * Returns whether the platform plugin with the given \a name can be found,
+ * either next to the executable or in the Qt plugin paths. This check is
+ * done before creating the application, so it does not include any paths
+ * added later.
+ */
+static bool hasPlatformPlugin(const char *argv0, const QString &name)
+{
+    QStringList pluginPaths = QCoreApplication::libraryPaths();
+    pluginPaths.prepend(QFileInfo(QString::fromLocal8Bit(argv0)).absolutePath());
+
+    const QStringList nameFilters(QLatin1String("*q") + name + QLatin1Char('*'));
+
+    for (const QString &pluginPath : qAsConst(pluginPaths)) {
+        const QDir platformsDir(pluginPath + QLatin1String("/platforms"));
+        if (!platformsDir.entryList(nameFilters, QDir::Files).isEmpty())
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * Runs the command line handling without creating the main window or the
+ * single-instance TiledApplication.
+ *
+ * Exporting still needs a QApplication, since tileset images are loaded as
+ * pixmaps and scripted formats may use widgets. When available, it is run
+ * using the "minimal" platform plugin so that no display is needed.
+ * Otherwise the default platform plugin is used.
+ */
+static int runWithoutGui(int &argc, char *argv[], ApplicationMode mode)
+{
+    std::unique_ptr<QCoreApplication> app;
+
+    if (mode == CoreMode) {
+        app = std::make_unique<QCoreApplication>(argc, argv);
+    } else {
+        if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM") &&
+                hasPlatformPlugin(argv[0], QStringLiteral("minimal"))) {
+            qputenv("QT_QPA_PLATFORM", "minimal");
+        }
+        app = std::make_unique<QApplication>(argc, argv);
+    }
+
+    TiledApplication::initializeApplicationInfo();
+
+    if (mode == HeadlessMode)
+        LanguageManager::instance()->installTranslators();
+
+    PluginManager::instance();
+    initializeMetatypes();
+
+    // Add the built-in file formats
+    TmxMapFormat tmxMapFormat;
+    PluginManager::addObject(&tmxMapFormat);
+
+    TsxTilesetFormat tsxTilesetFormat;
+    PluginManager::addObject(&tsxTilesetFormat);
+
+    XmlObjectTemplateFormat xmlObjectTemplateFormat;
+    PluginManager::addObject(&xmlObjectTemplateFormat);
+
+    int result = 0;
+
+    CommandLineHandler commandLine;
+    if (commandLine.parse(QCoreApplication::arguments()) && !commandLine.quit)
+        result = runExport(commandLine);
+    else if (commandLine.invalidArguments)
+        result = 1;
+
+    TiledApplication::deleteSingletons();
+
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+#if defined(Q_OS_WIN) && (!defined(Q_CC_MINGW) || __MINGW32_MAJOR_VERSION >= 5)
+    // Make console output work on Windows, if running in a console.
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        FILE *dummy = nullptr;
+        freopen_s(&dummy, "CONOUT$", "w", stdout);
+        freopen_s(&dummy, "CONOUT$", "w", stderr);
+    }
+#endif
+
+    qInstallMessageHandler(messagesToConsole);
+
+    const ApplicationMode mode = applicationMode(argc, argv);
+    if (mode != GuiMode)
+        return runWithoutGui(argc, argv, mode);
+
+    QGuiApplication::setFallbackSessionManagementEnabled(false);
+
+    // Enable support for highres images (added in Qt 5.1, but off by default)
+    QCoreApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    QCoreApplication::setAttribute(Qt::AA_DisableWindowContextHelpButton);
+#endif
+
+#ifdef Q_OS_MAC
+    QCoreApplication::setAttribute(Qt::AA_DontShowIconsInMenus);
+#endif
+
+    TiledApplication a(argc, argv);
+
+    initializeMetatypes();
+
+    // Add the built-in file formats
+    TmxMapFormat tmxMapFormat;
+    PluginManager::addObject(&tmxMapFormat);
+
+    TsxTilesetFormat tsxTilesetFormat;
+    PluginManager::addObject(&tsxTilesetFormat);
+
+    XmlObjectTemplateFormat xmlObjectTemplateFormat;
+    PluginManager::addObject(&xmlObjectTemplateFormat);
+
+    CommandLineHandler commandLine;
+
+    if (!commandLine.parse(QCoreApplication::arguments()))
+        return 0;
+    if (commandLine.quit)
+        return commandLine.invalidArguments ? 1 : 0;
+    if (commandLine.disableOpenGL)
+        Preferences::instance()->setUseOpenGL(false);
+
     if (!commandLine.filesToOpen().isEmpty() && !commandLine.newInstance) {
         // Convert files to absolute paths because the already running Tiled
         // instance likely does not have the same working directory.
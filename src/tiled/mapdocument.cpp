@@ -43,7 +43,6 @@
 #include "mapobject.h"
 #include "mapobjectmodel.h"
 #include "movelayer.h"
-#include "movemapobject.h"
 #include "movemapobjecttogroup.h"
 #include "objectgroup.h"
 #include "offsetlayer.h"
@@ -54,7 +53,6 @@
 #include "reparentlayers.h"
 #include "resizemap.h"
 #include "resizetilelayer.h"
-#include "rotatemapobject.h"
 #include "staggeredrenderer.h"
 #include "templatemanager.h"
 #include "terrain.h"
@@ -62,6 +60,7 @@
 #include "tilelayer.h"
 #include "tilesetdocument.h"
 #include "tmxmapformat.h"
+#include "transformmapobjects.h"
 
 #include <QFileInfo>
 #include <QRect>
@@ -356,6 +355,9 @@ void MapDocument::resizeMap(QSize size, QPoint offset, bool removeObjects)
         }
         case Layer::ObjectGroupType: {
             ObjectGroup *objectGroup = static_cast<ObjectGroup*>(layer);
+            QList<MapObject*> objectsToMove;
+            TransformMapObjects::Transforms oldTransforms;
+            TransformMapObjects::Transforms newTransforms;
 
             for (MapObject *o : objectGroup->objects()) {
                 if (removeObjects && !visibleIn(visibleArea, o, *renderer())) {
@@ -364,9 +366,18 @@ void MapDocument::resizeMap(QSize size, QPoint offset, bool removeObjects)
                 } else {
                     QPointF oldPos = o->position();
                     QPointF newPos = oldPos + pixelOffset;
-                    new MoveMapObject(this, o, newPos, oldPos, command);
+                    objectsToMove.append(o);
+                    oldTransforms.positions.append(oldPos);
+                    newTransforms.positions.append(newPos);
                 }
             }
+
+            if (!objectsToMove.isEmpty()) {
+                new TransformMapObjects(this, objectsToMove,
+                                        MapObject::PositionProperty,
+                                        newTransforms, oldTransforms,
+                                        command);
+            }
             break;
         }
         case Layer::ImageLayerType: {
@@ -444,8 +455,10 @@ void MapDocument::rotateSelectedObjects(RotateDirection direction)
     if (mSelectedObjects.isEmpty())
         return;
 
-    undoStack()->beginMacro(tr("Rotate %n Object(s)", "",
-                               mSelectedObjects.size()));
+    TransformMapObjects::Transforms oldTransforms;
+    TransformMapObjects::Transforms newTransforms;
+    oldTransforms.rotations.reserve(mSelectedObjects.size());
+    newTransforms.rotations.reserve(mSelectedObjects.size());
 
     // TODO: Rotate them properly as a group
     const auto &selectedObjects = mSelectedObjects;
@@ -463,10 +476,13 @@ void MapDocument::rotateSelectedObjects(RotateDirection direction)
                 newRotation -= 360;
         }
 
-        undoStack()->push(new RotateMapObject(this, mapObject,
-                                              newRotation, oldRotation));
+        oldTransforms.rotations.append(oldRotation);
+        newTransforms.rotations.append(newRotation);
     }
-    undoStack()->endMacro();
+
+    undoStack()->push(new TransformMapObjects(this, mSelectedObjects,
+                                              MapObject::RotationProperty,
+                                              newTransforms, oldTransforms));
 }
 
 /**
@@ -1433,7 +1449,7 @@ static Ranges computeRanges(const QList<MapObject *> &objects)
     for (MapObject *object : objects) {
         ObjectGroup *group = object->objectGroup();
         auto &set = ranges[group];
-        set.insert(group->objects().indexOf(object));
+        set.insert(object->index());
     }
 
     return ranges;
@@ -41,6 +41,7 @@
 #include <QCursor>
 #include <QGraphicsSceneMouseEvent>
 #include <QPen>
+#include <QSet>
 #include <QStyleOptionGraphicsItem>
 #include <QWidget>
 
@@ -135,9 +136,11 @@ MapItem::MapItem(const MapDocumentPtr &mapDocument, DisplayMode displayMode,
     MapRenderer *renderer = mapDocument->renderer();
     renderer->setObjectLineWidth(prefs->objectLineWidth());
     renderer->setFlag(ShowTileObjectOutlines, prefs->showTileObjectOutlines());
+    renderer->setFlag(UseLevelOfDetail, prefs->useLevelOfDetail());
 
     connect(prefs, &Preferences::objectLineWidthChanged, this, &MapItem::setObjectLineWidth);
     connect(prefs, &Preferences::showTileObjectOutlinesChanged, this, &MapItem::setShowTileObjectOutlines);
+    connect(prefs, &Preferences::useLevelOfDetailChanged, this, &MapItem::setUseLevelOfDetail);
     connect(prefs, &Preferences::highlightCurrentLayerChanged, this, &MapItem::updateSelectedLayersHighlight);
     connect(prefs, &Preferences::objectTypesChanged, this, &MapItem::syncAllObjectItems);
 
@@ -337,6 +340,47 @@ void MapItem::repaintRegion(const QRegion &region, TileLayer *tileLayer)
     }
 }
 
+/**
+ * Repaints the parts of the map showing any of the given \a tiles from the
+ * given \a tileset, including animated tiles using any of them as a frame.
+ */
+void MapItem::repaintTiles(Tileset *tileset, const QList<Tile*> &tiles)
+{
+    QSet<int> changedTileIds;
+    for (const Tile *tile : tiles)
+        changedTileIds.insert(tile->id());
+
+    QSet<const Tile*> shownTiles;
+    for (const Tile *tile : tileset->tiles()) {
+        if (changedTileIds.contains(tile->id())) {
+            shownTiles.insert(tile);
+            continue;
+        }
+
+        for (const Frame &frame : tile->frames()) {
+            if (changedTileIds.contains(frame.tileId)) {
+                shownTiles.insert(tile);
+                break;
+            }
+        }
+    }
+
+    for (auto it = mLayerItems.cbegin(), it_end = mLayerItems.cend(); it != it_end; ++it) {
+        if (TileLayer *tileLayer = it.key()->asTileLayer()) {
+            QRegion region;
+            for (const Tile *tile : qAsConst(shownTiles))
+                region |= tileLayer->regionOf(tile);
+
+            if (!region.isEmpty())
+                repaintRegion(region, tileLayer);
+        }
+    }
+
+    for (MapObjectItem *item : qAsConst(mObjectItems))
+        if (shownTiles.contains(item->mapObject()->cell().tile()))
+            item->update();
+}
+
 void MapItem::documentChanged(const ChangeEvent &change)
 {
     switch (change.type) {
@@ -623,6 +667,18 @@ void MapItem::setObjectLineWidth(qreal lineWidth)
     }
 }
 
+void MapItem::setUseLevelOfDetail(bool enabled)
+{
+    MapRenderer *renderer = mapDocument()->renderer();
+    renderer->setFlag(UseLevelOfDetail, enabled);
+    if (!enabled)
+        renderer->clearLevelOfDetailCache();
+
+    for (LayerItem *item : qAsConst(mLayerItems))
+        if (item->layer()->isTileLayer())
+            item->update();
+}
+
 void MapItem::setShowTileObjectOutlines(bool enabled)
 {
     mapDocument()->renderer()->setFlag(ShowTileObjectOutlines, enabled);
@@ -73,6 +73,8 @@ public:
     void setDisplayMode(DisplayMode displayMode);
     void setShowTileCollisionShapes(bool enabled);
 
+    void repaintTiles(Tileset *tileset, const QList<Tile*> &tiles);
+
     // QGraphicsItem
     QRectF boundingRect() const override;
     void paint(QPainter *, const QStyleOptionGraphicsItem *,
@@ -122,6 +124,7 @@ private:
 
     void setObjectLineWidth(qreal lineWidth);
     void setShowTileObjectOutlines(bool enabled);
+    void setUseLevelOfDetail(bool enabled);
 
     void createLayerItems(const QList<Layer *> &layers);
     LayerItem *createLayerItem(Layer *layer);
@@ -31,9 +31,12 @@
 #include "objectgroup.h"
 
 #include <QApplication>
+#include <QHash>
 #include <QPalette>
 #include <QStyle>
 
+#include <algorithm>
+
 using namespace Tiled;
 
 ObjectIconManager::ObjectIconManager()
@@ -324,8 +327,7 @@ QModelIndex MapObjectModel::index(MapObject *mapObject, int column) const
     Q_ASSERT(mapObject->objectGroup());
     Q_ASSERT(mapObject->map() == mMap);
 
-    const int row = mapObject->objectGroup()->objects().indexOf(mapObject);
-    return createIndex(row, column, mapObject);
+    return createIndex(mapObject->index(), column, mapObject);
 }
 
 Layer *MapObjectModel::toLayer(const QModelIndex &index) const
@@ -574,9 +576,26 @@ void MapObjectModel::emitDataChanged(const QList<MapObject *> &objects,
         return;
 
     auto minMaxPair = std::minmax_element(columns.begin(), columns.end());
-    for (auto object : objects) {
-        emit dataChanged(index(object, *minMaxPair.first),
-                         index(object, *minMaxPair.second),
-                         roles);
+
+    // Emit a single signal for each range of adjacent objects
+    QHash<ObjectGroup*, QVector<int>> rowsPerGroup;
+    for (MapObject *object : objects)
+        rowsPerGroup[object->objectGroup()].append(object->index());
+
+    for (auto it = rowsPerGroup.begin(); it != rowsPerGroup.end(); ++it) {
+        ObjectGroup *objectGroup = it.key();
+        QVector<int> &rows = it.value();
+        std::sort(rows.begin(), rows.end());
+
+        int first = 0;
+        for (int i = 1; i <= rows.size(); ++i) {
+            if (i < rows.size() && rows.at(i) <= rows.at(i - 1) + 1)
+                continue;
+
+            emit dataChanged(index(objectGroup->objectAt(rows.at(first)), *minMaxPair.first),
+                             index(objectGroup->objectAt(rows.at(i - 1)), *minMaxPair.second),
+                             roles);
+            first = i;
+        }
     }
 }
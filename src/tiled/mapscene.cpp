@@ -62,6 +62,8 @@ MapScene::MapScene(QObject *parent)
             this, &MapScene::repaintTileset);
     connect(tilesetManager, &TilesetManager::repaintTileset,
             this, &MapScene::repaintTileset);
+    connect(tilesetManager, &TilesetManager::tileImagesChanged,
+            this, &MapScene::repaintTiles);
 
     WorldManager &worldManager = WorldManager::instance();
     connect(&worldManager, &WorldManager::worldsChanged, this, &MapScene::refreshScene);
@@ -258,11 +260,29 @@ void MapScene::mapChanged()
 }
 
 void MapScene::repaintTileset(Tileset *tileset)
+{
+    bool used = false;
+
+    for (MapItem *mapItem : qAsConst(mMapItems)) {
+        MapDocument *mapDocument = mapItem->mapDocument();
+        if (contains(mapDocument->map()->tilesets(), tileset)) {
+            // The down-sampled chunk images may depend on the tile images
+            mapDocument->renderer()->clearLevelOfDetailCache();
+            used = true;
+        }
+    }
+
+    if (used)
+        update();
+}
+
+void MapScene::repaintTiles(Tileset *tileset, const QList<Tile*> &tiles)
 {
     for (MapItem *mapItem : qAsConst(mMapItems)) {
-        if (contains(mapItem->mapDocument()->map()->tilesets(), tileset)) {
-            update();
-            return;
+        MapDocument *mapDocument = mapItem->mapDocument();
+        if (contains(mapDocument->map()->tilesets(), tileset)) {
+            mapDocument->renderer()->clearLevelOfDetailCache();
+            mapItem->repaintTiles(tileset, tiles);
         }
     }
 }
@@ -92,6 +92,7 @@ private:
 
     void mapChanged();
     void repaintTileset(Tileset *tileset);
+    void repaintTiles(Tileset *tileset, const QList<Tile*> &tiles);
 
     void tilesetReplaced(int index, Tileset *tileset, Tileset *oldTileset);
 
@@ -517,6 +517,10 @@ void ObjectSelectionItem::syncOverlayItems(const QList<MapObject*> &objects)
 {
     const MapRenderer &renderer = *mMapDocument->renderer();
 
+    // Changes to many objects arrive in a single event, so avoid looking up
+    // each object in the overlay item maps that are empty anyway.
+    const bool hasReferences = !mReferencesBySourceObject.isEmpty();
+
     for (MapObject *object : objects) {
         if (MapObjectOutline *outlineItem = mObjectOutlines.value(object))
             outlineItem->syncWithMapObject(renderer);
@@ -524,13 +528,15 @@ void ObjectSelectionItem::syncOverlayItems(const QList<MapObject*> &objects)
         if (MapObjectLabel *labelItem = mObjectLabels.value(object))
             labelItem->syncWithMapObject(renderer);
 
-        const auto sourceItems = mReferencesBySourceObject.value(object);
-        for (auto item : sourceItems)
-            item->syncWithSourceObject(renderer);
+        if (hasReferences) {
+            const auto sourceItems = mReferencesBySourceObject.value(object);
+            for (auto item : sourceItems)
+                item->syncWithSourceObject(renderer);
 
-        const auto targetItems = mReferencesByTargetObject.value(object);
-        for (auto item : targetItems)
-            item->syncWithTargetObject(renderer);
+            const auto targetItems = mReferencesByTargetObject.value(object);
+            for (auto item : targetItems)
+                item->syncWithTargetObject(renderer);
+        }
 
         if (mHoveredMapObjectItem && mHoveredMapObjectItem->mapObject() == object)
             mHoveredMapObjectItem->syncWithMapObject();
@@ -21,7 +21,6 @@
 #include "objectselectiontool.h"
 
 #include "changeevents.h"
-#include "changepolygon.h"
 #include "editpolygontool.h"
 #include "geometry.h"
 #include "layer.h"
@@ -32,17 +31,15 @@
 #include "mapobjectmodel.h"
 #include "maprenderer.h"
 #include "mapscene.h"
-#include "movemapobject.h"
 #include "objectgroup.h"
 #include "preferences.h"
 #include "raiselowerhelper.h"
-#include "resizemapobject.h"
-#include "rotatemapobject.h"
 #include "selectionrectangle.h"
 #include "snaphelper.h"
 #include "tile.h"
 #include "tileset.h"
 #include "toolmanager.h"
+#include "transformmapobjects.h"
 #include "utils.h"
 
 #include <QApplication>
@@ -436,16 +433,22 @@ void ObjectSelectionTool::keyPressed(QKeyEvent *event)
             moveBy /= Preferences::instance()->gridFine();
     }
 
-    QUndoStack *undoStack = mapDocument()->undoStack();
-    undoStack->beginMacro(tr("Move %n Object(s)", "", objects.size()));
-    int i = 0;
+    TransformMapObjects::Transforms oldTransforms;
+    TransformMapObjects::Transforms newTransforms;
+    oldTransforms.positions.reserve(objects.size());
+    newTransforms.positions.reserve(objects.size());
+
     for (MapObject *object : objects) {
         const QPointF oldPos = object->position();
-        const QPointF newPos = oldPos + moveBy;
-        undoStack->push(new MoveMapObject(mapDocument(), object, newPos, oldPos));
-        ++i;
+        oldTransforms.positions.append(oldPos);
+        newTransforms.positions.append(oldPos + moveBy);
     }
-    undoStack->endMacro();
+
+    mapDocument()->undoStack()->push(new TransformMapObjects(mapDocument(),
+                                                             objects,
+                                                             MapObject::PositionProperty,
+                                                             newTransforms,
+                                                             oldTransforms));
 }
 
 void ObjectSelectionTool::mouseEntered()
@@ -1178,14 +1181,7 @@ void ObjectSelectionTool::finishMoving(const QPointF &pos)
     if (mStart == pos) // Move is a no-op
         return;
 
-    QUndoStack *undoStack = mapDocument()->undoStack();
-    undoStack->beginMacro(tr("Move %n Object(s)", "", mMovingObjects.size()));
-    for (const MovingObject &object : qAsConst(mMovingObjects)) {
-        undoStack->push(new MoveMapObject(mapDocument(),
-                                          object.mapObject,
-                                          object.oldPosition));
-    }
-    undoStack->endMacro();
+    pushTransformCommand(MapObject::PositionProperty);
 
     mMovingObjects.clear();
 }
@@ -1269,16 +1265,7 @@ void ObjectSelectionTool::finishRotating(const QPointF &pos)
     if (mStart == pos) // No rotation at all
         return;
 
-    QUndoStack *undoStack = mapDocument()->undoStack();
-    undoStack->beginMacro(tr("Rotate %n Object(s)", "", mMovingObjects.size()));
-
-    for (const MovingObject &object : qAsConst(mMovingObjects)) {
-        MapObject *mapObject = object.mapObject;
-        undoStack->push(new MoveMapObject(mapDocument(), mapObject, object.oldPosition));
-        undoStack->push(new RotateMapObject(mapDocument(), mapObject, object.oldRotation));
-    }
-
-    undoStack->endMacro();
+    pushTransformCommand(MapObject::PositionProperty | MapObject::RotationProperty);
 
     mMovingObjects.clear();
 }
@@ -1544,19 +1531,9 @@ void ObjectSelectionTool::finishResizing(const QPointF &pos)
     if (mStart == pos) // No scaling at all
         return;
 
-    QUndoStack *undoStack = mapDocument()->undoStack();
-    undoStack->beginMacro(tr("Resize %n Object(s)", "", mMovingObjects.size()));
-
-    for (const MovingObject &object : qAsConst(mMovingObjects)) {
-        MapObject *mapObject = object.mapObject;
-        undoStack->push(new MoveMapObject(mapDocument(), mapObject, object.oldPosition));
-        undoStack->push(new ResizeMapObject(mapDocument(), mapObject, object.oldSize));
-
-        if (!object.oldPolygon.isEmpty())
-            undoStack->push(new ChangePolygon(mapDocument(), mapObject, object.oldPolygon));
-    }
-
-    undoStack->endMacro();
+    pushTransformCommand(MapObject::PositionProperty |
+                         MapObject::SizeProperty |
+                         MapObject::ShapeProperty);
 
     mMovingObjects.clear();
 }
@@ -1704,3 +1681,28 @@ QList<MapObject *> ObjectSelectionTool::changingObjects() const
 
     return changingObjects;
 }
+
+/**
+ * Pushes a single command that records the change of the given
+ * \a properties for all moving objects.
+ */
+void ObjectSelectionTool::pushTransformCommand(MapObject::ChangedProperties properties)
+{
+    TransformMapObjects::Transforms oldTransforms;
+
+    for (const MovingObject &object : qAsConst(mMovingObjects)) {
+        if (properties & MapObject::PositionProperty)
+            oldTransforms.positions.append(object.oldPosition);
+        if (properties & MapObject::SizeProperty)
+            oldTransforms.sizes.append(object.oldSize);
+        if (properties & MapObject::RotationProperty)
+            oldTransforms.rotations.append(object.oldRotation);
+        if (properties & MapObject::ShapeProperty)
+            oldTransforms.polygons.append(object.oldPolygon);
+    }
+
+    mapDocument()->undoStack()->push(new TransformMapObjects(mapDocument(),
+                                                             changingObjects(),
+                                                             properties,
+                                                             oldTransforms));
+}
@@ -115,6 +115,8 @@ private:
                                   Qt::KeyboardModifiers modifiers);
     void finishResizing(const QPointF &pos);
 
+    void pushTransformCommand(MapObject::ChangedProperties properties);
+
     void setMode(Mode mode);
     void saveSelectionState();
 
@@ -24,6 +24,7 @@
 #include "iconcheckdelegate.h"
 #include "mapdocument.h"
 #include "mapobjectmodel.h"
+#include "objectgroup.h"
 #include "preferences.h"
 #include "reversingproxymodel.h"
 #include "utils.h"
@@ -31,12 +32,18 @@
 
 #include <QAction>
 #include <QGuiApplication>
+#include <QHash>
 #include <QHeaderView>
 #include <QKeyEvent>
 #include <QMenu>
 #include <QPainter>
+#include <QSet>
 #include <QSettings>
 
+#include <algorithm>
+
+#include "qtcompat_p.h"
+
 namespace Tiled {
 
 static const char FIRST_COLUMN_WIDTH_KEY[] = "ObjectsDock/FirstSectionSize";
@@ -374,9 +381,25 @@ void ObjectsView::synchronizeSelectedItems()
 
     QItemSelection itemSelection;
 
-    for (MapObject *o : mMapDocument->selectedObjects()) {
-        QModelIndex index = mProxyModel->mapFromSource(mapObjectModel()->index(o));
-        itemSelection.select(index, index);
+    // Select adjacent objects as a single range, since large selections
+    // consisting of individual rows are very slow to process
+    QHash<ObjectGroup*, QVector<int>> rowsPerGroup;
+    for (MapObject *o : mMapDocument->selectedObjects())
+        rowsPerGroup[o->objectGroup()].append(o->index());
+
+    for (auto it = rowsPerGroup.begin(); it != rowsPerGroup.end(); ++it) {
+        ObjectGroup *objectGroup = it.key();
+        QVector<int> &rows = it.value();
+        std::sort(rows.begin(), rows.end());
+
+        int first = 0;
+        for (int i = 1; i <= rows.size(); ++i) {
+            if (i < rows.size() && rows.at(i) <= rows.at(i - 1) + 1)
+                continue;
+
+            selectObjects(itemSelection, objectGroup, rows.at(first), rows.at(i - 1));
+            first = i;
+        }
     }
 
     mSynching = true;
@@ -387,14 +410,45 @@ void ObjectsView::synchronizeSelectedItems()
     mSynching = false;
 }
 
+/**
+ * Adds the objects \a first to \a last of the given \a objectGroup to
+ * \a selection. The rows are added as a single range when they are also
+ * adjacent in the proxy model.
+ */
+void ObjectsView::selectObjects(QItemSelection &selection,
+                                ObjectGroup *objectGroup,
+                                int first, int last) const
+{
+    const QModelIndex firstIndex = mProxyModel->mapFromSource(mapObjectModel()->index(objectGroup->objectAt(first)));
+    const QModelIndex lastIndex = mProxyModel->mapFromSource(mapObjectModel()->index(objectGroup->objectAt(last)));
+
+    if (firstIndex.isValid() && lastIndex.isValid() &&
+            qAbs(lastIndex.row() - firstIndex.row()) == last - first) {
+        if (firstIndex.row() <= lastIndex.row())
+            selection.select(firstIndex, lastIndex);
+        else
+            selection.select(lastIndex, firstIndex);
+        return;
+    }
+
+    // Some objects in between may be filtered out
+    for (int row = first; row <= last; ++row) {
+        const QModelIndex index = mProxyModel->mapFromSource(mapObjectModel()->index(objectGroup->objectAt(row)));
+        selection.select(index, index);
+    }
+}
+
 void ObjectsView::expandToSelectedObjects()
 {
-    const QList<MapObject *> &selectedObjects = mMapDocument->selectedObjects();
-    for (auto object : selectedObjects) {
-        auto index = mProxyModel->mapFromSource(mapObjectModel()->index(object));
+    QSet<ObjectGroup*> objectGroups;
+    for (MapObject *object : mMapDocument->selectedObjects())
+        objectGroups.insert(object->objectGroup());
+
+    for (ObjectGroup *objectGroup : qAsConst(objectGroups)) {
+        auto index = mProxyModel->mapFromSource(mapObjectModel()->index(objectGroup));
 
-        // Make sure all parents are expanded
-        for (QModelIndex parent = index.parent(); parent.isValid(); parent = parent.parent())
+        // Make sure the layer and all its parents are expanded
+        for (QModelIndex parent = index; parent.isValid(); parent = parent.parent())
             if (!isExpanded(parent))
                 expand(parent);
     }
@@ -27,6 +27,7 @@ namespace Tiled {
 
 class Layer;
 class MapObject;
+class ObjectGroup;
 
 class MapDocument;
 class MapObjectModel;
@@ -79,6 +80,8 @@ private:
 
     void restoreVisibleColumns();
     void synchronizeSelectedItems();
+    void selectObjects(QItemSelection &selection, ObjectGroup *objectGroup,
+                       int first, int last) const;
     void expandToSelectedObjects();
 
     void updateRow(MapObject *object);
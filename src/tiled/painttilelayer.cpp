@@ -73,6 +73,14 @@ PaintTileLayer::~PaintTileLayer()
 
 void PaintTileLayer::undo()
 {
+    if (!restoreLayerData()) {
+        // The cells could not be restored, drop this command
+#if QT_VERSION >= 0x050900
+        setObsolete(true);
+#endif
+        return;
+    }
+
     for (const std::pair<TileLayer* const, LayerData> &entry : mLayerData) {
         const LayerData &data = entry.second;
         TilePainter painter(mMapDocument, entry.first);
@@ -84,6 +92,14 @@ void PaintTileLayer::undo()
 
 void PaintTileLayer::redo()
 {
+    if (!restoreLayerData()) {
+        // The cells could not be restored, drop this command
+#if QT_VERSION >= 0x050900
+        setObsolete(true);
+#endif
+        return;
+    }
+
     QUndoCommand::redo(); // redo child commands
 
     for (const std::pair<TileLayer* const, LayerData> &entry : mLayerData) {
@@ -93,6 +109,21 @@ void PaintTileLayer::redo()
     }
 }
 
+/**
+ * Makes sure the cells of all layers are available before any of them is
+ * changed, so that a command is never applied only partially.
+ */
+bool PaintTileLayer::restoreLayerData() const
+{
+    for (const std::pair<TileLayer* const, LayerData> &entry : mLayerData) {
+        const LayerData &data = entry.second;
+        if (!data.mSource.get() || !data.mErased.get())
+            return false;
+    }
+
+    return true;
+}
+
 void PaintTileLayer::LayerData::mergeWith(const PaintTileLayer::LayerData &o)
 {
     if (!mSource) {
@@ -131,11 +162,15 @@ bool PaintTileLayer::mergeWith(const QUndoCommand *other)
     const PaintTileLayer *o = static_cast<const PaintTileLayer*>(other);
     if (!(mMapDocument == o->mMapDocument && o->mMergeable))
         return false;
+    if (!restoreLayerData() || !o->restoreLayerData())
+        return false;
     if (!cloneChildren(other, this))
         return false;
 
     for (const std::pair<TileLayer* const, LayerData> &entry : o->mLayerData)
         mLayerData[entry.first].mergeWith(entry.second);
 
+    UndoTileLayer::enforceMemoryBudget();
+
     return true;
 }
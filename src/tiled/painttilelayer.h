@@ -21,6 +21,7 @@
 #pragma once
 
 #include "undocommands.h"
+#include "undotilelayer.h"
 
 #include <QRegion>
 #include <QUndoCommand>
@@ -93,12 +94,14 @@ private:
     {
         void mergeWith(const LayerData &o);
 
-        std::unique_ptr<TileLayer> mSource;
-        std::unique_ptr<TileLayer> mErased;
+        UndoTileLayer mSource;
+        UndoTileLayer mErased;
         int mX, mY;
         QRegion mPaintedRegion;
     };
 
+    bool restoreLayerData() const;
+
     MapDocument *mMapDocument;
     std::unordered_map<TileLayer*, LayerData> mLayerData;
     bool mMergeable;
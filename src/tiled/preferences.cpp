@@ -27,6 +27,7 @@
 #include "pluginmanager.h"
 #include "savefile.h"
 #include "tilesetmanager.h"
+#include "undotilelayer.h"
 
 #include <QDir>
 #include <QFileInfo>
@@ -72,6 +73,7 @@ Preferences::Preferences()
     mSafeSavingEnabled = boolValue("SafeSavingEnabled", true);
     mExportOnSave = boolValue("ExportOnSave", false);
     mReloadTilesetsOnChange = boolValue("ReloadTilesets", true);
+    mUndoMemoryBudget = intValue("UndoMemoryBudget", 256);
     mStampsDirectory = stringValue("StampsDirectory");
     mTemplatesDirectory = stringValue("TemplatesDirectory");
     mObjectTypesFile = stringValue("ObjectTypesFile");
@@ -104,6 +106,7 @@ Preferences::Preferences()
     mShowTilesetGrid = boolValue("ShowTilesetGrid", true);
     mLanguage = stringValue("Language");
     mUseOpenGL = boolValue("OpenGL");
+    mUseLevelOfDetail = boolValue("LevelOfDetail", true);
     mWheelZoomsByDefault = boolValue("WheelZoomsByDefault");
     mObjectLabelVisibility = static_cast<ObjectLabelVisiblity>
             (intValue("ObjectLabelVisibility", AllObjectLabels));
@@ -194,6 +197,8 @@ Preferences::Preferences()
     tilesetManager->setReloadTilesetsOnChange(mReloadTilesetsOnChange);
     tilesetManager->setAnimateTiles(mShowTileAnimations);
 
+    UndoTileLayer::setMemoryBudget(qint64(mUndoMemoryBudget) * 1024 * 1024);
+
     // Read the lists of enabled and disabled plugins
     const QStringList disabledPlugins = mSettings->value(QLatin1String("Plugins/Disabled")).toStringList();
     const QStringList enabledPlugins = mSettings->value(QLatin1String("Plugins/Enabled")).toStringList();
@@ -528,6 +533,22 @@ void Preferences::setReloadTilesetsOnChanged(bool value)
     tilesetManager->setReloadTilesetsOnChange(mReloadTilesetsOnChange);
 }
 
+/**
+ * Sets the memory budget for the tile data in the undo history. A value of
+ * 0 disables compressing the undo history.
+ */
+void Preferences::setUndoMemoryBudget(int megabytes)
+{
+    if (mUndoMemoryBudget == megabytes)
+        return;
+
+    mUndoMemoryBudget = megabytes;
+    mSettings->setValue(QLatin1String("Storage/UndoMemoryBudget"),
+                        mUndoMemoryBudget);
+
+    UndoTileLayer::setMemoryBudget(qint64(mUndoMemoryBudget) * 1024 * 1024);
+}
+
 void Preferences::setUseOpenGL(bool useOpenGL)
 {
     if (mUseOpenGL == useOpenGL)
@@ -539,6 +560,17 @@ void Preferences::setUseOpenGL(bool useOpenGL)
     emit useOpenGLChanged(mUseOpenGL);
 }
 
+void Preferences::setUseLevelOfDetail(bool useLevelOfDetail)
+{
+    if (mUseLevelOfDetail == useLevelOfDetail)
+        return;
+
+    mUseLevelOfDetail = useLevelOfDetail;
+    mSettings->setValue(QLatin1String("Interface/LevelOfDetail"), mUseLevelOfDetail);
+
+    emit useLevelOfDetailChanged(mUseLevelOfDetail);
+}
+
 void Preferences::setObjectTypes(const ObjectTypes &objectTypes)
 {
     Object::setObjectTypes(objectTypes);
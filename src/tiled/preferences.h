@@ -119,9 +119,15 @@ public:
     bool reloadTilesetsOnChange() const;
     void setReloadTilesetsOnChanged(bool value);
 
+    int undoMemoryBudget() const;
+    void setUndoMemoryBudget(int megabytes);
+
     bool useOpenGL() const;
     void setUseOpenGL(bool useOpenGL);
 
+    bool useLevelOfDetail() const;
+    void setUseLevelOfDetail(bool useLevelOfDetail);
+
     void setObjectTypes(const ObjectTypes &objectTypes);
 
     enum FileType {
@@ -234,6 +240,7 @@ signals:
     void selectionColorChanged(const QColor &selectionColor);
 
     void useOpenGLChanged(bool useOpenGL);
+    void useLevelOfDetailChanged(bool useLevelOfDetail);
 
     void languageChanged();
 
@@ -301,7 +308,9 @@ private:
     ExportOptions mExportOptions;
     QString mLanguage;
     bool mReloadTilesetsOnChange;
+    int mUndoMemoryBudget;
     bool mUseOpenGL;
+    bool mUseLevelOfDetail;
 
     bool mAutoMapDrawing;
 
@@ -456,11 +465,25 @@ inline bool Preferences::reloadTilesetsOnChange() const
     return mReloadTilesetsOnChange;
 }
 
+/**
+ * Returns the amount of memory in megabytes the tile data in the undo
+ * history may take before it gets compressed.
+ */
+inline int Preferences::undoMemoryBudget() const
+{
+    return mUndoMemoryBudget;
+}
+
 inline bool Preferences::useOpenGL() const
 {
     return mUseOpenGL;
 }
 
+inline bool Preferences::useLevelOfDetail() const
+{
+    return mUseLevelOfDetail;
+}
+
 inline bool Preferences::automappingDrawing() const
 {
     return mAutoMapDrawing;
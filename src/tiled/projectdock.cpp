@@ -224,6 +224,19 @@ void ProjectView::contextMenuEvent(QContextMenuEvent *event)
                     p.save(p.fileName());
             });
             Utils::setThemeIcon(removeFolder, "list-remove");
+        } else {
+            const QString path = model()->filePath(index);
+            const QStringList users = model()->assetIndex().filesReferencing(path);
+
+            if (!users.isEmpty()) {
+                QMenu *usedByMenu = menu.addMenu(tr("&Used By"));
+                for (const QString &user : users) {
+                    usedByMenu->addAction(QFileInfo(user).fileName(), [user] {
+                        DocumentManager::instance()->openFile(user);
+                    })->setToolTip(user);
+                }
+                usedByMenu->setToolTipsVisible(true);
+            }
         }
     } else {
         menu.addAction(ActionManager::action("AddFolderToProject"));
@@ -0,0 +1,726 @@
+/*
+ * projectindex.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "projectindex.h"
+
+#include "project.h"
+#include "savefile.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QXmlStreamReader>
+
+#include "qtcompat_p.h"
+
+#include <memory>
+
+namespace Tiled {
+
+static const quint32 IndexMagic = 0x54494458;     // "TIDX"
+static const quint32 IndexVersion = 1;
+
+struct IndexRequest
+{
+    int generation = 0;
+    bool reset = false;
+    AssetHash assets;       // the assets known so far, when resetting
+    QStringList folders;    // the folders to scan completely
+    QStringList paths;      // changed files or directories
+};
+
+struct IndexUpdate
+{
+    int generation = 0;
+    AssetHash changed;
+    QStringList removed;
+    QStringList directories;
+    QStringList removedDirectories;
+
+    bool isEmpty() const
+    {
+        return changed.isEmpty() && removed.isEmpty() &&
+                directories.isEmpty() && removedDirectories.isEmpty();
+    }
+};
+
+/**
+ * Indexes files on the indexing thread. It keeps its own copy of the index,
+ * which is used to skip files that did not change.
+ */
+class AssetIndexer : public QObject
+{
+    Q_OBJECT
+
+public:
+    AssetIndexer();
+
+    void index(IndexRequest *request);
+
+signals:
+    void indexed(IndexUpdate *update);
+
+private:
+    void scanFolder(const QString &folder,
+                    IndexUpdate &update,
+                    QSet<QString> &foundFiles,
+                    QSet<QString> &visitedFolders);
+    void indexPath(const QString &path, IndexUpdate &update);
+    void indexFileIfChanged(const QFileInfo &fileInfo, IndexUpdate &update);
+    void removeDirectory(const QString &directory, IndexUpdate &update);
+
+    bool isIndexed(const QFileInfo &fileInfo) const;
+
+    int mGeneration = 0;
+    AssetHash mAssets;
+    QSet<QString> mDirectories;
+    QSet<QString> mImageSuffixes;
+};
+
+
+static void addReference(QStringList &references, const QDir &dir, const QString &reference)
+{
+    if (reference.isEmpty() || reference.contains(QLatin1String("://")))
+        return;
+
+    references.append(QDir::cleanPath(dir.absoluteFilePath(reference)));
+}
+
+/**
+ * Collects the tilesets, images, templates and file properties referred to
+ * by a map, tileset or template in XML format.
+ */
+static QStringList xmlReferences(const QByteArray &data, const QDir &dir)
+{
+    QStringList references;
+    QXmlStreamReader xml(data);
+
+    while (!xml.atEnd()) {
+        if (xml.readNext() != QXmlStreamReader::StartElement)
+            continue;
+
+        const QXmlStreamAttributes attributes = xml.attributes();
+        const auto name = xml.name();
+
+        if (name == QLatin1String("tileset") || name == QLatin1String("image")) {
+            addReference(references, dir, attributes.value(QLatin1String("source")).toString());
+        } else if (name == QLatin1String("object")) {
+            addReference(references, dir, attributes.value(QLatin1String("template")).toString());
+        } else if (name == QLatin1String("property")) {
+            if (attributes.value(QLatin1String("type")) == QLatin1String("file"))
+                addReference(references, dir, attributes.value(QLatin1String("value")).toString());
+        }
+    }
+
+    return references;
+}
+
+static void collectJsonReferences(const QJsonValue &value, const QDir &dir, QStringList &references)
+{
+    if (value.isArray()) {
+        const QJsonArray array = value.toArray();
+        for (const QJsonValue &element : array)
+            collectJsonReferences(element, dir, references);
+        return;
+    }
+
+    if (!value.isObject())
+        return;
+
+    const QJsonObject object = value.toObject();
+
+    for (auto it = object.begin(); it != object.end(); ++it) {
+        const QString &key = it.key();
+
+        if (it.value().isString()) {
+            if (key == QLatin1String("source") ||
+                    key == QLatin1String("image") ||
+                    key == QLatin1String("template")) {
+                addReference(references, dir, it.value().toString());
+            } else if (key == QLatin1String("value") &&
+                       object.value(QLatin1String("type")).toString() == QLatin1String("file")) {
+                addReference(references, dir, it.value().toString());
+            }
+        } else {
+            collectJsonReferences(it.value(), dir, references);
+        }
+    }
+}
+
+bool AssetInfo::isUpToDate(const QFileInfo &fileInfo) const
+{
+    return size == fileInfo.size() &&
+            lastModified == fileInfo.lastModified().toMSecsSinceEpoch();
+}
+
+
+AssetIndexer::AssetIndexer()
+{
+    const auto formats = QImageReader::supportedImageFormats();
+    for (const QByteArray &format : formats)
+        mImageSuffixes.insert(QString::fromLatin1(format).toLower());
+}
+
+void AssetIndexer::index(IndexRequest *requestPointer)
+{
+    const std::unique_ptr<IndexRequest> request { requestPointer };
+
+    if (request->reset) {
+        mGeneration = request->generation;
+        mAssets = request->assets;
+        mDirectories.clear();
+    }
+
+    auto update = std::make_unique<IndexUpdate>();
+    update->generation = mGeneration;
+
+    if (!request->folders.isEmpty() || request->reset) {
+        QSet<QString> foundFiles;
+        QSet<QString> visitedFolders;
+
+        for (const QString &folder : qAsConst(request->folders))
+            scanFolder(folder, *update, foundFiles, visitedFolders);
+
+        if (QThread::currentThread()->isInterruptionRequested())
+            return;
+
+        // Remove the files that are no longer part of the project
+        for (auto it = mAssets.begin(); it != mAssets.end(); ) {
+            if (!foundFiles.contains(it.key())) {
+                update->removed.append(it.key());
+                it = mAssets.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        for (const QString &directory : qAsConst(mDirectories)) {
+            if (!visitedFolders.contains(directory))
+                update->removedDirectories.append(directory);
+        }
+
+        for (const QString &directory : qAsConst(visitedFolders)) {
+            if (!mDirectories.contains(directory))
+                update->directories.append(directory);
+        }
+
+        mDirectories = visitedFolders;
+    }
+
+    for (const QString &path : qAsConst(request->paths))
+        indexPath(path, *update);
+
+    if (!update->isEmpty() || request->reset)
+        emit indexed(update.release());
+}
+
+void AssetIndexer::scanFolder(const QString &folder,
+                              IndexUpdate &update,
+                              QSet<QString> &foundFiles,
+                              QSet<QString> &visitedFolders)
+{
+    if (QThread::currentThread()->isInterruptionRequested())
+        return;
+
+    // Prevent potential endless symlink loop
+    if (visitedFolders.contains(folder))
+        return;
+
+    visitedFolders.insert(folder);
+
+    constexpr QDir::Filters filters { QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot };
+    const auto list = QDir(folder).entryInfoList(filters);
+
+    for (const QFileInfo &fileInfo : list) {
+        if (fileInfo.isDir()) {
+            if (!fileInfo.isSymLink())
+                scanFolder(fileInfo.filePath(), update, foundFiles, visitedFolders);
+        } else if (isIndexed(fileInfo)) {
+            foundFiles.insert(fileInfo.filePath());
+            indexFileIfChanged(fileInfo, update);
+        }
+    }
+}
+
+/**
+ * Updates the index for a changed file or directory.
+ */
+void AssetIndexer::indexPath(const QString &path, IndexUpdate &update)
+{
+    const QFileInfo fileInfo(path);
+
+    if (fileInfo.isDir()) {
+        if (!mDirectories.contains(path)) {
+            // Only directories that are part of the project are indexed
+            if (!mDirectories.contains(fileInfo.path()))
+                return;
+
+            QSet<QString> foundFiles;
+            QSet<QString> visitedFolders;
+            scanFolder(path, update, foundFiles, visitedFolders);
+
+            for (const QString &directory : qAsConst(visitedFolders)) {
+                mDirectories.insert(directory);
+                update.directories.append(directory);
+            }
+            return;
+        }
+
+        // Look for added or changed files and new subdirectories
+        constexpr QDir::Filters filters { QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot };
+        const auto list = QDir(path).entryInfoList(filters);
+        QSet<QString> existing;
+
+        for (const QFileInfo &entry : list) {
+            existing.insert(entry.filePath());
+
+            if (entry.isDir()) {
+                if (!entry.isSymLink() && !mDirectories.contains(entry.filePath()))
+                    indexPath(entry.filePath(), update);
+            } else if (isIndexed(entry)) {
+                indexFileIfChanged(entry, update);
+            }
+        }
+
+        // Look for removed files and subdirectories
+        for (auto it = mAssets.begin(); it != mAssets.end(); ) {
+            if (QFileInfo(it.key()).path() == path && !existing.contains(it.key())) {
+                update.removed.append(it.key());
+                it = mAssets.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        const auto directories = mDirectories;
+        for (const QString &directory : directories)
+            if (QFileInfo(directory).path() == path && !existing.contains(directory))
+                removeDirectory(directory, update);
+
+    } else if (fileInfo.exists()) {
+        if (mDirectories.contains(fileInfo.path()) && isIndexed(fileInfo))
+            indexFileIfChanged(fileInfo, update);
+    } else if (mAssets.remove(path)) {
+        update.removed.append(path);
+    } else if (mDirectories.contains(path)) {
+        removeDirectory(path, update);
+    }
+}
+
+void AssetIndexer::indexFileIfChanged(const QFileInfo &fileInfo, IndexUpdate &update)
+{
+    const QString filePath = fileInfo.filePath();
+
+    auto it = mAssets.constFind(filePath);
+    if (it != mAssets.constEnd() && it.value().isUpToDate(fileInfo))
+        return;
+
+    AssetInfo asset;
+    asset.size = fileInfo.size();
+    asset.lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    const QString suffix = fileInfo.suffix().toLower();
+    if (suffix == QLatin1String("tmx"))
+        asset.type = AssetInfo::Map;
+    else if (suffix == QLatin1String("tsx"))
+        asset.type = AssetInfo::Tileset;
+    else if (suffix == QLatin1String("tx"))
+        asset.type = AssetInfo::Template;
+    else if (mImageSuffixes.contains(suffix))
+        asset.type = AssetInfo::Image;
+
+    QFile file(filePath);
+    if (file.open(QIODevice::ReadOnly)) {
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+
+        if (asset.type == AssetInfo::Image) {
+            hash.addData(&file);
+        } else {
+            const QByteArray data = file.readAll();
+            const QDir dir = fileInfo.dir();
+            hash.addData(data);
+
+            if (suffix == QLatin1String("json")) {
+                const QJsonObject object = QJsonDocument::fromJson(data).object();
+                const QString type = object.value(QLatin1String("type")).toString();
+
+                if (type == QLatin1String("map"))
+                    asset.type = AssetInfo::Map;
+                else if (type == QLatin1String("tileset"))
+                    asset.type = AssetInfo::Tileset;
+                else if (type == QLatin1String("template"))
+                    asset.type = AssetInfo::Template;
+
+                if (asset.type != AssetInfo::Other)
+                    collectJsonReferences(object, dir, asset.references);
+            } else {
+                asset.references = xmlReferences(data, dir);
+            }
+
+            asset.references.removeDuplicates();
+        }
+
+        asset.hash = hash.result();
+    }
+
+    mAssets.insert(filePath, asset);
+    update.changed.insert(filePath, asset);
+}
+
+void AssetIndexer::removeDirectory(const QString &directory, IndexUpdate &update)
+{
+    const QString prefix = directory + QLatin1Char('/');
+
+    for (auto it = mAssets.begin(); it != mAssets.end(); ) {
+        if (it.key().startsWith(prefix)) {
+            update.removed.append(it.key());
+            it = mAssets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = mDirectories.begin(); it != mDirectories.end(); ) {
+        if (*it == directory || it->startsWith(prefix)) {
+            update.removedDirectories.append(*it);
+            it = mDirectories.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/**
+ * Returns whether the given file is of a type included in the index.
+ */
+bool AssetIndexer::isIndexed(const QFileInfo &fileInfo) const
+{
+    const QString suffix = fileInfo.suffix().toLower();
+    return suffix == QLatin1String("tmx") ||
+            suffix == QLatin1String("tsx") ||
+            suffix == QLatin1String("tx") ||
+            suffix == QLatin1String("json") ||
+            mImageSuffixes.contains(suffix);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+ProjectIndex *ProjectIndex::mInstance;
+
+ProjectIndex::ProjectIndex(const Project &project, QObject *parent)
+    : QObject(parent)
+    , mProject(project)
+{
+    Q_ASSERT(!mInstance);
+    mInstance = this;
+
+    AssetIndexer *indexer = new AssetIndexer;
+    indexer->moveToThread(&mIndexingThread);
+    connect(&mIndexingThread, &QThread::finished, indexer, &QObject::deleteLater);
+    connect(this, &ProjectIndex::indexRequested, indexer, &AssetIndexer::index);
+    connect(indexer, &AssetIndexer::indexed, this, &ProjectIndex::indexUpdated);
+    mIndexingThread.start(QThread::LowPriority);
+
+    connect(&mWatcher, &FileSystemWatcher::pathsChanged,
+            this, &ProjectIndex::pathsChanged);
+
+    mSaveTimer.setInterval(2000);
+    mSaveTimer.setSingleShot(true);
+    connect(&mSaveTimer, &QTimer::timeout, this, &ProjectIndex::save);
+}
+
+ProjectIndex::~ProjectIndex()
+{
+    if (mSaveTimer.isActive())
+        save();
+
+    mIndexingThread.requestInterruption();
+    mIndexingThread.quit();
+    mIndexingThread.wait();
+
+    mInstance = nullptr;
+}
+
+/**
+ * Loads the index of the current project and starts checking its folders
+ * for changes. Should be called when the project was changed.
+ */
+void ProjectIndex::reset()
+{
+    // Write any pending changes to the index of the previous project
+    if (mSaveTimer.isActive()) {
+        mSaveTimer.stop();
+        write();
+    }
+
+    ++mGeneration;
+
+    mWatcher.clear();
+    mWatchedDirectories.clear();
+    mAssets.clear();
+    mReferencedBy.clear();
+    mFilesByName.clear();
+
+    mFileName.clear();
+    if (!mProject.fileName().isEmpty())
+        mFileName = indexFileName(mProject.fileName());
+
+    load();
+
+    auto request = new IndexRequest;
+    request->generation = mGeneration;
+    request->reset = true;
+    request->assets = mAssets;
+    request->folders = mProject.folders();
+    emit indexRequested(request);
+
+    emit updated();
+}
+
+/**
+ * Checks all the folders of the project for changes.
+ */
+void ProjectIndex::refresh()
+{
+    auto request = new IndexRequest;
+    request->generation = mGeneration;
+    request->folders = mProject.folders();
+    emit indexRequested(request);
+}
+
+/**
+ * Returns the indexed files with the given \a fileName, in any folder.
+ */
+QStringList ProjectIndex::filesNamed(const QString &fileName) const
+{
+    QStringList result = mFilesByName.value(fileName).values();
+    result.sort();
+    return result;
+}
+
+/**
+ * Returns the indexed files that refer to the file at \a filePath.
+ */
+QStringList ProjectIndex::filesReferencing(const QString &filePath) const
+{
+    QStringList result = mReferencedBy.value(QDir::cleanPath(filePath)).values();
+    result.sort();
+    return result;
+}
+
+QString ProjectIndex::indexFileName(const QString &projectFileName)
+{
+    const QFileInfo fileInfo(projectFileName);
+
+    QString indexFile = fileInfo.path();
+    indexFile += QLatin1Char('/');
+    indexFile += fileInfo.completeBaseName();
+    indexFile += QLatin1String(".tiled-index");
+
+    return indexFile;
+}
+
+void ProjectIndex::indexUpdated(IndexUpdate *updatePointer)
+{
+    const std::unique_ptr<IndexUpdate> update { updatePointer };
+
+    // Ignore updates for a previous project
+    if (update->generation != mGeneration)
+        return;
+
+    for (const QString &directory : qAsConst(update->removedDirectories)) {
+        if (mWatchedDirectories.remove(directory))
+            mWatcher.removePath(directory);
+    }
+
+    for (const QString &directory : qAsConst(update->directories)) {
+        if (!mWatchedDirectories.contains(directory)) {
+            mWatchedDirectories.insert(directory);
+            mWatcher.addPath(directory);
+        }
+    }
+
+    for (const QString &filePath : qAsConst(update->removed))
+        remove(filePath);
+
+    for (auto it = update->changed.constBegin(); it != update->changed.constEnd(); ++it)
+        insert(it.key(), it.value());
+
+    if (!update->changed.isEmpty() || !update->removed.isEmpty()) {
+        mSaveTimer.start();
+        emit updated();
+    }
+}
+
+void ProjectIndex::pathsChanged(const QStringList &paths)
+{
+    auto request = new IndexRequest;
+    request->generation = mGeneration;
+    request->paths = paths;
+    emit indexRequested(request);
+}
+
+void ProjectIndex::insert(const QString &filePath, const AssetInfo &asset)
+{
+    auto it = mAssets.find(filePath);
+    if (it != mAssets.end()) {
+        for (const QString &reference : qAsConst(it.value().references))
+            mReferencedBy[reference].remove(filePath);
+        it.value() = asset;
+    } else {
+        mAssets.insert(filePath, asset);
+        mFilesByName[QFileInfo(filePath).fileName()].insert(filePath);
+        mWatcher.addPath(filePath);
+    }
+
+    for (const QString &reference : asset.references)
+        mReferencedBy[reference].insert(filePath);
+}
+
+void ProjectIndex::remove(const QString &filePath)
+{
+    auto it = mAssets.find(filePath);
+    if (it == mAssets.end())
+        return;
+
+    for (const QString &reference : qAsConst(it.value().references)) {
+        auto referencedBy = mReferencedBy.find(reference);
+        if (referencedBy != mReferencedBy.end()) {
+            referencedBy.value().remove(filePath);
+            if (referencedBy.value().isEmpty())
+                mReferencedBy.erase(referencedBy);
+        }
+    }
+
+    const QString fileName = QFileInfo(filePath).fileName();
+    auto files = mFilesByName.find(fileName);
+    if (files != mFilesByName.end()) {
+        files.value().remove(filePath);
+        if (files.value().isEmpty())
+            mFilesByName.erase(files);
+    }
+
+    mAssets.erase(it);
+    mWatcher.removePath(filePath);
+}
+
+/**
+ * Loads the stored index. Paths are stored relative to the index file, so
+ * that the index remains valid when the project is moved.
+ */
+void ProjectIndex::load()
+{
+    if (mFileName.isEmpty())
+        return;
+
+    QFile file(mFileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_6);
+
+    quint32 magic, version, count;
+    stream >> magic >> version >> count;
+    if (stream.status() != QDataStream::Ok || magic != IndexMagic || version != IndexVersion)
+        return;
+
+    const QDir dir = QFileInfo(mFileName).dir();
+    AssetHash assets;
+    assets.reserve(static_cast<int>(count));
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString filePath;
+        qint32 type;
+        AssetInfo asset;
+        QStringList references;
+
+        stream >> filePath >> type >> asset.size >> asset.lastModified >> asset.hash >> references;
+
+        asset.type = static_cast<AssetInfo::Type>(type);
+        for (const QString &reference : qAsConst(references))
+            asset.references.append(QDir::cleanPath(dir.absoluteFilePath(reference)));
+
+        assets.insert(QDir::cleanPath(dir.absoluteFilePath(filePath)), asset);
+    }
+
+    // Don't use a partially read index
+    if (stream.status() != QDataStream::Ok)
+        return;
+
+    for (auto it = assets.constBegin(); it != assets.constEnd(); ++it)
+        insert(it.key(), it.value());
+}
+
+void ProjectIndex::save()
+{
+    mSaveTimer.stop();
+
+    // The project may have been saved under a different name
+    if (!mProject.fileName().isEmpty())
+        mFileName = indexFileName(mProject.fileName());
+
+    write();
+}
+
+void ProjectIndex::write()
+{
+    if (mFileName.isEmpty())
+        return;
+
+    SaveFile file(mFileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream stream(file.device());
+    stream.setVersion(QDataStream::Qt_5_6);
+
+    stream << IndexMagic << IndexVersion << static_cast<quint32>(mAssets.size());
+
+    const QDir dir = QFileInfo(mFileName).dir();
+
+    for (auto it = mAssets.constBegin(); it != mAssets.constEnd(); ++it) {
+        const AssetInfo &asset = it.value();
+
+        QStringList references;
+        for (const QString &reference : asset.references)
+            references.append(dir.relativeFilePath(reference));
+
+        stream << dir.relativeFilePath(it.key())
+               << static_cast<qint32>(asset.type)
+               << asset.size
+               << asset.lastModified
+               << asset.hash
+               << references;
+    }
+
+    file.commit();
+}
+
+} // namespace Tiled
+
+#include "projectindex.moc"
@@ -0,0 +1,144 @@
+/*
+ * projectindex.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "filesystemwatcher.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+
+class QFileInfo;
+
+namespace Tiled {
+
+class Project;
+
+/**
+ * Information about a file in a project.
+ */
+struct AssetInfo
+{
+    enum Type {
+        Other,
+        Map,
+        Tileset,
+        Template,
+        Image
+    };
+
+    Type type = Other;
+    qint64 size = 0;
+    qint64 lastModified = 0;    // milliseconds since epoch
+    QByteArray hash;            // SHA-1 hash of the file contents
+    QStringList references;     // absolute paths of the files used by this file
+
+    bool isUpToDate(const QFileInfo &fileInfo) const;
+};
+
+using AssetHash = QHash<QString, AssetInfo>;
+
+struct IndexRequest;
+struct IndexUpdate;
+
+/**
+ * Keeps an index of the maps, tilesets, templates and images in the folders
+ * of a project, including the files each of them refers to.
+ *
+ * The index is stored next to the project file, so that when the project is
+ * opened again only the files that changed since need to be indexed.
+ * Indexing happens on a background thread and the index is kept up to date
+ * when files change on disk.
+ */
+class ProjectIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProjectIndex(const Project &project, QObject *parent = nullptr);
+    ~ProjectIndex() override;
+
+    static ProjectIndex *instance();
+
+    const Project &project() const;
+
+    void reset();
+    void refresh();
+
+    const AssetHash &assets() const;
+    QStringList filesNamed(const QString &fileName) const;
+    QStringList filesReferencing(const QString &filePath) const;
+
+    static QString indexFileName(const QString &projectFileName);
+
+signals:
+    void updated();
+
+    void indexRequested(IndexRequest *request);
+
+private:
+    void indexUpdated(IndexUpdate *update);
+    void pathsChanged(const QStringList &paths);
+
+    void insert(const QString &filePath, const AssetInfo &asset);
+    void remove(const QString &filePath);
+
+    void load();
+    void save();
+    void write();
+
+    const Project &mProject;
+    QString mFileName;
+    AssetHash mAssets;
+    QHash<QString, QSet<QString>> mReferencedBy;
+    QHash<QString, QSet<QString>> mFilesByName;
+    int mGeneration = 0;
+
+    FileSystemWatcher mWatcher;
+    QSet<QString> mWatchedDirectories;
+
+    QThread mIndexingThread;
+    QTimer mSaveTimer;
+
+    static ProjectIndex *mInstance;
+};
+
+
+inline ProjectIndex *ProjectIndex::instance()
+{
+    return mInstance;
+}
+
+inline const Project &ProjectIndex::project() const
+{
+    return mProject;
+}
+
+inline const AssetHash &ProjectIndex::assets() const
+{
+    return mAssets;
+}
+
+} // namespace Tiled
@@ -0,0 +1,763 @@
+/*
+ * projectmapjob.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "projectmapjob.h"
+
+#include "document.h"
+#include "documentmanager.h"
+#include "imagelayer.h"
+#include "map.h"
+#include "mapobject.h"
+#include "mapreader.h"
+#include "mapwriter.h"
+#include "objectgroup.h"
+#include "objecttemplate.h"
+#include "tile.h"
+#include "tilelayer.h"
+#include "tilesetformat.h"
+#include "tilesetmanager.h"
+
+#include <QAtomicInt>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+
+#include "qtcompat_p.h"
+
+#include <map>
+
+namespace Tiled {
+
+/**
+ * The outcome of processing a single map.
+ */
+struct ProjectMapResult
+{
+    QString fileName;
+    bool changed = false;
+    bool saveFailed = false;
+    QVector<ProjectMapFinding> findings;
+};
+
+/**
+ * The external tilesets and templates loaded by the readers of a job.
+ *
+ * These are shared between the threads, but once loaded they are only read.
+ */
+struct ProjectAssets
+{
+    QMutex mutex;
+    QHash<QString, SharedTileset> tilesets;
+    QHash<QString, QString> tilesetErrors;
+    std::map<QString, std::unique_ptr<ObjectTemplate>> templates;
+};
+
+/**
+ * Reads maps on the threads of a ProjectMapJob, loading external tilesets
+ * and templates through the assets shared by the job.
+ *
+ * The tilesets are not shared with the editor, since the editor changes its
+ * tilesets without synchronizing with other threads. For the same reason,
+ * templates are not loaded through the TemplateManager.
+ */
+class ProjectMapReader : public MapReader
+{
+public:
+    explicit ProjectMapReader(ProjectAssets &assets)
+        : mAssets(assets)
+    {}
+
+    SharedTileset tileset(const QString &fileName, QString *error)
+    {
+        return readExternalTileset(fileName, error);
+    }
+
+protected:
+    SharedTileset readExternalTileset(const QString &source,
+                                      QString *error) override;
+    ObjectTemplate *readExternalObjectTemplate(const QString &fileName) override;
+
+private:
+    SharedTileset readTilesetFile(const QString &fileName, QString &error);
+
+    ProjectAssets &mAssets;
+};
+
+SharedTileset ProjectMapReader::readExternalTileset(const QString &source,
+                                                    QString *error)
+{
+    {
+        QMutexLocker locker(&mAssets.mutex);
+        auto it = mAssets.tilesets.constFind(source);
+        if (it != mAssets.tilesets.constEnd()) {
+            if (!it.value() && error)
+                *error = mAssets.tilesetErrors.value(source);
+            return it.value();
+        }
+    }
+
+    // The tileset is read without holding the lock, so that other threads
+    // can continue. When two threads read the same tileset at the same time,
+    // only the first one to finish is kept.
+    QString readError;
+    SharedTileset tileset = readTilesetFile(source, readError);
+
+    QMutexLocker locker(&mAssets.mutex);
+    auto it = mAssets.tilesets.constFind(source);
+    if (it != mAssets.tilesets.constEnd())
+        tileset = it.value();
+    else
+        mAssets.tilesets.insert(source, tileset);
+
+    if (!tileset) {
+        if (!mAssets.tilesetErrors.contains(source))
+            mAssets.tilesetErrors.insert(source, readError);
+        if (error)
+            *error = mAssets.tilesetErrors.value(source);
+    }
+
+    return tileset;
+}
+
+/**
+ * Reads a tileset that was not loaded by the job yet. TSX tilesets are read
+ * by another reader sharing the same assets. Tilesets in other formats are
+ * read by their plugin, one at a time, since the plugins keep their error
+ * in a member and were written to be used from a single thread.
+ */
+SharedTileset ProjectMapReader::readTilesetFile(const QString &fileName,
+                                                QString &error)
+{
+    if (QFileInfo(fileName).suffix().compare(QLatin1String("tsx"), Qt::CaseInsensitive) == 0) {
+        ProjectMapReader reader(mAssets);
+        SharedTileset tileset = reader.readTileset(fileName);
+        if (tileset)
+            tileset->setFileName(fileName);
+        else
+            error = reader.errorString();
+        return tileset;
+    }
+
+    static QMutex mutex;
+    QMutexLocker locker(&mutex);
+    return Tiled::readTileset(fileName, &error);
+}
+
+ObjectTemplate *ProjectMapReader::readExternalObjectTemplate(const QString &fileName)
+{
+    {
+        QMutexLocker locker(&mAssets.mutex);
+        auto it = mAssets.templates.find(fileName);
+        if (it != mAssets.templates.end())
+            return it->second.get();
+    }
+
+    ProjectMapReader reader(mAssets);
+    auto objectTemplate = reader.readObjectTemplate(fileName);
+
+    // Like the TemplateManager, use a template without an object to
+    // represent a broken reference
+    if (!objectTemplate)
+        objectTemplate = std::make_unique<ObjectTemplate>(fileName);
+
+    QMutexLocker locker(&mAssets.mutex);
+    auto &loadedTemplate = mAssets.templates[fileName];
+    if (!loadedTemplate)
+        loadedTemplate = std::move(objectTemplate);
+
+    return loadedTemplate.get();
+}
+
+
+namespace {
+
+/**
+ * Calls \a function for each non-empty cell of the given \a tileLayer, along
+ * with its position in the map.
+ */
+template<typename Function>
+void forEachCell(const TileLayer &tileLayer, Function function)
+{
+    const QRect bounds = tileLayer.localBounds();
+    const QPoint offset = tileLayer.position();
+
+    for (int y = bounds.top(); y <= bounds.bottom(); ++y) {
+        for (int x = bounds.left(); x <= bounds.right(); ++x) {
+            const Cell &cell = tileLayer.cellAt(x, y);
+            if (!cell.isEmpty())
+                function(cell, QPoint(x, y) + offset);
+        }
+    }
+}
+
+void reportProperty(const Object &object,
+                    const QString &name,
+                    const QVariant &value,
+                    const QString &description,
+                    const QString &fileName,
+                    std::function<void()> callback,
+                    QVector<ProjectMapFinding> &findings)
+{
+    if (!object.hasProperty(name))
+        return;
+    if (value.isValid() && object.property(name) != value)
+        return;
+
+    findings.append({ Issue::Warning, fileName, description, std::move(callback) });
+}
+
+class FindTileOperation : public ProjectMapOperation
+{
+public:
+    FindTileOperation(const QString &tilesetFileName, int tileId)
+        : mTilesetFileName(QDir::cleanPath(tilesetFileName))
+        , mTileId(tileId)
+    {}
+
+    bool apply(Map &map, ProjectMapReader &, QVector<ProjectMapFinding> &findings) const override
+    {
+        LayerIterator iterator(&map);
+        while (Layer *layer = iterator.next()) {
+            if (const TileLayer *tileLayer = layer->asTileLayer()) {
+                int count = 0;
+                QPoint firstPos;
+
+                forEachCell(*tileLayer, [&] (const Cell &cell, QPoint pos) {
+                    if (matches(cell) && count++ == 0)
+                        firstPos = pos;
+                });
+
+                if (count > 0) {
+                    findings.append({ Issue::Warning, map.fileName,
+                                      tr("Tile used %n time(s) in layer '%1' of %2", "", count)
+                                      .arg(layer->name(), map.fileName),
+                                      JumpToTile(&map, firstPos, layer) });
+                }
+            } else if (const ObjectGroup *objectGroup = layer->asObjectGroup()) {
+                for (const MapObject *mapObject : objectGroup->objects()) {
+                    if (matches(mapObject->cell())) {
+                        findings.append({ Issue::Warning, map.fileName,
+                                          tr("Tile used by object %1 in layer '%2' of %3")
+                                          .arg(mapObject->id()).arg(layer->name(), map.fileName),
+                                          JumpToObject(mapObject) });
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+private:
+    bool matches(const Cell &cell) const
+    {
+        const Tileset *tileset = cell.tileset();
+        return tileset && tileset->fileName() == mTilesetFileName &&
+                (mTileId == -1 || cell.tileId() == mTileId);
+    }
+
+    const QString mTilesetFileName;
+    const int mTileId;
+};
+
+class FindPropertyOperation : public ProjectMapOperation
+{
+public:
+    FindPropertyOperation(const QString &name, const QVariant &value)
+        : mName(name)
+        , mValue(value)
+    {}
+
+    bool apply(Map &map, ProjectMapReader &, QVector<ProjectMapFinding> &findings) const override
+    {
+        const QString &fileName = map.fileName;
+
+        reportProperty(map, mName, mValue,
+                       tr("Property '%1' used by map %2").arg(mName, fileName),
+                       fileName, OpenFile { fileName }, findings);
+
+        LayerIterator iterator(&map);
+        while (Layer *layer = iterator.next()) {
+            reportProperty(*layer, mName, mValue,
+                           tr("Property '%1' used by layer '%2' of %3").arg(mName, layer->name(), fileName),
+                           fileName, SelectLayer(layer), findings);
+
+            if (const ObjectGroup *objectGroup = layer->asObjectGroup()) {
+                for (const MapObject *mapObject : objectGroup->objects()) {
+                    reportProperty(*mapObject, mName, mValue,
+                                   tr("Property '%1' used by object %2 in layer '%3' of %4")
+                                   .arg(mName).arg(mapObject->id()).arg(layer->name(), fileName),
+                                   fileName, JumpToObject(mapObject), findings);
+                }
+            }
+        }
+
+        return false;
+    }
+
+private:
+    const QString mName;
+    const QVariant mValue;
+};
+
+class ReplaceTilesetOperation : public ProjectMapOperation
+{
+public:
+    ReplaceTilesetOperation(const QString &oldFileName, const QString &newFileName)
+        : mOldFileName(QDir::cleanPath(oldFileName))
+        , mNewFileName(QDir::cleanPath(newFileName))
+    {}
+
+    bool apply(Map &map, ProjectMapReader &reader, QVector<ProjectMapFinding> &findings) const override
+    {
+        if (mOldFileName == mNewFileName)
+            return false;
+
+        SharedTileset oldTileset;
+        for (const SharedTileset &tileset : map.tilesets()) {
+            if (tileset->fileName() == mOldFileName) {
+                oldTileset = tileset;
+                break;
+            }
+        }
+
+        if (!oldTileset)
+            return false;
+
+        QString error;
+        SharedTileset newTileset = reader.tileset(mNewFileName, &error);
+        if (!newTileset) {
+            findings.append({ Issue::Error, map.fileName,
+                              tr("Could not replace tileset in %1: %2").arg(map.fileName, error),
+                              OpenFile { map.fileName } });
+            return false;
+        }
+
+        map.replaceTileset(oldTileset, newTileset);
+
+        findings.append({ Issue::Warning, map.fileName,
+                          tr("Replaced tileset in %1").arg(map.fileName),
+                          OpenFile { map.fileName } });
+        return true;
+    }
+
+    bool changesMaps() const override { return true; }
+
+private:
+    const QString mOldFileName;
+    const QString mNewFileName;
+};
+
+class ValidateOperation : public ProjectMapOperation
+{
+public:
+    bool apply(Map &map, ProjectMapReader &, QVector<ProjectMapFinding> &findings) const override
+    {
+        const QString &fileName = map.fileName;
+
+        auto error = [&] (const QString &text, std::function<void()> callback) {
+            findings.append({ Issue::Error, fileName, text, std::move(callback) });
+        };
+
+        for (const SharedTileset &tileset : map.tilesets()) {
+            if (tileset->status() == LoadingError) {
+                error(tr("Could not load tileset %1 used by %2").arg(tileset->fileName(), fileName),
+                      OpenFile { fileName });
+            } else if (tileset->imageStatus() == LoadingError) {
+                error(tr("Could not load image %1 of tileset '%2' used by %3")
+                      .arg(tileset->imageSource().toString(QUrl::PreferLocalFile), tileset->name(), fileName),
+                      OpenFile { fileName });
+            } else if (tileset->isCollection()) {
+                for (const Tile *tile : tileset->tiles()) {
+                    if (tile->imageStatus() == LoadingError) {
+                        error(tr("Could not load image %1 of tile %2 in tileset '%3' used by %4")
+                              .arg(tile->imageSource().toString(QUrl::PreferLocalFile)).arg(tile->id())
+                              .arg(tileset->name(), fileName),
+                              OpenFile { fileName });
+                    }
+                }
+            }
+        }
+
+        LayerIterator iterator(&map);
+        while (Layer *layer = iterator.next()) {
+            switch (layer->layerType()) {
+            case Layer::TileLayerType: {
+                const TileLayer *tileLayer = static_cast<const TileLayer*>(layer);
+                int count = 0;
+                QPoint firstPos;
+
+                forEachCell(*tileLayer, [&] (const Cell &cell, QPoint pos) {
+                    if (isInvalid(cell) && count++ == 0)
+                        firstPos = pos;
+                });
+
+                if (count > 0) {
+                    error(tr("%n invalid tile(s) in layer '%1' of %2", "", count)
+                          .arg(layer->name(), fileName),
+                          JumpToTile(&map, firstPos, layer));
+                }
+                break;
+            }
+            case Layer::ObjectGroupType:
+                for (const MapObject *mapObject : static_cast<const ObjectGroup*>(layer)->objects()) {
+                    const ObjectTemplate *objectTemplate = mapObject->objectTemplate();
+                    if (objectTemplate && !objectTemplate->object()) {
+                        error(tr("Could not load template %1 of object %2 in %3")
+                              .arg(objectTemplate->fileName()).arg(mapObject->id()).arg(fileName),
+                              JumpToObject(mapObject));
+                    } else if (isInvalid(mapObject->cell())) {
+                        error(tr("Invalid tile used by object %1 in %2")
+                              .arg(mapObject->id()).arg(fileName),
+                              JumpToObject(mapObject));
+                    }
+                }
+                break;
+            case Layer::ImageLayerType: {
+                const ImageLayer *imageLayer = static_cast<const ImageLayer*>(layer);
+                if (!imageLayer->imageSource().isEmpty() && imageLayer->image().isNull()) {
+                    error(tr("Could not load image %1 of layer '%2' in %3")
+                          .arg(imageLayer->imageSource().toString(QUrl::PreferLocalFile), layer->name(), fileName),
+                          SelectLayer(layer));
+                }
+                break;
+            }
+            case Layer::GroupLayerType:
+                break;
+            }
+        }
+
+        return false;
+    }
+
+private:
+    static bool isInvalid(const Cell &cell)
+    {
+        const Tileset *tileset = cell.tileset();
+
+        // Missing tilesets are reported once, rather than for each tile
+        return tileset && tileset->status() != LoadingError &&
+                tileset->imageStatus() != LoadingError && !cell.tile();
+    }
+};
+
+} // anonymous namespace
+
+/**
+ * Finds where the given tile is used. When \a tileId is -1, any tile from
+ * the tileset is found.
+ */
+std::unique_ptr<ProjectMapOperation> ProjectMapOperation::findTile(const QString &tilesetFileName,
+                                                                   int tileId)
+{
+    return std::make_unique<FindTileOperation>(tilesetFileName, tileId);
+}
+
+/**
+ * Finds the map, layers and objects that have the property with the given
+ * \a name. When a valid \a value is given, the property needs to have that
+ * value.
+ */
+std::unique_ptr<ProjectMapOperation> ProjectMapOperation::findProperty(const QString &name,
+                                                                       const QVariant &value)
+{
+    return std::make_unique<FindPropertyOperation>(name, value);
+}
+
+/**
+ * Changes the maps using the tileset \a oldFileName to use the tileset
+ * \a newFileName instead. Tiles are matched by their ID.
+ */
+std::unique_ptr<ProjectMapOperation> ProjectMapOperation::replaceTileset(const QString &oldFileName,
+                                                                         const QString &newFileName)
+{
+    return std::make_unique<ReplaceTilesetOperation>(oldFileName, newFileName);
+}
+
+/**
+ * Checks for references to tilesets, templates and images that could not be
+ * loaded and for tiles that do not exist.
+ */
+std::unique_ptr<ProjectMapOperation> ProjectMapOperation::validate()
+{
+    return std::make_unique<ValidateOperation>();
+}
+
+
+/**
+ * Finds the maps and processes them using a thread pool. Lives on the thread
+ * of the job.
+ */
+class ProjectMapTask : public QObject
+{
+    Q_OBJECT
+
+public:
+    ProjectMapTask(const QStringList &folders,
+                   const QSet<QString> &openFiles,
+                   std::unique_ptr<ProjectMapOperation> operation)
+        : mFolders(folders)
+        , mOpenFiles(openFiles)
+        , mOperation(std::move(operation))
+    {}
+
+    void run();
+
+    void cancel() { mCancelled.storeRelease(1); }
+    bool isCancelled() const { return mCancelled.loadAcquire(); }
+
+    void process(const QString &fileName, ProjectAssets &assets);
+
+signals:
+    void mapsFound(int count);
+    void mapProcessed(ProjectMapResult *result);
+    void finished();
+
+private:
+    QStringList findMaps() const;
+
+    const QStringList mFolders;
+    const QSet<QString> mOpenFiles;
+    const std::unique_ptr<ProjectMapOperation> mOperation;
+    QAtomicInt mCancelled;
+};
+
+namespace {
+
+class ProcessMapTask : public QRunnable
+{
+public:
+    ProcessMapTask(ProjectMapTask &task,
+                   const QString &fileName,
+                   ProjectAssets &assets)
+        : mTask(task)
+        , mFileName(fileName)
+        , mAssets(assets)
+    {}
+
+    void run() override
+    {
+        if (!mTask.isCancelled())
+            mTask.process(mFileName, mAssets);
+    }
+
+private:
+    ProjectMapTask &mTask;
+    const QString mFileName;
+    ProjectAssets &mAssets;
+};
+
+} // anonymous namespace
+
+void ProjectMapTask::run()
+{
+    const QStringList fileNames = findMaps();
+    emit mapsFound(fileNames.size());
+
+    // The assets need to outlive the maps, so the pool is finished first
+    ProjectAssets assets;
+    {
+        QThreadPool threadPool;
+        for (const QString &fileName : fileNames)
+            threadPool.start(new ProcessMapTask(*this, fileName, assets));
+        threadPool.waitForDone();
+    }
+
+    emit finished();
+
+    QThread::currentThread()->quit();
+}
+
+QStringList ProjectMapTask::findMaps() const
+{
+    QSet<QString> fileNames;
+
+    for (const QString &folder : mFolders) {
+        QDirIterator it(folder, QStringList(QStringLiteral("*.tmx")),
+                        QDir::Files | QDir::Readable, QDirIterator::Subdirectories);
+        while (it.hasNext() && !isCancelled())
+            fileNames.insert(QDir::cleanPath(QFileInfo(it.next()).absoluteFilePath()));
+    }
+
+    QStringList sorted = fileNames.values();
+    sorted.sort();
+    return sorted;
+}
+
+/**
+ * Reads, processes and when changed writes the given map. Called from the
+ * threads of the pool.
+ */
+void ProjectMapTask::process(const QString &fileName, ProjectAssets &assets)
+{
+    auto result = std::make_unique<ProjectMapResult>();
+    result->fileName = fileName;
+
+    // Saving a map that is open in the editor would overwrite the document
+    // behind its back, so such maps are left alone
+    if (mOperation->changesMaps() && mOpenFiles.contains(fileName)) {
+        result->findings.append({ Issue::Warning, fileName,
+                                  tr("Skipped %1 since it is open in the editor").arg(fileName),
+                                  OpenFile { fileName } });
+        emit mapProcessed(result.release());
+        return;
+    }
+
+    ProjectMapReader reader(assets);
+    std::unique_ptr<Map> map = reader.readMap(fileName);
+
+    if (!map) {
+        result->findings.append({ Issue::Error, fileName,
+                                  tr("Could not read %1: %2").arg(fileName, reader.errorString()),
+                                  OpenFile { fileName } });
+    } else {
+        map->fileName = fileName;
+
+        if (mOperation->apply(*map, reader, result->findings) && !isCancelled()) {
+            MapWriter writer;
+            if (writer.writeMap(map.get(), fileName)) {
+                result->changed = true;
+            } else {
+                result->saveFailed = true;
+                result->findings.append({ Issue::Error, fileName,
+                                          tr("Could not save %1: %2").arg(fileName, writer.errorString()),
+                                          OpenFile { fileName } });
+            }
+        }
+    }
+
+    emit mapProcessed(result.release());
+}
+
+
+static QSet<QString> openFiles()
+{
+    QSet<QString> fileNames;
+
+    for (const DocumentPtr &document : DocumentManager::instance()->documents()) {
+        const QString fileName = document->fileName();
+        if (!fileName.isEmpty())
+            fileNames.insert(QDir::cleanPath(QFileInfo(fileName).absoluteFilePath()));
+    }
+
+    return fileNames;
+}
+
+/**
+ * Creates a job that applies the \a operation to the TMX maps in the given
+ * \a folders, including their subfolders.
+ *
+ * Needs to be created on the main thread, since it looks up the open
+ * documents.
+ */
+ProjectMapJob::ProjectMapJob(const QStringList &folders,
+                             std::unique_ptr<ProjectMapOperation> operation,
+                             QObject *parent)
+    : QObject(parent)
+    , mTask(new ProjectMapTask(folders, openFiles(), std::move(operation)))
+{
+    // The tilesets created by the readers notify the tileset manager, which
+    // needs to be created on this thread
+    TilesetManager::instance();
+
+    mTask->moveToThread(&mThread);
+
+    connect(&mThread, &QThread::started, mTask.get(), &ProjectMapTask::run);
+    connect(mTask.get(), &ProjectMapTask::mapsFound, this, &ProjectMapJob::mapsFound);
+    connect(mTask.get(), &ProjectMapTask::mapProcessed, this, &ProjectMapJob::mapProcessed);
+    connect(mTask.get(), &ProjectMapTask::finished, this, &ProjectMapJob::taskFinished);
+}
+
+ProjectMapJob::~ProjectMapJob()
+{
+    // The task is deleted after its thread has finished
+    cancel();
+    mThread.quit();
+    mThread.wait();
+
+    if (!mSettled) {
+        mSettled = true;
+        emit cancelled();
+    }
+}
+
+void ProjectMapJob::start()
+{
+    mThread.start();
+}
+
+/**
+ * Requests the job to stop. Maps that are already being processed are still
+ * finished.
+ */
+void ProjectMapJob::cancel()
+{
+    mTask->cancel();
+}
+
+void ProjectMapJob::mapsFound(int count)
+{
+    mTotal = count;
+    INFO(tr("Processing %n map(s)...", "", count));
+    emit progress(mDone, mTotal);
+}
+
+void ProjectMapJob::mapProcessed(ProjectMapResult *result)
+{
+    std::unique_ptr<ProjectMapResult> mapResult(result);
+
+    for (const ProjectMapFinding &finding : qAsConst(mapResult->findings)) {
+        REPORT(Issue { finding.severity, finding.text, finding.callback });
+        mFindings.append(finding);
+    }
+
+    if (mapResult->changed)
+        mChangedFiles.append(mapResult->fileName);
+    if (mapResult->saveFailed)
+        ++mSaveErrors;
+
+    ++mDone;
+    emit progress(mDone, mTotal);
+}
+
+void ProjectMapJob::taskFinished()
+{
+    INFO(tr("Processed %1 of %n map(s), %2 changed, %3 finding(s)", "", mTotal)
+         .arg(mDone).arg(mChangedFiles.size()).arg(mFindings.size()));
+
+    mSettled = true;
+
+    if (mTask->isCancelled())
+        emit cancelled();
+    else if (mSaveErrors > 0)
+        emit failed(tr("Could not save %n map(s)", "", mSaveErrors));
+    else
+        emit finished();
+}
+
+} // namespace Tiled
+
+#include "projectmapjob.moc"
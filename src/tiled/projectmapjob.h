@@ -0,0 +1,146 @@
+/*
+ * projectmapjob.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "logginginterface.h"
+
+#include <QCoreApplication>
+#include <QObject>
+#include <QStringList>
+#include <QThread>
+#include <QVariant>
+#include <QVector>
+
+#include <functional>
+#include <memory>
+
+namespace Tiled {
+
+class Map;
+class ProjectMapReader;
+class ProjectMapTask;
+
+/**
+ * Something found while processing the maps of a project.
+ */
+struct ProjectMapFinding
+{
+    Issue::Severity severity;
+    QString fileName;
+    QString text;
+    std::function<void()> callback;
+};
+
+struct ProjectMapResult;
+
+/**
+ * An operation that ProjectMapJob applies to each map of a project.
+ *
+ * Since the maps are processed in parallel, apply() is called from several
+ * threads at the same time. It should only change the map it is given.
+ */
+class ProjectMapOperation
+{
+    Q_DECLARE_TR_FUNCTIONS(ProjectMapOperation)
+
+public:
+    virtual ~ProjectMapOperation() = default;
+
+    /**
+     * Applies the operation to the given \a map, adding anything worth
+     * reporting to \a findings. The \a reader can be used to load further
+     * tilesets.
+     *
+     * Returns whether the map was changed, in which case it is saved.
+     */
+    virtual bool apply(Map &map,
+                       ProjectMapReader &reader,
+                       QVector<ProjectMapFinding> &findings) const = 0;
+
+    /**
+     * Returns whether this operation may change the maps. Such operations
+     * skip the maps that are open in the editor, since saving them would
+     * overwrite the open document.
+     */
+    virtual bool changesMaps() const { return false; }
+
+    static std::unique_ptr<ProjectMapOperation> findTile(const QString &tilesetFileName,
+                                                         int tileId = -1);
+    static std::unique_ptr<ProjectMapOperation> findProperty(const QString &name,
+                                                             const QVariant &value = QVariant());
+    static std::unique_ptr<ProjectMapOperation> replaceTileset(const QString &oldFileName,
+                                                               const QString &newFileName);
+    static std::unique_ptr<ProjectMapOperation> validate();
+};
+
+/**
+ * Applies an operation to all TMX maps in the given folders.
+ *
+ * The maps are read, processed and, when changed, saved on a pool of
+ * threads. External tilesets and templates are loaded once for the whole
+ * job, separately from the ones used by the editor. Tilesets in formats other
+ * than TSX are read by their plugin, one at a time. Maps that are open in
+ * the editor are read from disk, so any unsaved changes are not seen. When
+ * the operation changes maps, the open maps are skipped and reported
+ * instead.
+ *
+ * The findings are reported to the Issues view as they come in. When done,
+ * either finished(), failed() or cancelled() is emitted.
+ */
+class ProjectMapJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    ProjectMapJob(const QStringList &folders,
+                  std::unique_ptr<ProjectMapOperation> operation,
+                  QObject *parent = nullptr);
+    ~ProjectMapJob() override;
+
+    void start();
+    void cancel();
+
+    const QVector<ProjectMapFinding> &findings() const { return mFindings; }
+    const QStringList &changedFiles() const { return mChangedFiles; }
+
+signals:
+    void progress(int done, int total);
+    void finished();
+    void failed(const QString &error);
+    void cancelled();
+
+private:
+    void mapsFound(int count);
+    void mapProcessed(ProjectMapResult *result);
+    void taskFinished();
+
+    QThread mThread;
+    std::unique_ptr<ProjectMapTask> mTask;
+
+    bool mSettled = false;
+    int mTotal = 0;
+    int mDone = 0;
+    int mSaveErrors = 0;
+    QVector<ProjectMapFinding> mFindings;
+    QStringList mChangedFiles;
+};
+
+} // namespace Tiled
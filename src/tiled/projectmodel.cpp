@@ -53,6 +53,7 @@ private:
 
 ProjectModel::ProjectModel(QObject *parent)
     : QAbstractItemModel(parent)
+    , mAssetIndex(mProject)
 {
     FolderScanner *scanner = new FolderScanner;
     scanner->moveToThread(&mScanningThread);
@@ -98,6 +99,8 @@ void ProjectModel::setProject(Project project)
     }
 
     endResetModel();
+
+    mAssetIndex.reset();
 }
 
 void ProjectModel::addFolder(const QString &folder)
@@ -111,6 +114,8 @@ void ProjectModel::addFolder(const QString &folder)
     scheduleFolderScan(folder);
 
     endInsertRows();
+
+    mAssetIndex.refresh();
 }
 
 void ProjectModel::removeFolder(int row)
@@ -119,12 +124,16 @@ void ProjectModel::removeFolder(int row)
     mProject.removeFolder(row);
     mFolders.erase(mFolders.begin() + row);
     endRemoveRows();
+
+    mAssetIndex.refresh();
 }
 
 void ProjectModel::refreshFolders()
 {
     for (const auto &folder : mFolders)
         scheduleFolderScan(folder->filePath);
+
+    mAssetIndex.refresh();
 }
 
 QString ProjectModel::filePath(const QModelIndex &index) const
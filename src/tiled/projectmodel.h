@@ -21,6 +21,7 @@
 #pragma once
 
 #include "project.h"
+#include "projectindex.h"
 
 #include <QAbstractListModel>
 #include <QFileIconProvider>
@@ -56,6 +57,7 @@ public:
 
     void setProject(Project project);
     Project &project();
+    ProjectIndex &assetIndex();
 
     void addFolder(const QString &folder);
     void removeFolder(int row);
@@ -90,6 +92,7 @@ private:
     void folderScanned(FolderEntry *entry);
 
     Project mProject;
+    ProjectIndex mAssetIndex;
     QFileIconProvider mFileIconProvider;
     QStringList mNameFilters;
     QTimer mUpdateNameFiltersTimer;
@@ -107,4 +110,9 @@ inline Project &ProjectModel::project()
     return mProject;
 }
 
+inline ProjectIndex &ProjectModel::assetIndex()
+{
+    return mAssetIndex;
+}
+
 } // namespace Tiled
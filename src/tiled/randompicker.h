@@ -21,7 +21,9 @@
 #pragma once
 
 #include <QMap>
+#include <QVector>
 
+#include <algorithm>
 #include <random>
 
 namespace Tiled {
@@ -96,4 +98,27 @@ private:
     QMap<Real, T> mThresholds;
 };
 
+/**
+ * Picks a random index from a table of cumulative probabilities, where each
+ * entry is the sum of its own probability and those of all previous entries.
+ * Returns -1 when the table is empty or all probabilities are zero.
+ *
+ * Unlike RandomPicker, this allows a table to be reused for many picks.
+ */
+template<typename Real>
+int pickCumulative(const QVector<Real> &cumulativeProbabilities)
+{
+    if (cumulativeProbabilities.isEmpty() || !(cumulativeProbabilities.last() > 0))
+        return -1;
+
+    std::uniform_real_distribution<Real> dis(0, cumulativeProbabilities.last());
+    const Real random = dis(globalRandomEngine());
+    auto it = std::upper_bound(cumulativeProbabilities.begin(),
+                               cumulativeProbabilities.end(),
+                               random);
+    if (it == cumulativeProbabilities.end())
+        --it;
+    return static_cast<int>(it - cumulativeProbabilities.begin());
+}
+
 } // namespace Tiled
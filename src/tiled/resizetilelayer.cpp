@@ -44,28 +44,45 @@ ResizeTileLayer::ResizeTileLayer(MapDocument *mapDocument,
     // Create the resized layer (once)
     mResizedLayer = layer->clone();
     mResizedLayer->resize(size, offset);
+    mDetachedLayer.reset(mResizedLayer);
 }
 
 ResizeTileLayer::~ResizeTileLayer()
 {
-    if (mDone)
-        delete mOriginalLayer;
-    else
-        delete mResizedLayer;
 }
 
 void ResizeTileLayer::undo()
 {
     Q_ASSERT(mDone);
+    TileLayer *originalLayer = mDetachedLayer.release();
+    if (!originalLayer) {
+        // The cells could not be restored, drop this command
+#if QT_VERSION >= 0x050900
+        setObsolete(true);
+#endif
+        return;
+    }
+
     LayerModel *layerModel = mMapDocument->layerModel();
-    layerModel->replaceLayer(mResizedLayer, mOriginalLayer);
+    layerModel->replaceLayer(mResizedLayer, originalLayer);
+    mDetachedLayer.reset(mResizedLayer);
     mDone = false;
 }
 
 void ResizeTileLayer::redo()
 {
     Q_ASSERT(!mDone);
+    TileLayer *resizedLayer = mDetachedLayer.release();
+    if (!resizedLayer) {
+        // The cells could not be restored, drop this command
+#if QT_VERSION >= 0x050900
+        setObsolete(true);
+#endif
+        return;
+    }
+
     LayerModel *layerModel = mMapDocument->layerModel();
-    layerModel->replaceLayer(mOriginalLayer, mResizedLayer);
+    layerModel->replaceLayer(mOriginalLayer, resizedLayer);
+    mDetachedLayer.reset(mOriginalLayer);
     mDone = true;
 }
@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include "undotilelayer.h"
+
 #include <QPoint>
 #include <QSize>
 #include <QUndoCommand>
@@ -57,6 +59,7 @@ private:
     bool mDone;
     TileLayer *mOriginalLayer;
     TileLayer *mResizedLayer;
+    UndoTileLayer mDetachedLayer;   // Owns the layer not currently in the map
 };
 
 } // namespace Tiled
@@ -23,16 +23,20 @@
 #include "actionmanager.h"
 #include "commanddatamodel.h"
 #include "commandmanager.h"
+#include "editablemap.h"
 #include "editabletileset.h"
 #include "issuesmodel.h"
 #include "logginginterface.h"
 #include "mainwindow.h"
 #include "mapeditor.h"
+#include "projectindex.h"
+#include "projectmapjob.h"
 #include "scriptedaction.h"
 #include "scriptedfileformat.h"
 #include "scriptedtool.h"
 #include "scriptfileformatwrappers.h"
 #include "scriptmanager.h"
+#include "scriptworker.h"
 #include "tilesetdocument.h"
 #include "tileseteditor.h"
 
@@ -451,6 +455,154 @@ void ScriptModule::extendMenu(const QByteArray &idName, QJSValue items)
     mMenuExtensions.append(extension);
 }
 
+QJSValue ScriptModule::startWorker(const QString &fileName,
+                                   EditableMap *map,
+                                   QJSValue progressCallback)
+{
+#if QT_VERSION < QT_VERSION_CHECK(5, 12, 0)
+    Q_UNUSED(fileName)
+    Q_UNUSED(map)
+    Q_UNUSED(progressCallback)
+    ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Workers require Qt 5.12 or later"));
+    return QJSValue();
+#else
+    if (!map) {
+        ScriptManager::instance().throwNullArgError(1);
+        return QJSValue();
+    }
+
+    QJSEngine *engine = ScriptManager::instance().engine();
+
+    // Create a promise along with the functions to settle it
+    QJSValue deferred = engine->evaluate(QStringLiteral(
+            "(function() {"
+            "    var deferred = {};"
+            "    deferred.promise = new Promise(function(resolve, reject) {"
+            "        deferred.resolve = resolve;"
+            "        deferred.reject = reject;"
+            "    });"
+            "    return deferred;"
+            "})()"));
+
+    auto worker = new ScriptWorker(fileName, *map->map(), this);
+
+    connect(worker, &ScriptWorker::progress, this, [=] (const QVariant &value) {
+        if (progressCallback.isCallable()) {
+            QJSValue result = progressCallback.call({ engine->toScriptValue(value) });
+            ScriptManager::instance().checkError(result);
+        }
+    });
+    connect(worker, &ScriptWorker::finished, this, [=] (const QVariant &result) {
+        deferred.property(QStringLiteral("resolve")).call({ engine->toScriptValue(result) });
+        worker->deleteLater();
+    });
+    connect(worker, &ScriptWorker::failed, this, [=] (const QString &error) {
+        deferred.property(QStringLiteral("reject")).call({ engine->newErrorObject(QJSValue::GenericError, error) });
+        worker->deleteLater();
+    });
+
+    worker->start();
+
+    return deferred.property(QStringLiteral("promise"));
+#endif
+}
+
+QJSValue ScriptModule::startMapOperation(const QString &operation,
+                                         const QVariantMap &options,
+                                         QJSValue progressCallback)
+{
+#if QT_VERSION < QT_VERSION_CHECK(5, 12, 0)
+    Q_UNUSED(operation)
+    Q_UNUSED(options)
+    Q_UNUSED(progressCallback)
+    ScriptManager::instance().throwError(QCoreApplication::translate("Script Errors", "Map operations require Qt 5.12 or later"));
+    return QJSValue();
+#else
+    QJSEngine *engine = ScriptManager::instance().engine();
+
+    // Create a promise along with the functions to settle it
+    QJSValue deferred = engine->evaluate(QStringLiteral(
+            "(function() {"
+            "    var deferred = {};"
+            "    deferred.promise = new Promise(function(resolve, reject) {"
+            "        deferred.resolve = resolve;"
+            "        deferred.reject = reject;"
+            "    });"
+            "    return deferred;"
+            "})()"));
+
+    auto reject = [=] (const QString &error) {
+        deferred.property(QStringLiteral("reject")).call({ engine->newErrorObject(QJSValue::GenericError, error) });
+    };
+
+    std::unique_ptr<ProjectMapOperation> mapOperation;
+
+    if (operation == QLatin1String("findTile")) {
+        mapOperation = ProjectMapOperation::findTile(options.value(QStringLiteral("tileset")).toString(),
+                                                     options.value(QStringLiteral("tileId"), -1).toInt());
+    } else if (operation == QLatin1String("findProperty")) {
+        mapOperation = ProjectMapOperation::findProperty(options.value(QStringLiteral("name")).toString(),
+                                                         options.value(QStringLiteral("value")));
+    } else if (operation == QLatin1String("replaceTileset")) {
+        mapOperation = ProjectMapOperation::replaceTileset(options.value(QStringLiteral("from")).toString(),
+                                                           options.value(QStringLiteral("to")).toString());
+    } else if (operation == QLatin1String("validate")) {
+        mapOperation = ProjectMapOperation::validate();
+    } else {
+        reject(QCoreApplication::translate("Script Errors", "Unknown map operation"));
+        return deferred.property(QStringLiteral("promise"));
+    }
+
+    QStringList folders = options.value(QStringLiteral("folders")).toStringList();
+    if (folders.isEmpty() && ProjectIndex::instance())
+        folders = ProjectIndex::instance()->project().folders();
+
+    if (folders.isEmpty()) {
+        reject(QCoreApplication::translate("Script Errors", "No folders to search for maps"));
+        return deferred.property(QStringLiteral("promise"));
+    }
+
+    auto job = new ProjectMapJob(folders, std::move(mapOperation), this);
+
+    connect(job, &ProjectMapJob::progress, this, [=] (int done, int total) {
+        if (progressCallback.isCallable()) {
+            QJSValue result = progressCallback.call({ done, total });
+            ScriptManager::instance().checkError(result);
+        }
+    });
+    connect(job, &ProjectMapJob::finished, this, [=] {
+        QJSValue findings = engine->newArray(static_cast<uint>(job->findings().size()));
+        for (int i = 0; i < job->findings().size(); ++i) {
+            const ProjectMapFinding &finding = job->findings().at(i);
+            QJSValue value = engine->newObject();
+            value.setProperty(QStringLiteral("fileName"), finding.fileName);
+            value.setProperty(QStringLiteral("text"), finding.text);
+            value.setProperty(QStringLiteral("error"), finding.severity == Issue::Error);
+            findings.setProperty(static_cast<quint32>(i), value);
+        }
+
+        QJSValue result = engine->newObject();
+        result.setProperty(QStringLiteral("findings"), findings);
+        result.setProperty(QStringLiteral("changedFiles"), engine->toScriptValue(job->changedFiles()));
+
+        deferred.property(QStringLiteral("resolve")).call({ result });
+        job->deleteLater();
+    });
+    connect(job, &ProjectMapJob::failed, this, [=] (const QString &error) {
+        reject(error);
+        job->deleteLater();
+    });
+    connect(job, &ProjectMapJob::cancelled, this, [=] {
+        reject(QCoreApplication::translate("Script Errors", "Map operation was cancelled"));
+        job->deleteLater();
+    });
+
+    job->start();
+
+    return deferred.property(QStringLiteral("promise"));
+#endif
+}
+
 void ScriptModule::trigger(const QByteArray &actionName) const
 {
     if (QAction *action = ActionManager::findAction(actionName))
@@ -36,6 +36,7 @@ class QAction;
 namespace Tiled {
 
 class EditableAsset;
+class EditableMap;
 class MapEditor;
 class ScriptedAction;
 class ScriptedMapFormat;
@@ -118,6 +119,13 @@ public:
 
     Q_INVOKABLE void extendMenu(const QByteArray &idName, QJSValue items);
 
+    Q_INVOKABLE QJSValue startWorker(const QString &fileName,
+                                     Tiled::EditableMap *map,
+                                     QJSValue progressCallback = QJSValue());
+    Q_INVOKABLE QJSValue startMapOperation(const QString &operation,
+                                           const QVariantMap &options = QVariantMap(),
+                                           QJSValue progressCallback = QJSValue());
+
 signals:
     void assetCreated(Tiled::EditableAsset *asset);
     void assetOpened(Tiled::EditableAsset *asset);
@@ -0,0 +1,225 @@
+/*
+ * scriptworker.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scriptworker.h"
+
+#include "map.h"
+#include "maptovariantconverter.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QJSEngine>
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace Tiled {
+
+/**
+ * The object passed to the "run" function of a worker script.
+ */
+class ScriptWorkerContext : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(bool cancelled READ isCancelled)
+
+public:
+    explicit ScriptWorkerContext(QObject *parent)
+        : QObject(parent)
+    {}
+
+    bool isCancelled() const
+    { return QThread::currentThread()->isInterruptionRequested(); }
+
+    Q_INVOKABLE void progress(const QJSValue &value)
+    { emit progressed(value.toVariant()); }
+
+signals:
+    void progressed(const QVariant &value);
+};
+
+/**
+ * Evaluates the worker script. Lives on the thread of the worker.
+ */
+class ScriptWorkerTask : public QObject
+{
+    Q_OBJECT
+
+public:
+    ScriptWorkerTask(const QString &fileName, const QVariant &map)
+        : mFileName(fileName)
+        , mMap(map)
+    {}
+
+    void run();
+    void interrupt();
+
+signals:
+    void progress(const QVariant &value);
+    void finished(const QVariant &result);
+    void failed(const QString &error);
+
+private:
+    QString errorMessage(const QJSValue &error) const;
+
+    const QString mFileName;
+    const QVariant mMap;
+
+    QMutex mEngineMutex;
+    QJSEngine *mEngine = nullptr;
+};
+
+void ScriptWorkerTask::run()
+{
+    QFile file(mFileName);
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        emit failed(QCoreApplication::translate("Script Errors", "Error opening file: %1").arg(mFileName));
+        QThread::currentThread()->quit();
+        return;
+    }
+
+    const QString program = QString::fromUtf8(file.readAll());
+    file.close();
+
+    QJSEngine engine;
+    engine.installExtensions(QJSEngine::ConsoleExtension);
+
+    {
+        QMutexLocker locker(&mEngineMutex);
+        mEngine = &engine;
+    }
+
+    auto context = new ScriptWorkerContext(this);
+    connect(context, &ScriptWorkerContext::progressed, this, &ScriptWorkerTask::progress);
+
+    QJSValue result = engine.evaluate(program, mFileName);
+    QString error;
+
+    if (result.isError()) {
+        error = errorMessage(result);
+    } else {
+        QJSValue run = engine.globalObject().property(QStringLiteral("run"));
+        if (run.isCallable()) {
+            result = run.call({ engine.toScriptValue(mMap),
+                                engine.newQObject(context) });
+            if (result.isError())
+                error = errorMessage(result);
+        } else {
+            error = QCoreApplication::translate("Script Errors", "Worker script does not define a 'run' function");
+        }
+    }
+
+    {
+        QMutexLocker locker(&mEngineMutex);
+        mEngine = nullptr;
+    }
+
+    if (error.isEmpty())
+        emit finished(result.toVariant());
+    else
+        emit failed(error);
+
+    delete context;
+    QThread::currentThread()->quit();
+}
+
+/**
+ * Interrupts the script when it is running. Can be called from any thread.
+ */
+void ScriptWorkerTask::interrupt()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    QMutexLocker locker(&mEngineMutex);
+    if (mEngine)
+        mEngine->setInterrupted(true);
+#endif
+}
+
+QString ScriptWorkerTask::errorMessage(const QJSValue &error) const
+{
+    const int lineNumber = error.property(QStringLiteral("lineNumber")).toInt();
+    if (lineNumber > 0) {
+        return QCoreApplication::translate("Script Errors", "At line %1: %2")
+                .arg(lineNumber)
+                .arg(error.toString());
+    }
+    return error.toString();
+}
+
+
+/**
+ * Returns a snapshot of \a map in the JSON map format, with the tile layer
+ * data stored as arrays of global tile IDs.
+ */
+static QVariant mapSnapshot(const Map &map)
+{
+    const auto copy = map.clone();
+    copy->setLayerDataFormat(Map::CSV);
+
+    const QDir mapDir = QFileInfo(map.fileName).dir();
+    return MapToVariantConverter().toVariant(*copy, mapDir);
+}
+
+/**
+ * Creates a worker that will run the script at \a fileName on a snapshot
+ * of the given \a map.
+ */
+ScriptWorker::ScriptWorker(const QString &fileName,
+                           const Map &map,
+                           QObject *parent)
+    : QObject(parent)
+    , mTask(new ScriptWorkerTask(fileName, mapSnapshot(map)))
+{
+    mTask->moveToThread(&mThread);
+
+    connect(&mThread, &QThread::started, mTask.get(), &ScriptWorkerTask::run);
+    connect(mTask.get(), &ScriptWorkerTask::progress, this, &ScriptWorker::progress);
+    connect(mTask.get(), &ScriptWorkerTask::finished, this, &ScriptWorker::finished);
+    connect(mTask.get(), &ScriptWorkerTask::failed, this, &ScriptWorker::failed);
+}
+
+ScriptWorker::~ScriptWorker()
+{
+    // The task is deleted after its thread has finished
+    cancel();
+    mThread.quit();
+    mThread.wait();
+}
+
+void ScriptWorker::start()
+{
+    mThread.start();
+}
+
+/**
+ * Requests the script to stop. With Qt 5.14 or later, the script is
+ * interrupted. Otherwise, the script needs to check the "cancelled"
+ * property of the worker object.
+ */
+void ScriptWorker::cancel()
+{
+    mThread.requestInterruption();
+    mTask->interrupt();
+}
+
+} // namespace Tiled
+
+#include "scriptworker.moc"
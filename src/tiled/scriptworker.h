@@ -0,0 +1,71 @@
+/*
+ * scriptworker.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QThread>
+#include <QVariant>
+
+#include <memory>
+
+namespace Tiled {
+
+class Map;
+class ScriptWorkerTask;
+
+/**
+ * Runs a script file in a separate JavaScript engine on a background thread.
+ *
+ * The script is evaluated in a fresh engine, which has no access to the
+ * Tiled API or to the state of the editor. It is expected to define a global
+ * "run" function, which is called with a snapshot of the map in the JSON
+ * map format and a "worker" object that can be used to report progress.
+ * The value returned by this function is reported as the result.
+ *
+ * Since the snapshot is taken when the worker is created, later changes to
+ * the map do not affect the running script. Taking the snapshot is done on
+ * the calling thread, because tilesets may not be safely read from other
+ * threads.
+ */
+class ScriptWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    ScriptWorker(const QString &fileName,
+                 const Map &map,
+                 QObject *parent = nullptr);
+    ~ScriptWorker() override;
+
+    void start();
+    void cancel();
+
+signals:
+    void progress(const QVariant &value);
+    void finished(const QVariant &result);
+    void failed(const QString &error);
+
+private:
+    QThread mThread;
+    std::unique_ptr<ScriptWorkerTask> mTask;
+};
+
+} // namespace Tiled
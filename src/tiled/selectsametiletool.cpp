@@ -45,8 +45,8 @@ void SelectSameTileTool::tilePositionChanged(QPoint tilePos)
 
     QRegion resultRegion;
     if (mapDocument()->map()->infinite() || tileLayer->contains(tilePos)) {
-        const Cell &matchCell = tileLayer->cellAt(tilePos);
-        resultRegion = tileLayer->region([&] (const Cell &cell) { return cell == matchCell; });
+        const Cell matchCell = tileLayer->cellAt(tilePos);
+        resultRegion = tileLayer->regionOf(matchCell);
     }
     setSelectedRegion(resultRegion);
     brushItem()->setTileRegion(selectedRegion());
@@ -39,8 +39,6 @@
 
 #include <QVector>
 
-#include <climits>
-
 using namespace Tiled;
 
 TerrainBrush::TerrainBrush(QObject *parent)
@@ -252,38 +250,12 @@ static Tile *findBestTile(const Tileset &tileset, unsigned terrain, unsigned con
     // we should have hooked 0xFFFFFFFF terrains outside this function
     Q_ASSERT(terrain != 0xFFFFFFFF);
 
-    RandomPicker<Tile*> matches;
-    int penalty = INT_MAX;
-
-    // TODO: this is a slow linear search, perhaps we could use a better find algorithm...
-    for (Tile *t : tileset.tiles()) {
-        if ((t->terrain() & considerationMask) != (terrain & considerationMask))
-            continue;
-
-        // calculate the tile transition penalty based on shortest distance to target terrain type
-        int tr = tileset.terrainTransitionPenalty(t->terrain() >> 24, terrain >> 24);
-        int tl = tileset.terrainTransitionPenalty((t->terrain() >> 16) & 0xFF, (terrain >> 16) & 0xFF);
-        int br = tileset.terrainTransitionPenalty((t->terrain() >> 8) & 0xFF, (terrain >> 8) & 0xFF);
-        int bl = tileset.terrainTransitionPenalty(t->terrain() & 0xFF, terrain & 0xFF);
-
-        // if there is no path to the destination terrain, this isn't a useful transition
-        if (tr < 0 || tl < 0 || br < 0 || bl < 0)
-            continue;
-
-        // add tile to the candidate list
-        int transitionPenalty = tr + tl + br + bl;
-        if (transitionPenalty <= penalty) {
-            if (transitionPenalty < penalty)
-                matches.clear();
-            penalty = transitionPenalty;
-
-            matches.add(t, t->probability());
-        }
-    }
+    const auto &matches = tileset.findBestTerrainTiles(terrain, considerationMask);
 
     // choose a candidate at random, with consideration for probability
-    if (!matches.isEmpty())
-        return matches.pick();
+    const int index = pickCumulative(matches.cumulativeProbabilities);
+    if (index != -1)
+        return matches.tiles.at(index);
 
     // TODO: conveniently, the null tile doesn't currently work, but when it does, we need to signal a failure to find any matches some other way
     return nullptr;
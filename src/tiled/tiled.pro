@@ -58,8 +58,10 @@ SOURCES += aboutdialog.cpp \
     adjusttileindexes.cpp \
     automapper.cpp \
     automapperwrapper.cpp \
+    automappingconditions.cpp \
     automappingmanager.cpp \
     automappingutils.cpp  \
+    batchexporter.cpp \
     brokenlinks.cpp \
     brushitem.cpp \
     bucketfilltool.cpp \
@@ -84,6 +86,8 @@ SOURCES += aboutdialog.cpp \
     changewangcolordata.cpp \
     changewangsetdata.cpp \
     clickablelabel.cpp \
+    exportasimagejob.cpp \
+    floodfill.cpp \
     issuescounter.cpp \
     issuesdock.cpp \
     issuesmodel.cpp \
@@ -190,6 +194,8 @@ SOURCES += aboutdialog.cpp \
     preferences.cpp \
     project.cpp \
     projectdock.cpp \
+    projectindex.cpp \
+    projectmapjob.cpp \
     projectmodel.cpp \
     preferencesdialog.cpp \
     propertiesdock.cpp \
@@ -214,6 +220,7 @@ SOURCES += aboutdialog.cpp \
     scriptfileformatwrappers.cpp \
     scriptmanager.cpp \
     scriptmodule.cpp \
+    scriptworker.cpp \
     selectionrectangle.cpp \
     selectsametiletool.cpp \
     session.cpp \
@@ -257,9 +264,11 @@ SOURCES += aboutdialog.cpp \
     tilestampsdock.cpp \
     tmxmapformat.cpp \
     toolmanager.cpp \
+    transformmapobjects.cpp \
     treeviewcombobox.cpp \
     undocommands.cpp \
     undodock.cpp \
+    undotilelayer.cpp \
     utils.cpp \
     varianteditorfactory.cpp \
     variantpropertymanager.cpp \
@@ -294,8 +303,10 @@ HEADERS += aboutdialog.h \
     adjusttileindexes.h \
     automapper.h \
     automapperwrapper.h \
+    automappingconditions.h \
     automappingmanager.h \
     automappingutils.h \
+    batchexporter.h \
     brokenlinks.h \
     brushitem.h \
     bucketfilltool.h \
@@ -321,6 +332,8 @@ HEADERS += aboutdialog.h \
     changewangcolordata.h \
     changewangsetdata.h \
     clickablelabel.h \
+    exportasimagejob.h \
+    floodfill.h \
     issuescounter.h \
     issuesdock.h \
     issuesmodel.h \
@@ -428,6 +441,8 @@ HEADERS += aboutdialog.h \
     preferencesdialog.h \
     project.h \
     projectdock.h \
+    projectindex.h \
+    projectmapjob.h \
     projectmodel.h \
     propertiesdock.h \
     propertybrowser.h \
@@ -454,6 +469,7 @@ HEADERS += aboutdialog.h \
     scriptfileformatwrappers.h \
     scriptmanager.h \
     scriptmodule.h \
+    scriptworker.h \
     selectionrectangle.h \
     selectsametiletool.h \
     session.h \
@@ -497,9 +513,11 @@ HEADERS += aboutdialog.h \
     tilestampsdock.h \
     tmxmapformat.h \
     toolmanager.h \
+    transformmapobjects.h \
     treeviewcombobox.h \
     undocommands.h \
     undodock.h \
+    undotilelayer.h \
     utils.h \
     varianteditorfactory.h \
     variantpropertymanager.h \
@@ -40,14 +40,7 @@ using namespace Tiled;
 TiledApplication::TiledApplication(int &argc, char **argv)
     : QtSingleApplication(argc, argv)
 {
-    setOrganizationDomain(QLatin1String("mapeditor.org"));
-#if defined(Q_OS_MAC) || defined(Q_OS_WIN)
-    setApplicationName(QLatin1String("Tiled"));
-#else
-    setApplicationName(QLatin1String("tiled"));
-#endif
-    setApplicationDisplayName(QLatin1String("Tiled"));
-    setApplicationVersion(QLatin1String(AS_STRING(TILED_VERSION)));
+    initializeApplicationInfo();
 
     LanguageManager::instance()->installTranslators();
 
@@ -56,6 +49,28 @@ TiledApplication::TiledApplication(int &argc, char **argv)
 }
 
 TiledApplication::~TiledApplication()
+{
+    deleteSingletons();
+}
+
+/**
+ * Sets the application name, version and organization. This is also used
+ * when running without a TiledApplication instance, so that settings are
+ * shared with the editor.
+ */
+void TiledApplication::initializeApplicationInfo()
+{
+    QCoreApplication::setOrganizationDomain(QLatin1String("mapeditor.org"));
+#if defined(Q_OS_MAC) || defined(Q_OS_WIN)
+    QCoreApplication::setApplicationName(QLatin1String("Tiled"));
+#else
+    QCoreApplication::setApplicationName(QLatin1String("tiled"));
+#endif
+    QGuiApplication::setApplicationDisplayName(QLatin1String("Tiled"));
+    QCoreApplication::setApplicationVersion(QLatin1String(AS_STRING(TILED_VERSION)));
+}
+
+void TiledApplication::deleteSingletons()
 {
     DocumentManager::deleteInstance();
     TemplateManager::deleteInstance();
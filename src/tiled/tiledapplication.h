@@ -32,6 +32,9 @@ public:
     TiledApplication(int &argc, char **argv);
     ~TiledApplication() override;
 
+    static void initializeApplicationInfo();
+    static void deleteSingletons();
+
 protected:
     bool event(QEvent *) override;
 
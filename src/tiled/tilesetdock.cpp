@@ -274,6 +274,8 @@ TilesetDock::TilesetDock(QWidget *parent)
 
     connect(TilesetManager::instance(), &TilesetManager::tilesetImagesChanged,
             this, &TilesetDock::tilesetChanged);
+    connect(TilesetManager::instance(), &TilesetManager::tileImagesChanged,
+            this, &TilesetDock::tileImagesChanged);
 
     connect(mTilesetDocumentsFilterModel, &TilesetDocumentsModel::rowsInserted,
             this, &TilesetDock::onTilesetRowsInserted);
@@ -356,7 +358,7 @@ void TilesetDock::selectTilesInStamp(const TileStamp &stamp)
 
     for (const TileStampVariation &variation : stamp.variations())
         for (auto layer : variation.map->tileLayers())
-            for (const Cell &cell : *static_cast<TileLayer*>(layer))
+            for (const Cell &cell : *static_cast<const TileLayer*>(layer))
                 if (Tile *tile = cell.tile())
                     tiles.insert(tile);
 
@@ -640,6 +642,16 @@ void TilesetDock::tilesetChanged(Tileset *tileset)
     }
 }
 
+void TilesetDock::tileImagesChanged(Tileset *tileset, const QList<Tile*> &tiles)
+{
+    const int index = indexOf(mTilesets, tileset);
+    if (index < 0)
+        return;
+
+    if (TilesetModel *model = tilesetViewAt(index)->tilesetModel())
+        model->tilesChanged(tiles);
+}
+
 /**
  * Removes the currently selected tileset.
  */
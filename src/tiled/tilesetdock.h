@@ -128,6 +128,7 @@ private:
     void indexPressed(const QModelIndex &index);
 
     void tilesetChanged(Tileset *tileset);
+    void tileImagesChanged(Tileset *tileset, const QList<Tile*> &tiles);
     void tilesetFileNameChanged(const QString &fileName);
 
     void tileImageSourceChanged(Tile *tile);
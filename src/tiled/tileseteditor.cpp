@@ -247,6 +247,8 @@ TilesetEditor::TilesetEditor(QObject *parent)
 
     connect(TilesetManager::instance(), &TilesetManager::tilesetImagesChanged,
             this, &TilesetEditor::updateTilesetView);
+    connect(TilesetManager::instance(), &TilesetManager::tileImagesChanged,
+            this, &TilesetEditor::updateTiles);
 
     retranslateUi();
     connect(Preferences::instance(), &Preferences::languageChanged, this, &TilesetEditor::retranslateUi);
@@ -624,6 +626,17 @@ void TilesetEditor::updateTilesetView(Tileset *tileset)
     model->tilesetChanged();
 }
 
+void TilesetEditor::updateTiles(Tileset *tileset, const QList<Tile*> &tiles)
+{
+    if (!mCurrentTilesetDocument)
+        return;
+    if (mCurrentTilesetDocument->tileset().data() != tileset)
+        return;
+
+    TilesetModel *model = currentTilesetView()->tilesetModel();
+    model->tilesChanged(tiles);
+}
+
 void TilesetEditor::setCurrentTile(Tile *tile)
 {
     if (mCurrentTile == tile)
@@ -745,12 +758,14 @@ void TilesetEditor::addTiles(const QList<QUrl> &urls)
 }
 
 static bool hasTileReferences(MapDocument *mapDocument,
+                              const QList<Tile*> &tiles,
                               std::function<bool(const Cell &)> condition)
 {
     for (Layer *layer : mapDocument->map()->layers()) {
         if (TileLayer *tileLayer = layer->asTileLayer()) {
-            if (tileLayer->hasCell(condition))
-                return true;
+            for (const Tile *tile : tiles)
+                if (tileLayer->referencesTile(tile))
+                    return true;
 
         } else if (ObjectGroup *objectGroup = layer->asObjectGroup()) {
             for (MapObject *object : *objectGroup) {
@@ -825,7 +840,7 @@ void TilesetEditor::removeTiles()
 
     QList<MapDocument *> mapsUsingTiles;
     for (MapDocument *mapDocument : mCurrentTilesetDocument->mapDocuments())
-        if (hasTileReferences(mapDocument, matchesAnyTile))
+        if (hasTileReferences(mapDocument, tiles, matchesAnyTile))
             mapsUsingTiles.append(mapDocument);
 
     // If the tileset is in use, warn the user and confirm removal
@@ -109,6 +109,7 @@ private:
     void tilesetChanged();
     void selectedTilesChanged();
     void updateTilesetView(Tileset *tileset);
+    void updateTiles(Tileset *tileset, const QList<Tile*> &tiles);
 
     void openAddTilesDialog();
     void addTiles(const QList<QUrl> &urls);
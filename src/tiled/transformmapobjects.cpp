@@ -0,0 +1,146 @@
+/*
+ * transformmapobjects.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "transformmapobjects.h"
+
+#include "changeevents.h"
+#include "document.h"
+
+#include <QCoreApplication>
+
+using namespace Tiled;
+
+static QString undoText(MapObject::ChangedProperties properties, int count)
+{
+    if (properties & MapObject::RotationProperty)
+        return QCoreApplication::translate("Undo Commands", "Rotate %n Object(s)", nullptr, count);
+    if (properties & (MapObject::SizeProperty | MapObject::ShapeProperty))
+        return QCoreApplication::translate("Undo Commands", "Resize %n Object(s)", nullptr, count);
+    return QCoreApplication::translate("Undo Commands", "Move %n Object(s)", nullptr, count);
+}
+
+TransformMapObjects::TransformMapObjects(Document *document,
+                                         const QList<MapObject *> &mapObjects,
+                                         MapObject::ChangedProperties properties,
+                                         const Transforms &oldTransforms,
+                                         QUndoCommand *parent)
+    : TransformMapObjects(document,
+                          mapObjects,
+                          properties,
+                          transforms(mapObjects, properties),
+                          oldTransforms,
+                          parent)
+{
+}
+
+TransformMapObjects::TransformMapObjects(Document *document,
+                                         const QList<MapObject *> &mapObjects,
+                                         MapObject::ChangedProperties properties,
+                                         const Transforms &newTransforms,
+                                         const Transforms &oldTransforms,
+                                         QUndoCommand *parent)
+    : QUndoCommand(undoText(properties, mapObjects.size()), parent)
+    , mDocument(document)
+    , mMapObjects(mapObjects)
+    , mProperties(properties)
+    , mOldTransforms(oldTransforms)
+    , mNewTransforms(newTransforms)
+{
+    mOldChangedProperties.reserve(mapObjects.size());
+    for (const MapObject *mapObject : mapObjects)
+        mOldChangedProperties.append(mapObject->changedProperties());
+}
+
+/**
+ * Returns the current values of the given \a properties of the
+ * \a mapObjects.
+ */
+TransformMapObjects::Transforms TransformMapObjects::transforms(const QList<MapObject *> &mapObjects,
+                                                                MapObject::ChangedProperties properties)
+{
+    Transforms transforms;
+
+    if (properties & MapObject::PositionProperty)
+        transforms.positions.reserve(mapObjects.size());
+    if (properties & MapObject::SizeProperty)
+        transforms.sizes.reserve(mapObjects.size());
+    if (properties & MapObject::RotationProperty)
+        transforms.rotations.reserve(mapObjects.size());
+    if (properties & MapObject::ShapeProperty)
+        transforms.polygons.reserve(mapObjects.size());
+
+    for (const MapObject *mapObject : mapObjects) {
+        if (properties & MapObject::PositionProperty)
+            transforms.positions.append(mapObject->position());
+        if (properties & MapObject::SizeProperty)
+            transforms.sizes.append(mapObject->size());
+        if (properties & MapObject::RotationProperty)
+            transforms.rotations.append(mapObject->rotation());
+        if (properties & MapObject::ShapeProperty)
+            transforms.polygons.append(mapObject->polygon());
+    }
+
+    return transforms;
+}
+
+void TransformMapObjects::undo()
+{
+    apply(mOldTransforms);
+
+    for (int i = 0; i < mMapObjects.size(); ++i)
+        mMapObjects.at(i)->setChangedProperties(mOldChangedProperties.at(i));
+
+    emit mDocument->changed(MapObjectsChangeEvent(mMapObjects, mProperties));
+}
+
+void TransformMapObjects::redo()
+{
+    apply(mNewTransforms);
+
+    for (int i = 0; i < mMapObjects.size(); ++i) {
+        MapObject::ChangedProperties changedProperties = mOldChangedProperties.at(i);
+
+        // The position is not tracked as an overridden template property
+        changedProperties |= mProperties & (MapObject::SizeProperty | MapObject::RotationProperty);
+
+        if ((mProperties & MapObject::ShapeProperty) && !mNewTransforms.polygons.at(i).isEmpty())
+            changedProperties |= MapObject::ShapeProperty;
+
+        mMapObjects.at(i)->setChangedProperties(changedProperties);
+    }
+
+    emit mDocument->changed(MapObjectsChangeEvent(mMapObjects, mProperties));
+}
+
+void TransformMapObjects::apply(const Transforms &transforms)
+{
+    for (int i = 0; i < mMapObjects.size(); ++i) {
+        MapObject *mapObject = mMapObjects.at(i);
+
+        if (mProperties & MapObject::PositionProperty)
+            mapObject->setPosition(transforms.positions.at(i));
+        if (mProperties & MapObject::SizeProperty)
+            mapObject->setSize(transforms.sizes.at(i));
+        if (mProperties & MapObject::RotationProperty)
+            mapObject->setRotation(transforms.rotations.at(i));
+        if (mProperties & MapObject::ShapeProperty)
+            mapObject->setPolygon(transforms.polygons.at(i));
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * transformmapobjects.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mapobject.h"
+
+#include <QList>
+#include <QPointF>
+#include <QPolygonF>
+#include <QSizeF>
+#include <QUndoCommand>
+#include <QVector>
+
+namespace Tiled {
+
+class Document;
+
+/**
+ * Changes the position, size, rotation and/or polygon of a list of map
+ * objects in a single command.
+ *
+ * Compared to pushing a MoveMapObject, ResizeMapObject or RotateMapObject
+ * for each object, this only stores one array for each changed property and
+ * emits a single MapObjectsChangeEvent on undo and redo.
+ */
+class TransformMapObjects : public QUndoCommand
+{
+public:
+    /**
+     * The transform related properties of a list of map objects. Only the
+     * arrays for the properties that are being changed are used.
+     */
+    struct Transforms
+    {
+        QVector<QPointF> positions;
+        QVector<QSizeF> sizes;
+        QVector<qreal> rotations;
+        QVector<QPolygonF> polygons;
+    };
+
+    /**
+     * Creates a command that changes the given \a properties of the
+     * \a mapObjects from \a oldTransforms to their current values.
+     */
+    TransformMapObjects(Document *document,
+                        const QList<MapObject*> &mapObjects,
+                        MapObject::ChangedProperties properties,
+                        const Transforms &oldTransforms,
+                        QUndoCommand *parent = nullptr);
+
+    TransformMapObjects(Document *document,
+                        const QList<MapObject*> &mapObjects,
+                        MapObject::ChangedProperties properties,
+                        const Transforms &newTransforms,
+                        const Transforms &oldTransforms,
+                        QUndoCommand *parent = nullptr);
+
+    static Transforms transforms(const QList<MapObject*> &mapObjects,
+                                 MapObject::ChangedProperties properties);
+
+    void undo() override;
+    void redo() override;
+
+private:
+    void apply(const Transforms &transforms);
+
+    Document *mDocument;
+    const QList<MapObject*> mMapObjects;
+    const MapObject::ChangedProperties mProperties;
+    const Transforms mOldTransforms;
+    const Transforms mNewTransforms;
+    QVector<MapObject::ChangedProperties> mOldChangedProperties;
+};
+
+} // namespace Tiled
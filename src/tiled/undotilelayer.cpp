@@ -0,0 +1,399 @@
+/*
+ * undotilelayer.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "undotilelayer.h"
+
+#include "gidmapper.h"
+#include "logginginterface.h"
+#include "tilelayer.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QTemporaryFile>
+
+namespace Tiled {
+
+/**
+ * Keeps track of all UndoTileLayer instances, ordered from least to most
+ * recently used.
+ */
+class UndoTileLayer::Cache
+{
+public:
+    static Cache &instance()
+    {
+        static Cache cache;
+        return cache;
+    }
+
+    std::list<UndoTileLayer*>::iterator add(UndoTileLayer *layer)
+    {
+        return mEntries.insert(mEntries.end(), layer);
+    }
+
+    void remove(std::list<UndoTileLayer*>::iterator entry)
+    {
+        mEntries.erase(entry);
+    }
+
+    void touch(std::list<UndoTileLayer*>::iterator entry)
+    {
+        mEntries.splice(mEntries.end(), mEntries, entry);
+    }
+
+    void enforceBudget();
+
+    QTemporaryFile *file();
+
+    qint64 mBudget = qint64(256) * 1024 * 1024;
+
+private:
+    std::list<UndoTileLayer*> mEntries;
+    std::unique_ptr<QTemporaryFile> mFile;
+    bool mFileFailed = false;
+};
+
+// The most recently used layers are likely to be accessed again soon, for
+// example while merging the commands of a single brush stroke.
+static const int KeepUncompressed = 4;
+
+void UndoTileLayer::Cache::enforceBudget()
+{
+    if (mBudget <= 0)
+        return;
+
+    qint64 usage = 0;
+    for (const UndoTileLayer *entry : mEntries)
+        usage += entry->memoryUsage();
+
+    if (usage <= mBudget)
+        return;
+
+    int candidates = static_cast<int>(mEntries.size()) - KeepUncompressed;
+
+    for (auto it = mEntries.begin(); usage > mBudget && candidates > 0; ++it, --candidates) {
+        UndoTileLayer *entry = *it;
+        const qint64 previousUsage = entry->memoryUsage();
+
+        // Nothing to gain when all cells are shared
+        if (previousUsage == 0)
+            continue;
+
+        if (entry->mState == Uncompressed)
+            entry->compress();
+
+        // Move the data out of memory entirely when compressing wasn't enough
+        if (usage - previousUsage + entry->memoryUsage() > mBudget && entry->mState == Compressed)
+            entry->store();
+
+        usage += entry->memoryUsage() - previousUsage;
+    }
+}
+
+QTemporaryFile *UndoTileLayer::Cache::file()
+{
+    if (!mFile && !mFileFailed) {
+        mFile.reset(new QTemporaryFile);
+        if (!mFile->open()) {
+            qWarning() << "Failed to open temporary file for undo history:"
+                       << mFile->errorString();
+            mFile.reset();
+            mFileFailed = true;
+        }
+    }
+
+    return mFile.get();
+}
+
+
+UndoTileLayer::UndoTileLayer(TileLayer *layer)
+{
+    mCacheEntry = Cache::instance().add(this);
+    reset(layer);
+}
+
+UndoTileLayer::~UndoTileLayer()
+{
+    Cache::instance().remove(mCacheEntry);
+}
+
+/**
+ * Takes ownership of \a layer, deleting any previously owned layer.
+ */
+void UndoTileLayer::reset(TileLayer *layer)
+{
+    mLayer.reset(layer);
+    mState = Uncompressed;
+    mData.clear();
+    mTilesets.clear();
+
+    Cache::instance().touch(mCacheEntry);
+    enforceMemoryBudget();
+}
+
+/**
+ * Releases ownership of the layer, after restoring its cells.
+ *
+ * Returns nullptr and keeps ownership of the layer when its cells could not
+ * be restored.
+ */
+TileLayer *UndoTileLayer::release()
+{
+    if (!restore())
+        return nullptr;
+    return mLayer.release();
+}
+
+/**
+ * Returns the owned layer, restoring its cells when necessary. The returned
+ * layer stays valid until the next call to enforceMemoryBudget() or reset().
+ *
+ * Returns nullptr when the cells of the layer could not be restored.
+ */
+TileLayer *UndoTileLayer::get() const
+{
+    if (!mLayer || !restore())
+        return nullptr;
+
+    Cache::instance().touch(mCacheEntry);
+    return mLayer.get();
+}
+
+/**
+ * Sets the memory budget in bytes. A value of 0 or less disables
+ * compression of the undo history.
+ */
+void UndoTileLayer::setMemoryBudget(qint64 bytes)
+{
+    Cache::instance().mBudget = bytes;
+    enforceMemoryBudget();
+}
+
+/**
+ * Compresses or stores the least recently used layers until the estimated
+ * memory usage is within the budget.
+ */
+void UndoTileLayer::enforceMemoryBudget()
+{
+    Cache::instance().enforceBudget();
+}
+
+qint64 UndoTileLayer::memoryUsage() const
+{
+    switch (mState) {
+    case Uncompressed:
+        // Chunks still shared with the map (or another command) cost nothing
+        // extra and would not be freed by compressing them.
+        if (mLayer)
+            return qint64(mLayer->unsharedChunkCount()) * CHUNK_SIZE * CHUNK_SIZE * sizeof(Cell);
+        return 0;
+    case Compressed:
+        return mData.size();
+    case Stored:
+    case Lost:
+        break;
+    }
+    return 0;
+}
+
+static void appendUInt32(QByteArray &data, quint32 value)
+{
+    data.append(static_cast<char>(value));
+    data.append(static_cast<char>(value >> 8));
+    data.append(static_cast<char>(value >> 16));
+    data.append(static_cast<char>(value >> 24));
+}
+
+static quint32 readUInt32(const unsigned char *data)
+{
+    return data[0] |
+           data[1] << 8 |
+           data[2] << 16 |
+           data[3] << 24;
+}
+
+/**
+ * Serializes the cells of the layer as a list of chunks, each consisting of
+ * its position followed by the global tile IDs of its cells. This data is
+ * then compressed and the layer is cleared.
+ */
+void UndoTileLayer::compress()
+{
+    Q_ASSERT(mState == Uncompressed);
+
+    if (!mLayer)
+        return;
+
+    const auto usedTilesets = mLayer->usedTilesets();
+    mTilesets.clear();
+    for (const SharedTileset &tileset : usedTilesets)
+        mTilesets.append(tileset);
+
+    const GidMapper gidMapper(mTilesets);
+    const auto chunks = mLayer->sortedChunksToWrite(QSize(CHUNK_SIZE, CHUNK_SIZE));
+
+    QByteArray data;
+    data.reserve(chunks.size() * (2 + CHUNK_SIZE * CHUNK_SIZE) * 4);
+
+    for (const QRect &rect : chunks) {
+        appendUInt32(data, static_cast<quint32>(rect.x()));
+        appendUInt32(data, static_cast<quint32>(rect.y()));
+
+        for (int y = rect.top(); y <= rect.bottom(); ++y)
+            for (int x = rect.left(); x <= rect.right(); ++x)
+                appendUInt32(data, gidMapper.cellToGid(mLayer->cellAt(x, y)));
+    }
+
+    mCompressionMethod = Zstandard;
+    QByteArray compressed = Tiled::compress(data, mCompressionMethod, 1);
+
+    // Zstandard support is optional
+    if (compressed.isEmpty() && !data.isEmpty()) {
+        mCompressionMethod = Zlib;
+        compressed = Tiled::compress(data, mCompressionMethod, 1);
+    }
+
+    if (compressed.isEmpty() && !data.isEmpty())
+        return;
+
+    mUncompressedSize = data.size();
+    mData = compressed;
+    mState = Compressed;
+    mLayer->clear();
+}
+
+/**
+ * Moves the compressed data to the shared temporary file.
+ */
+void UndoTileLayer::store()
+{
+    Q_ASSERT(mState == Compressed);
+
+    QTemporaryFile *file = Cache::instance().file();
+    if (!file)
+        return;
+
+    const qint64 offset = file->size();
+    if (!file->seek(offset) || file->write(mData) != mData.size()) {
+        qWarning() << "Failed to write undo history:" << file->errorString();
+        return;
+    }
+
+    mFileOffset = offset;
+    mFileSize = mData.size();
+    mData.clear();
+    mState = Stored;
+}
+
+/**
+ * Restores the cells of the layer. All data is read and validated before any
+ * cell is changed, so that on failure the layer is left empty rather than
+ * partially restored. Returns whether the cells could be restored.
+ */
+bool UndoTileLayer::restore() const
+{
+    if (mState == Uncompressed)
+        return true;
+    if (mState == Lost)
+        return false;
+
+    if (mState == Stored) {
+        QTemporaryFile *file = Cache::instance().file();
+        if (file && file->seek(mFileOffset))
+            mData = file->read(mFileSize);
+
+        if (mData.size() != mFileSize) {
+            fail(file ? file->errorString() : QString());
+            return false;
+        }
+    }
+
+    const QByteArray data = mUncompressedSize > 0 ? decompress(mData, mUncompressedSize, mCompressionMethod)
+                                                  : QByteArray();
+    const int chunkDataSize = (2 + CHUNK_SIZE * CHUNK_SIZE) * 4;
+
+    if (data.size() != mUncompressedSize || data.size() % chunkDataSize != 0) {
+        fail(QString());
+        return false;
+    }
+
+    const GidMapper gidMapper(mTilesets);
+    const auto bytes = reinterpret_cast<const unsigned char*>(data.constData());
+    const int chunkCount = data.size() / chunkDataSize;
+
+    // Validate all cells before changing any
+    for (int chunk = 0; chunk < chunkCount; ++chunk) {
+        const unsigned char *chunkData = bytes + chunk * chunkDataSize + 8;
+
+        for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; ++i) {
+            const unsigned gid = readUInt32(chunkData + i * 4);
+            if (gid == 0)
+                continue;
+
+            bool ok;
+            gidMapper.gidToCell(gid, ok);
+            if (!ok) {
+                fail(QString());
+                return false;
+            }
+        }
+    }
+
+    for (int chunk = 0; chunk < chunkCount; ++chunk) {
+        const unsigned char *chunkData = bytes + chunk * chunkDataSize;
+        const int chunkX = static_cast<int>(readUInt32(chunkData));
+        const int chunkY = static_cast<int>(readUInt32(chunkData + 4));
+        chunkData += 8;
+
+        for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; ++i) {
+            const unsigned gid = readUInt32(chunkData + i * 4);
+            if (gid == 0)
+                continue;
+
+            bool ok;
+            const Cell cell = gidMapper.gidToCell(gid, ok);
+            mLayer->setCell(chunkX + (i & CHUNK_MASK), chunkY + i / CHUNK_SIZE, cell);
+        }
+    }
+
+    mData.clear();
+    mTilesets.clear();
+    mState = Uncompressed;
+    return true;
+}
+
+/**
+ * Marks the cells of the layer as lost and reports the problem to the user.
+ */
+void UndoTileLayer::fail(const QString &reason) const
+{
+    mData.clear();
+    mTilesets.clear();
+    mState = Lost;
+
+    QString message = QCoreApplication::translate("Undo Commands",
+                                                  "Failed to restore undo history, the affected step can't be undone or redone");
+    if (!reason.isEmpty())
+        message += QStringLiteral(": ") + reason;
+
+    ERROR(message);
+}
+
+} // namespace Tiled
@@ -0,0 +1,100 @@
+/*
+ * undotilelayer.h
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "compression.h"
+#include "tileset.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include <list>
+#include <memory>
+
+namespace Tiled {
+
+class TileLayer;
+
+/**
+ * Owns a tile layer that is kept around by an undo command.
+ *
+ * All instances share a memory budget. When the estimated memory used by
+ * their tile data exceeds this budget, the cells of the least recently used
+ * layers are compressed. When that is not enough, the compressed data is
+ * moved to a temporary file. The cells are restored as soon as the layer is
+ * accessed again.
+ *
+ * Only the cells are compressed. The TileLayer instance itself stays alive,
+ * so that its identity, name and properties are preserved.
+ *
+ * When the cells can't be restored, for example because the temporary file
+ * could not be read, an error is reported and get() and release() return
+ * nullptr. Undo commands should then leave the map untouched.
+ */
+class UndoTileLayer
+{
+public:
+    explicit UndoTileLayer(TileLayer *layer = nullptr);
+    ~UndoTileLayer();
+
+    UndoTileLayer(const UndoTileLayer &) = delete;
+    UndoTileLayer &operator=(const UndoTileLayer &) = delete;
+
+    void reset(TileLayer *layer = nullptr);
+    TileLayer *release();
+
+    TileLayer *get() const;
+    TileLayer *operator->() const { return get(); }
+    explicit operator bool() const { return mLayer != nullptr; }
+
+    static void setMemoryBudget(qint64 bytes);
+    static void enforceMemoryBudget();
+
+private:
+    class Cache;
+
+    enum State {
+        Uncompressed,
+        Compressed,
+        Stored,
+        Lost
+    };
+
+    qint64 memoryUsage() const;
+    void compress();
+    void store();
+    bool restore() const;
+    void fail(const QString &reason) const;
+
+    std::unique_ptr<TileLayer> mLayer;
+    std::list<UndoTileLayer*>::iterator mCacheEntry;
+
+    mutable State mState = Uncompressed;
+    mutable QByteArray mData;
+    mutable QVector<SharedTileset> mTilesets;
+    CompressionMethod mCompressionMethod = Zstandard;
+    int mUncompressedSize = 0;
+    qint64 mFileOffset = 0;
+    int mFileSize = 0;
+};
+
+} // namespace Tiled
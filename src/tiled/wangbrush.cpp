@@ -446,14 +446,12 @@ static const QPoint aroundVertexPoints[] = {
 
 static WangTile findMatchingWangTile(const WangSet *wangSet, WangId wangId)
 {
-    const auto potentials = wangSet->findMatchingWangTiles(wangId);
-    if (potentials.isEmpty())
+    const auto &matches = wangSet->matchingWangTiles(wangId);
+    const int index = pickCumulative(matches.cumulativeProbabilities);
+    if (index == -1)
         return WangTile();
 
-    RandomPicker<WangTile> wangTiles;
-    for (const WangTile &wangTile : potentials)
-        wangTiles.add(wangTile, wangSet->wangTileProbability(wangTile));
-    return wangTiles.pick();
+    return matches.wangTiles.at(index);
 }
 
 void WangBrush::updateBrush()
@@ -80,6 +80,73 @@ static void getSurroundingPoints(QPoint point,
     }
 }
 
+/**
+ * Picks a random Wang tile from \a matches for which \a fits returns true,
+ * taking into account their probabilities. When no tile fits, the last one
+ * that was tried is returned.
+ */
+template<typename Fits>
+static WangTile pickFittingWangTile(const WangSet::MatchingWangTiles &matches,
+                                    Fits fits)
+{
+    const int first = pickCumulative(matches.cumulativeProbabilities);
+    if (first == -1)
+        return WangTile();
+
+    WangTile wangTile = matches.wangTiles.at(first);
+    if (fits(wangTile))
+        return wangTile;
+
+    // Only set up picking without replacement when the first pick didn't fit
+    RandomPicker<int> remaining;
+    for (int i = 0; i < matches.wangTiles.size(); ++i) {
+        if (i != first) {
+            const qreal previous = i > 0 ? matches.cumulativeProbabilities.at(i - 1) : 0.0;
+            remaining.add(i, matches.cumulativeProbabilities.at(i) - previous);
+        }
+    }
+
+    while (!remaining.isEmpty()) {
+        wangTile = matches.wangTiles.at(remaining.take());
+        if (fits(wangTile))
+            break;
+    }
+
+    return wangTile;
+}
+
+void WangFiller::RegionBitmap::setRegion(const QRegion &region)
+{
+    mRegion = region;
+    mBounds = region.boundingRect();
+    mBits = QBitArray(mBounds.width() * mBounds.height());
+
+#if QT_VERSION < 0x050800
+    const auto rects = region.rects();
+    for (const QRect &rect : rects) {
+#else
+    for (const QRect &rect : region) {
+#endif
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            const int rowStart = (y - mBounds.y()) * mBounds.width() - mBounds.x();
+            for (int x = rect.left(); x <= rect.right(); ++x)
+                mBits.setBit(rowStart + x);
+        }
+    }
+}
+
+/**
+ * Returns the bitmap for the given \a region. The bitmap is reused as long
+ * as the same region is passed in, for example when finding fitting cells
+ * for each point in a region.
+ */
+const WangFiller::RegionBitmap &WangFiller::regionBitmap(const QRegion &region) const
+{
+    if (mRegionBitmap.region() != region || mRegionBitmap.bounds().isEmpty())
+        mRegionBitmap.setRegion(region);
+    return mRegionBitmap;
+}
+
 Cell WangFiller::findFittingCell(const TileLayer &back,
                                  const TileLayer &front,
                                  const QRegion &fillRegion,
@@ -87,56 +154,44 @@ Cell WangFiller::findFittingCell(const TileLayer &back,
 {
     Q_ASSERT(mWangSet);
 
-    QList<WangTile> wangTilesList = mWangSet->findMatchingWangTiles(wangIdFromSurroundings(back,
-                                                                                           front,
-                                                                                           fillRegion,
-                                                                                           point));
-    RandomPicker<WangTile> wangTiles;
-
-    for (const WangTile &wangTile : wangTilesList)
-        wangTiles.add(wangTile, mWangSet->wangTileProbability(wangTile));
+    const RegionBitmap &bitmap = regionBitmap(fillRegion);
+    const auto &matches = mWangSet->matchingWangTiles(wangIdFromSurroundings(back,
+                                                                             front,
+                                                                             bitmap,
+                                                                             point));
 
-    WangTile wangTile;
-    if (!mWangSet->isComplete()) {
-        // goes through all adjacent, empty tiles and sees if the current wangTile
-        // allows them to have at least one fill option.
-        while (!wangTiles.isEmpty()) {
-            wangTile = wangTiles.take();
+    const bool complete = mWangSet->isComplete();
 
-            bool continueFlag = false;
+    QPoint adjacentPoints[8];
+    getSurroundingPoints(point, mStaggeredRenderer, mStaggerAxis, adjacentPoints);
 
-            QPoint adjacentPoints[8];
-            getSurroundingPoints(point, mStaggeredRenderer, mStaggerAxis, adjacentPoints);
+    // goes through all adjacent, empty tiles and sees if the current wangTile
+    // allows them to have at least one fill option.
+    auto fits = [&] (const WangTile &wangTile) {
+        if (complete)
+            return true;
 
-            // now goes through and checks adjacents, continuing if any can't be filled
-            for (int i = 0; i < 8; ++i) {
-                QPoint adjacentPoint = adjacentPoints[i];
+        for (int i = 0; i < 8; ++i) {
+            const QPoint adjacentPoint = adjacentPoints[i];
 
-                // check if the point is empty, otherwise, continue.
-                if (!getCell(back, front, fillRegion, adjacentPoint).isEmpty())
-                    continue;
+            // check if the point is empty, otherwise, continue.
+            if (!getCell(back, front, bitmap, adjacentPoint).isEmpty())
+                continue;
 
-                WangId adjacentWangId = wangIdFromSurroundings(back,
-                                                               front,
-                                                               fillRegion,
-                                                               adjacentPoint);
-                WangId wangId = wangTile.wangId();
-                adjacentWangId.updateToAdjacent(wangId, (i + 4) % 8);
+            WangId adjacentWangId = wangIdFromSurroundings(back,
+                                                           front,
+                                                           bitmap,
+                                                           adjacentPoint);
+            adjacentWangId.updateToAdjacent(wangTile.wangId(), (i + 4) % 8);
 
-                if (!mWangSet->wildWangIdIsUsed(adjacentWangId)) {
-                    continueFlag = true;
-                    break;
-                }
-            }
-
-            if (!continueFlag)
-                break;
+            if (!mWangSet->wildWangIdIsUsed(adjacentWangId))
+                return false;
         }
-    } else if (!wangTiles.isEmpty()) {
-        wangTile = wangTiles.pick();
-    }
 
-    return wangTile.makeCell();
+        return true;
+    };
+
+    return pickFittingWangTile(matches, fits).makeCell();
 }
 
 std::unique_ptr<TileLayer> WangFiller::fillRegion(const TileLayer &back,
@@ -144,7 +199,8 @@ std::unique_ptr<TileLayer> WangFiller::fillRegion(const TileLayer &back,
 {
     Q_ASSERT(mWangSet);
 
-    const QRect boundingRect = fillRegion.boundingRect();
+    const RegionBitmap &bitmap = regionBitmap(fillRegion);
+    const QRect boundingRect = bitmap.bounds();
 
     std::unique_ptr<TileLayer> tileLayer { new TileLayer(QString(),
                                                          boundingRect.x(),
@@ -152,6 +208,12 @@ std::unique_ptr<TileLayer> WangFiller::fillRegion(const TileLayer &back,
                                                          boundingRect.width(),
                                                          boundingRect.height()) };
 
+    const int width = tileLayer->width();
+    const QPoint origin = tileLayer->position();
+    auto indexOf = [=] (QPoint p) {
+        return (p.y() - origin.y()) * width + (p.x() - origin.x());
+    };
+
     QVector<WangId> wangIds(tileLayer->width() * tileLayer->height(), 0);
 #if QT_VERSION < 0x050800
     const auto rects = fillRegion.rects();
@@ -160,29 +222,21 @@ std::unique_ptr<TileLayer> WangFiller::fillRegion(const TileLayer &back,
     for (const QRect &rect : fillRegion) {
 #endif
         for (int x = rect.left(); x <= rect.right(); ++x) {
-            int index = x - tileLayer->x() + (rect.top() - tileLayer->y()) * tileLayer->width();
-            wangIds[index] = wangIdFromSurroundings(back,
-                                                    fillRegion,
-                                                    QPoint(x, rect.top()));
-
-            index = x - tileLayer->x() + (rect.bottom() - tileLayer->y()) * tileLayer->width();
-            wangIds[index] = wangIdFromSurroundings(back,
-                                                    fillRegion,
-                                                    QPoint(x, rect.bottom()));
+            const QPoint top(x, rect.top());
+            const QPoint bottom(x, rect.bottom());
+            wangIds[indexOf(top)] = wangIdFromSurroundings(back, bitmap, top);
+            wangIds[indexOf(bottom)] = wangIdFromSurroundings(back, bitmap, bottom);
         }
         for (int y = rect.top() + 1; y < rect.bottom(); ++y) {
-            int index = rect.left() - tileLayer->x() + (y - tileLayer->y()) * tileLayer->width();
-            wangIds[index] = wangIdFromSurroundings(back,
-                                                    fillRegion,
-                                                    QPoint(rect.left(), y));
-
-            index = rect.right() - tileLayer->x() + (y - tileLayer->y()) * tileLayer->width();
-            wangIds[index] = wangIdFromSurroundings(back,
-                                                    fillRegion,
-                                                    QPoint(rect.right(), y));
+            const QPoint left(rect.left(), y);
+            const QPoint right(rect.right(), y);
+            wangIds[indexOf(left)] = wangIdFromSurroundings(back, bitmap, left);
+            wangIds[indexOf(right)] = wangIdFromSurroundings(back, bitmap, right);
         }
     }
 
+    const bool complete = mWangSet->isComplete();
+
 #if QT_VERSION < 0x050800
     for (const QRect &rect : rects) {
 #else
@@ -190,57 +244,44 @@ std::unique_ptr<TileLayer> WangFiller::fillRegion(const TileLayer &back,
 #endif
         for (int y = rect.top(); y <= rect.bottom(); ++y) {
             for (int x = rect.left(); x <= rect.right(); ++x) {
-                QPoint currentPoint(x, y);
-                int currentIndex = (currentPoint.y() - tileLayer->y()) * tileLayer->width() + (currentPoint.x() - tileLayer->x());
+                const QPoint currentPoint(x, y);
+                const auto &matches = mWangSet->matchingWangTiles(wangIds[indexOf(currentPoint)]);
 
-                QList<WangTile> wangTilesList = mWangSet->findMatchingWangTiles(wangIds[currentIndex]);
-                RandomPicker<WangTile> wangTiles;
+                QPoint adjacentPoints[8];
+                getSurroundingPoints(currentPoint, mStaggeredRenderer, mStaggerAxis, adjacentPoints);
 
-                for (const WangTile &wangTile : wangTilesList)
-                    wangTiles.add(wangTile, mWangSet->wangTileProbability(wangTile));
+                // Returns whether the empty adjacent cells within the region
+                // can still be filled when placing the given Wang tile
+                auto fits = [&] (const WangTile &wangTile) {
+                    if (complete)
+                        return true;
 
-                while (!wangTiles.isEmpty()) {
-                    WangTile wangTile = wangTiles.take();
+                    for (int i = 0; i < 8; ++i) {
+                        const QPoint p = adjacentPoints[i];
+                        if (!bitmap.contains(p) || !tileLayer->cellAt(p - origin).isEmpty())
+                            continue;
 
-                    bool fill = true;
-                    if (!mWangSet->isComplete()) {
-                        QPoint adjacentPoints[8];
-                        getSurroundingPoints(currentPoint, mStaggeredRenderer, mStaggerAxis, adjacentPoints);
+                        WangId adjacentWangId = wangIds[indexOf(p)];
+                        adjacentWangId.updateToAdjacent(wangTile.wangId(), (i + 4) % 8);
 
-                        for (int i = 0; i < 8; ++i) {
-                            QPoint p = adjacentPoints[i];
-                            if (!fillRegion.contains(p) || !tileLayer->cellAt(p - tileLayer->position()).isEmpty())
-                                continue;
-                            p -= tileLayer->position();
-                            int index = p.y() * tileLayer->width() + p.x();
+                        if (!mWangSet->wildWangIdIsUsed(adjacentWangId))
+                            return false;
+                    }
 
-                            WangId adjacentWangId = wangIds[index];
-                            adjacentWangId.updateToAdjacent(wangTile.wangId(), (i + 4) % 8);
+                    return true;
+                };
 
-                            if (!mWangSet->wildWangIdIsUsed(adjacentWangId)) {
-                                fill = wangTiles.isEmpty();
+                const WangTile wangTile = pickFittingWangTile(matches, fits);
+                if (!wangTile.tile())
+                    continue;
 
-                                break;
-                            }
-                        }
-                    }
+                tileLayer->setCell(x - origin.x(), y - origin.y(), wangTile.makeCell());
 
-                    if (fill) {
-                        tileLayer->setCell(currentPoint.x() - tileLayer->x(),
-                                           currentPoint.y() - tileLayer->y(),
-                                           wangTile.makeCell());
-                        QPoint adjacentPoints[8];
-                        getSurroundingPoints(currentPoint, mStaggeredRenderer, mStaggerAxis, adjacentPoints);
-                        for (int i = 0; i < 8; ++i) {
-                            QPoint p = adjacentPoints[i];
-                            if (!fillRegion.contains(p) || !tileLayer->cellAt(p - tileLayer->position()).isEmpty())
-                                continue;
-                            p -= tileLayer->position();
-                            int index = p.y() * tileLayer->width() + p.x();
-                            wangIds[index].updateToAdjacent(wangTile.wangId(), (i + 4) % 8);
-                        }
-                        break;
-                    }
+                for (int i = 0; i < 8; ++i) {
+                    const QPoint p = adjacentPoints[i];
+                    if (!bitmap.contains(p) || !tileLayer->cellAt(p - origin).isEmpty())
+                        continue;
+                    wangIds[indexOf(p)].updateToAdjacent(wangTile.wangId(), (i + 4) % 8);
                 }
             }
         }
@@ -251,7 +292,7 @@ std::unique_ptr<TileLayer> WangFiller::fillRegion(const TileLayer &back,
 
 const Cell &WangFiller::getCell(const TileLayer &back,
                                 const TileLayer &front,
-                                const QRegion &fillRegion,
+                                const RegionBitmap &fillRegion,
                                 QPoint point) const
 {
     if (!fillRegion.contains(point))
@@ -263,7 +304,7 @@ const Cell &WangFiller::getCell(const TileLayer &back,
 
 WangId WangFiller::wangIdFromSurroundings(const TileLayer &back,
                                           const TileLayer &front,
-                                          const QRegion &fillRegion,
+                                          const RegionBitmap &fillRegion,
                                           QPoint point) const
 {
     Cell surroundingCells[8];
@@ -277,7 +318,7 @@ WangId WangFiller::wangIdFromSurroundings(const TileLayer &back,
 }
 
 WangId WangFiller::wangIdFromSurroundings(const TileLayer &back,
-                                          const QRegion &fillRegion,
+                                          const RegionBitmap &fillRegion,
                                           QPoint point) const
 {
     Cell surroundingCells[8];
@@ -23,9 +23,11 @@
 #include "map.h"
 #include "wangset.h"
 
+#include <QBitArray>
 #include <QList>
 #include <QMap>
 #include <QPoint>
+#include <QRegion>
 
 #include <memory>
 
@@ -74,6 +76,34 @@ public:
                                           const QRegion &fillRegion) const;
 
 private:
+    /**
+     * A dense bitmap of the cells within a region, which can be queried
+     * much faster than QRegion::contains().
+     */
+    class RegionBitmap
+    {
+    public:
+        void setRegion(const QRegion &region);
+        const QRegion &region() const { return mRegion; }
+        QRect bounds() const { return mBounds; }
+
+        bool contains(QPoint point) const
+        {
+            const int x = point.x() - mBounds.x();
+            const int y = point.y() - mBounds.y();
+            if (x < 0 || y < 0 || x >= mBounds.width() || y >= mBounds.height())
+                return false;
+            return mBits.testBit(x + y * mBounds.width());
+        }
+
+    private:
+        QRegion mRegion;
+        QRect mBounds;
+        QBitArray mBits;
+    };
+
+    const RegionBitmap &regionBitmap(const QRegion &region) const;
+
     /**
      * Returns a cell from either the \a back or \a front, based on the
      * \a fillRegion. \a point, \a front, and \a fillRegion are relative to
@@ -81,7 +111,7 @@ private:
      */
     const Cell &getCell(const TileLayer &back,
                         const TileLayer &front,
-                        const QRegion &fillRegion,
+                        const RegionBitmap &fillRegion,
                         QPoint point) const;
 
     /**
@@ -90,7 +120,7 @@ private:
      */
     WangId wangIdFromSurroundings(const TileLayer &back,
                                   const TileLayer &front,
-                                  const QRegion &fillRegion,
+                                  const RegionBitmap &fillRegion,
                                   QPoint point) const;
 
     /**
@@ -98,12 +128,13 @@ private:
      * \a fillRegion. \a point and \a fillRegion are relative to \a back.
      */
     WangId wangIdFromSurroundings(const TileLayer &back,
-                                  const QRegion &fillRegion,
+                                  const RegionBitmap &fillRegion,
                                   QPoint point) const;
 
     WangSet *mWangSet;
     StaggeredRenderer *mStaggeredRenderer;
     Map::StaggerAxis mStaggerAxis;
+    mutable RegionBitmap mRegionBitmap;
 };
 
 } // namespace Tiled
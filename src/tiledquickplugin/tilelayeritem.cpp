@@ -20,6 +20,7 @@
 
 #include "tilelayeritem.h"
 
+#include "cellwalker.h"
 #include "tile.h"
 #include "tilelayer.h"
 #include "tileset.h"
@@ -134,10 +135,17 @@ static void drawOrthogonalTileLayer(QSGNode *parent,
     const QRect contentRect = rect.intersected(layer->localBounds());
 
     for (int y = contentRect.top(); y <= contentRect.bottom(); ++y) {
-        for (int x = contentRect.left(); x <= contentRect.right(); ++x) {
-            const Cell &cell = layer->cellAt(x, y);
-            if (cell.isEmpty())
+        CellWalker walker(*layer, QPoint(contentRect.left(), y), QPoint(1, 0));
+
+        for (int x = contentRect.left(); x <= contentRect.right(); ++x, walker.advance()) {
+            // Skip over empty cells and absent chunks
+            if (const int steps = walker.emptyStepsAhead()) {
+                x += steps - 1;
+                walker.advance(steps - 1);
                 continue;
+            }
+
+            const Cell &cell = walker.cell();
 
             Tileset *tileset = cell.tileset();
 
@@ -31,6 +31,7 @@
 
 #include <QCommandLineParser>
 #include <QDebug>
+#include <QFileInfo>
 #include <QGuiApplication>
 #include <QStringList>
 #include <QUrl>
@@ -49,8 +50,6 @@ int main(int argc, char *argv[])
     app.setApplicationName(QLatin1String("TmxRasterizer"));
     app.setApplicationVersion(QLatin1String("1.0"));
 
-    PluginManager::instance()->loadPlugins();
-
     QCommandLineParser parser;
     parser.setApplicationDescription(QCoreApplication::translate("main", "Renders a Tiled map or world to an image."));
     parser.addHelpOption();
@@ -89,6 +88,20 @@ int main(int argc, char *argv[])
     if (fileToOpen.isEmpty() || fileToSave.isEmpty())
         parser.showHelp(1);
 
+    // Only load the plugins needed for reading the given map, since loading
+    // all plugins can take much longer than rendering a small map. The maps
+    // referenced by a world can be in any format. The remaining plugins are
+    // loaded on demand, for tilesets or templates in other formats.
+    PluginManager *pluginManager = PluginManager::instance();
+    const QString suffix = QFileInfo(fileToOpen).suffix();
+    if (suffix.compare(QLatin1String("world"), Qt::CaseInsensitive) == 0) {
+        pluginManager->loadPlugins();
+    } else {
+        pluginManager->setLoadPluginsOnDemand(true);
+        if (suffix.compare(QLatin1String("tmx"), Qt::CaseInsensitive) != 0)
+            pluginManager->loadPluginsForFile(fileToOpen);
+    }
+
     TmxRasterizer w;
     w.setAntiAliasing(parser.isSet(QLatin1String("anti-aliasing")));
     w.setSmoothImages(!parser.isSet(QLatin1String("no-smoothing")));
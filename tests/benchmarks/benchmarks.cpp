@@ -0,0 +1,539 @@
+/*
+ * benchmarks.cpp
+ * Copyright 2020, Thorbjørn Lindeijer <bjorn@lindeijer.nl>
+ *
+ * This file is part of Tiled.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmarks for performance critical parts of libtiled and of the editing
+ * tools, which are compiled in from src/tiled.
+ *
+ * The maps used by these benchmarks are generated using a fixed seed, so
+ * that results are comparable between runs. To get machine-readable output,
+ * use the output options of QTest, for example:
+ *
+ *     benchmarks -o results.xml,xml
+ *     benchmarks -o results.csv,csv
+ *
+ * Individual benchmarks can be selected by passing their name, for example
+ * "benchmarks readMap" or "benchmarks readMap:csv".
+ */
+
+#include "automappingconditions.h"
+#include "compression.h"
+#include "floodfill.h"
+#include "gidmapper.h"
+#include "hexagonalrenderer.h"
+#include "isometricrenderer.h"
+#include "map.h"
+#include "mapreader.h"
+#include "mapwriter.h"
+#include "orthogonalrenderer.h"
+#include "staggeredrenderer.h"
+#include "tilelayer.h"
+#include "tileset.h"
+#include "wangfiller.h"
+#include "wangset.h"
+
+#include <QBuffer>
+#include <QImage>
+#include <QPainter>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+
+#include <memory>
+
+using namespace Tiled;
+
+namespace {
+
+const int MapSize = 512;
+const int LayerCount = 4;
+const int TileSize = 32;
+const int TilesetColumns = 16;
+
+/**
+ * A small linear congruential generator, used instead of qrand() so that
+ * the generated maps do not depend on the platform.
+ */
+class Random
+{
+public:
+    explicit Random(quint32 seed = 1) : mState(seed) {}
+
+    int next(int bound)
+    {
+        mState = mState * 1664525u + 1013904223u;
+        return static_cast<int>((mState >> 8) % static_cast<quint32>(bound));
+    }
+
+private:
+    quint32 mState;
+};
+
+SharedTileset createTileset(const QString &imageFileName)
+{
+    QImage image(TileSize * TilesetColumns, TileSize * TilesetColumns,
+                 QImage::Format_ARGB32_Premultiplied);
+
+    for (int y = 0; y < TilesetColumns; ++y) {
+        for (int x = 0; x < TilesetColumns; ++x) {
+            const QColor color = QColor::fromHsv((x * TilesetColumns + y) % 360, 200, 200);
+            for (int py = 0; py < TileSize; ++py)
+                for (int px = 0; px < TileSize; ++px)
+                    image.setPixel(x * TileSize + px, y * TileSize + py, color.rgba());
+        }
+    }
+
+    image.save(imageFileName);
+
+    SharedTileset tileset = Tileset::create(QStringLiteral("tiles"), TileSize, TileSize);
+    tileset->loadFromImage(image, imageFileName);
+    return tileset;
+}
+
+/**
+ * Generates a map with one dense tile layer followed by layers that are
+ * filled for about a third, in clusters, like decoration layers usually are.
+ */
+std::unique_ptr<Map> generateMap(const SharedTileset &tileset,
+                                 Map::Orientation orientation = Map::Orthogonal)
+{
+    auto map = std::make_unique<Map>(orientation, MapSize, MapSize,
+                                     TileSize, orientation == Map::Orthogonal ? TileSize : TileSize / 2);
+    map->setHexSideLength(TileSize / 2);
+    map->addTileset(tileset);
+
+    Random random;
+    const int tileCount = tileset->tileCount();
+
+    for (int i = 0; i < LayerCount; ++i) {
+        auto layer = new TileLayer(QStringLiteral("Layer %1").arg(i), 0, 0, MapSize, MapSize);
+
+        for (int y = 0; y < MapSize; ++y) {
+            for (int x = 0; x < MapSize; ++x) {
+                if (i > 0 && ((x / 8 + y / 8 + i) % 3 != 0 || random.next(4) == 0))
+                    continue;
+
+                Cell cell(tileset->findTile(random.next(tileCount)));
+                cell.setFlippedHorizontally(random.next(8) == 0);
+                layer->setCell(x, y, cell);
+            }
+        }
+
+        map->addLayer(layer);
+    }
+
+    return map;
+}
+
+TileLayer *firstTileLayer(const Map &map)
+{
+    return map.layerAt(0)->asTileLayer();
+}
+
+std::unique_ptr<MapRenderer> createRenderer(const Map *map)
+{
+    switch (map->orientation()) {
+    case Map::Isometric:
+        return std::make_unique<IsometricRenderer>(map);
+    case Map::Staggered:
+        return std::make_unique<StaggeredRenderer>(map);
+    case Map::Hexagonal:
+        return std::make_unique<HexagonalRenderer>(map);
+    default:
+        return std::make_unique<OrthogonalRenderer>(map);
+    }
+}
+
+/**
+ * Returns whether libtiled was built with support for the given layer data
+ * \a format.
+ */
+bool isSupported(Map::LayerDataFormat format)
+{
+    if (format == Map::Base64Zstandard)
+        return !compress(QByteArray("data"), Zstandard).isEmpty();
+    return true;
+}
+
+void addLayerDataFormatRows()
+{
+    QTest::addColumn<Map::LayerDataFormat>("format");
+
+    QTest::newRow("xml") << Map::XML;
+    QTest::newRow("base64") << Map::Base64;
+    QTest::newRow("base64-gzip") << Map::Base64Gzip;
+    QTest::newRow("base64-zlib") << Map::Base64Zlib;
+    QTest::newRow("base64-zstd") << Map::Base64Zstandard;
+    QTest::newRow("csv") << Map::CSV;
+}
+
+} // anonymous namespace
+
+class Benchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void readMap_data();
+    void readMap();
+
+    void writeMap_data();
+    void writeMap();
+
+    void encodeLayerData_data();
+    void encodeLayerData();
+
+    void decodeLayerData_data();
+    void decodeLayerData();
+
+    void setCell();
+    void cellAt();
+    void region();
+    void regionOf();
+    void clone();
+    void computeDiffRegion();
+
+    void drawTileLayer_data();
+    void drawTileLayer();
+
+    void floodFill_data();
+    void floodFill();
+    void wangFill();
+    void autoMapMatch();
+
+private:
+    QByteArray writeMapData(const Map &map) const;
+
+    QTemporaryDir mTemporaryDir;
+    QString mMapFileName;
+    SharedTileset mTileset;
+    std::unique_ptr<Map> mMap;
+};
+
+void Benchmarks::initTestCase()
+{
+    QVERIFY(mTemporaryDir.isValid());
+
+    mMapFileName = mTemporaryDir.filePath(QStringLiteral("map.tmx"));
+    mTileset = createTileset(mTemporaryDir.filePath(QStringLiteral("tiles.png")));
+    mMap = generateMap(mTileset);
+}
+
+void Benchmarks::cleanupTestCase()
+{
+    mMap.reset();
+    mTileset.clear();
+}
+
+QByteArray Benchmarks::writeMapData(const Map &map) const
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+
+    MapWriter writer;
+    writer.writeMap(&map, &buffer, mMapFileName);
+
+    return buffer.data();
+}
+
+void Benchmarks::readMap_data()
+{
+    addLayerDataFormatRows();
+}
+
+void Benchmarks::readMap()
+{
+    QFETCH(Map::LayerDataFormat, format);
+
+    if (!isSupported(format))
+        QSKIP("Layer data format not supported");
+
+    mMap->setLayerDataFormat(format);
+    QByteArray data = writeMapData(*mMap);
+
+    QBENCHMARK {
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+
+        MapReader reader;
+        auto map = reader.readMap(&buffer, mTemporaryDir.path());
+        QVERIFY2(map, qPrintable(reader.errorString()));
+
+        // Make sure any lazily decoded data is included
+        for (Layer *layer : map->layers())
+            if (TileLayer *tileLayer = layer->asTileLayer())
+                tileLayer->decodeAllChunks();
+    }
+}
+
+void Benchmarks::writeMap_data()
+{
+    addLayerDataFormatRows();
+}
+
+void Benchmarks::writeMap()
+{
+    QFETCH(Map::LayerDataFormat, format);
+
+    if (!isSupported(format))
+        QSKIP("Layer data format not supported");
+
+    mMap->setLayerDataFormat(format);
+
+    QBENCHMARK {
+        QByteArray data = writeMapData(*mMap);
+        QVERIFY(!data.isEmpty());
+    }
+}
+
+void Benchmarks::encodeLayerData_data()
+{
+    addLayerDataFormatRows();
+}
+
+void Benchmarks::encodeLayerData()
+{
+    QFETCH(Map::LayerDataFormat, format);
+
+    if (!isSupported(format))
+        QSKIP("Layer data format not supported");
+
+    if (format == Map::XML)
+        QSKIP("The XML format is not encoded by GidMapper");
+
+    const GidMapper gidMapper(mMap->tilesets());
+    const TileLayer &layer = *firstTileLayer(*mMap);
+
+    QBENCHMARK {
+        const QByteArray data = gidMapper.encodeLayerData(layer, format);
+        QVERIFY(!data.isEmpty());
+    }
+}
+
+void Benchmarks::decodeLayerData_data()
+{
+    addLayerDataFormatRows();
+}
+
+void Benchmarks::decodeLayerData()
+{
+    QFETCH(Map::LayerDataFormat, format);
+
+    if (!isSupported(format))
+        QSKIP("Layer data format not supported");
+
+    if (format == Map::XML)
+        QSKIP("The XML format is not decoded by GidMapper");
+
+    const GidMapper gidMapper(mMap->tilesets());
+    const TileLayer &layer = *firstTileLayer(*mMap);
+    const QByteArray data = gidMapper.encodeLayerData(layer, format);
+
+    QBENCHMARK {
+        TileLayer decoded(QString(), 0, 0, MapSize, MapSize);
+        const auto error = gidMapper.decodeLayerData(decoded, data, format, layer.rect());
+        QCOMPARE(error, GidMapper::NoError);
+    }
+}
+
+void Benchmarks::setCell()
+{
+    const Cell cell(mTileset->findTile(1));
+
+    QBENCHMARK {
+        TileLayer layer(QString(), 0, 0, MapSize, MapSize);
+        for (int y = 0; y < MapSize; ++y)
+            for (int x = 0; x < MapSize; ++x)
+                layer.setCell(x, y, cell);
+    }
+}
+
+void Benchmarks::cellAt()
+{
+    const TileLayer &layer = *firstTileLayer(*mMap);
+    int tiles = 0;
+
+    QBENCHMARK {
+        tiles = 0;
+        for (int y = 0; y < MapSize; ++y)
+            for (int x = 0; x < MapSize; ++x)
+                if (!layer.cellAt(x, y).isEmpty())
+                    ++tiles;
+    }
+
+    QCOMPARE(tiles, MapSize * MapSize);
+}
+
+void Benchmarks::region()
+{
+    const TileLayer &layer = *mMap->layerAt(1)->asTileLayer();
+
+    QBENCHMARK {
+        const QRegion region = layer.region();
+        QVERIFY(!region.isEmpty());
+    }
+}
+
+void Benchmarks::regionOf()
+{
+    const TileLayer &layer = *mMap->layerAt(1)->asTileLayer();
+    const Cell cell = layer.cellAt(0, 0);
+
+    QBENCHMARK {
+        const QRegion region = layer.regionOf(cell);
+        QVERIFY(!region.isEmpty());
+    }
+}
+
+void Benchmarks::clone()
+{
+    const TileLayer &layer = *firstTileLayer(*mMap);
+
+    QBENCHMARK {
+        std::unique_ptr<TileLayer> clone(layer.clone());
+        QVERIFY(clone);
+    }
+}
+
+void Benchmarks::computeDiffRegion()
+{
+    const TileLayer &layer = *firstTileLayer(*mMap);
+    std::unique_ptr<TileLayer> changed(layer.clone());
+    changed->setCell(MapSize / 2, MapSize / 2, Cell());
+
+    QBENCHMARK {
+        const QRegion diff = layer.computeDiffRegion(changed.get());
+        QCOMPARE(diff, QRegion(MapSize / 2, MapSize / 2, 1, 1));
+    }
+}
+
+void Benchmarks::drawTileLayer_data()
+{
+    QTest::addColumn<Map::Orientation>("orientation");
+
+    QTest::newRow("orthogonal") << Map::Orthogonal;
+    QTest::newRow("isometric") << Map::Isometric;
+    QTest::newRow("staggered") << Map::Staggered;
+    QTest::newRow("hexagonal") << Map::Hexagonal;
+}
+
+void Benchmarks::drawTileLayer()
+{
+    QFETCH(Map::Orientation, orientation);
+
+    const auto map = generateMap(mTileset, orientation);
+    const auto renderer = createRenderer(map.get());
+
+    QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+    const QRectF exposed(QPointF(), image.size());
+
+    QBENCHMARK {
+        image.fill(Qt::transparent);
+
+        QPainter painter(&image);
+        for (Layer *layer : map->layers())
+            renderer->drawTileLayer(&painter, layer->asTileLayer(), exposed);
+    }
+}
+
+void Benchmarks::floodFill_data()
+{
+    QTest::addColumn<Map::Orientation>("orientation");
+
+    QTest::newRow("orthogonal") << Map::Orthogonal;
+    QTest::newRow("staggered") << Map::Staggered;
+    QTest::newRow("hexagonal") << Map::Hexagonal;
+}
+
+void Benchmarks::floodFill()
+{
+    QFETCH(Map::Orientation, orientation);
+
+    // Fill the empty area around the clusters of a decoration layer
+    const TileLayer &layer = *mMap->layerAt(1)->asTileLayer();
+    const QRegion bounds(layer.rect());
+
+    QPoint origin;
+    while (!layer.cellAt(origin).isEmpty())
+        origin.rx()++;
+
+    QBENCHMARK {
+        const QRegion region = floodFillRegion(&layer, bounds, origin, orientation,
+                                               Map::StaggerY, Map::StaggerOdd);
+        QVERIFY(region.contains(origin));
+    }
+}
+
+void Benchmarks::wangFill()
+{
+    SharedTileset tileset = createTileset(mTemporaryDir.filePath(QStringLiteral("wangtiles.png")));
+
+    // A corner set with two colors, with one tile for each combination
+    WangSet *wangSet = new WangSet(tileset.data(), QStringLiteral("corners"), -1);
+    tileset->addWangSet(wangSet);
+    wangSet->setCornerColorCount(2);
+
+    for (int i = 0; i < 16; ++i) {
+        WangId wangId;
+        for (int corner = 0; corner < 4; ++corner)
+            wangId.setCornerColor(corner, ((i >> corner) & 1) + 1);
+        wangSet->addWangTile(WangTile(tileset->findTile(i), wangId));
+    }
+
+    const WangFiller filler(wangSet);
+    const TileLayer back(QString(), 0, 0, MapSize, MapSize);
+    const QRegion fillRegion(0, 0, 128, 128);
+
+    QBENCHMARK {
+        const auto filled = filler.fillRegion(back, fillRegion);
+        QVERIFY(!filled->cellAt(0, 0).isEmpty());
+    }
+}
+
+void Benchmarks::autoMapMatch()
+{
+    const TileLayer &setLayer = *firstTileLayer(*mMap);
+
+    // A 2x2 rule that requires the tiles found at a certain spot in the map
+    const QRegion ruleRegion(0, 0, 2, 2);
+    TileLayer inputLayer(QStringLiteral("input_Layer 0"), 0, 0, 2, 2);
+    inputLayer.setCells(0, 0, setLayer.copy(QRegion(100, 100, 2, 2)).get());
+
+    InputConditions conditions;
+    conditions.listYes.append(InputLayer { &inputLayer, false });
+
+    AutoMapper::Options options;
+    int matches = 0;
+
+    QBENCHMARK {
+        matches = 0;
+        for (int y = 0; y < MapSize - 1; ++y)
+            for (int x = 0; x < MapSize - 1; ++x)
+                if (layerMatchesConditions(setLayer, conditions, ruleRegion, QPoint(x, y), options))
+                    ++matches;
+    }
+
+    QVERIFY(matches > 0);
+}
+
+QTEST_MAIN(Benchmarks)
+#include "benchmarks.moc"
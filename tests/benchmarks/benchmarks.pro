@@ -0,0 +1,28 @@
+include(../../src/libtiled/libtiled.pri)
+
+QT += gui testlib
+CONFIG += c++14 console
+TEMPLATE = app
+
+macx {
+    LIBS += -L$$OUT_PWD/../../bin/Tiled.app/Contents/Frameworks
+} else {
+    LIBS += -L$$OUT_PWD/../../lib
+}
+
+!win32:!macx:!cygwin {
+    QMAKE_RPATHDIR += \$\$ORIGIN/../../lib
+
+    # It is not possible to use ORIGIN in QMAKE_RPATHDIR, so a bit manually
+    QMAKE_LFLAGS += -Wl,-z,origin \'-Wl,-rpath,$$join(QMAKE_RPATHDIR, ":")\'
+    QMAKE_RPATHDIR =
+}
+
+# The editing tools being benchmarked are part of the Tiled application
+INCLUDEPATH += ../../src/tiled
+
+# Input
+SOURCES += benchmarks.cpp \
+    ../../src/tiled/automappingconditions.cpp \
+    ../../src/tiled/floodfill.cpp \
+    ../../src/tiled/wangfiller.cpp
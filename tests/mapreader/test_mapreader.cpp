@@ -1,8 +1,11 @@
+#include "compression.h"
+#include "gidmapper.h"
 #include "map.h"
 #include "mapobject.h"
 #include "objectgroup.h"
 #include "tilelayer.h"
 #include "mapreader.h"
+#include "tileset.h"
 
 #include <QtTest/QtTest>
 
@@ -14,6 +17,9 @@ class test_MapReader : public QObject
 
 private slots:
     void loadMap();
+    void decodeLayerData_data();
+    void decodeLayerData();
+    void decodeCorruptLayerData();
 };
 
 void test_MapReader::loadMap()
@@ -53,5 +59,86 @@ void test_MapReader::loadMap()
     QCOMPARE(mapObject->height(), qreal(64));
 }
 
+void test_MapReader::decodeLayerData_data()
+{
+    QTest::addColumn<Map::LayerDataFormat>("format");
+
+    QTest::newRow("base64") << Map::Base64;
+    QTest::newRow("base64-gzip") << Map::Base64Gzip;
+    QTest::newRow("base64-zlib") << Map::Base64Zlib;
+    QTest::newRow("base64-zstd") << Map::Base64Zstandard;
+}
+
+void test_MapReader::decodeLayerData()
+{
+    QFETCH(Map::LayerDataFormat, format);
+
+    if (format == Map::Base64Zstandard && compress(QByteArray("data"), Zstandard).isEmpty())
+        QSKIP("Zstandard compression not supported");
+
+    SharedTileset tileset = Tileset::create(QLatin1String("tiles"), 32, 32);
+    GidMapper gidMapper;
+    gidMapper.insert(1, tileset);
+
+    // Large enough for the data to be decoded in several parts
+    TileLayer layer(QString(), 0, 0, 300, 200);
+    for (int y = 0; y < layer.height(); ++y) {
+        for (int x = 0; x < layer.width(); ++x) {
+            if ((x + y) % 5 == 0)
+                continue;
+
+            Cell cell(tileset.data(), (x * 7 + y * 13) % 1000);
+            cell.setFlippedHorizontally(x % 3 == 0);
+            layer.setCell(x, y, cell);
+        }
+    }
+
+    const QByteArray data = gidMapper.encodeLayerData(layer, format);
+    const QString text = QLatin1String("\n   ") + QString::fromLatin1(data) + QLatin1String("\n");
+
+    TileLayer fromData(QString(), 0, 0, layer.width(), layer.height());
+    TileLayer fromText(QString(), 0, 0, layer.width(), layer.height());
+
+    QCOMPARE(gidMapper.decodeLayerData(fromData, data, format, layer.rect()),
+             GidMapper::NoError);
+    QCOMPARE(gidMapper.decodeLayerData(fromText, QStringRef(&text), format, layer.rect()),
+             GidMapper::NoError);
+
+    for (int y = 0; y < layer.height(); ++y) {
+        for (int x = 0; x < layer.width(); ++x) {
+            QCOMPARE(fromData.cellAt(x, y), layer.cellAt(x, y));
+            QCOMPARE(fromText.cellAt(x, y), layer.cellAt(x, y));
+        }
+    }
+}
+
+void test_MapReader::decodeCorruptLayerData()
+{
+    SharedTileset tileset = Tileset::create(QLatin1String("tiles"), 32, 32);
+    GidMapper gidMapper;
+    gidMapper.insert(1, tileset);
+
+    TileLayer layer(QString(), 0, 0, 50, 50);
+    layer.setCell(3, 4, Cell(tileset.data(), 2));
+
+    const QByteArray data = gidMapper.encodeLayerData(layer, Map::Base64Zlib);
+    TileLayer decoded(QString(), 0, 0, 50, 50);
+
+    // Truncated data
+    QCOMPARE(gidMapper.decodeLayerData(decoded, data.left(data.size() / 2),
+                                       Map::Base64Zlib, layer.rect()),
+             GidMapper::CorruptLayerData);
+
+    // More data than fits the bounds
+    QCOMPARE(gidMapper.decodeLayerData(decoded, data, Map::Base64Zlib,
+                                       QRect(0, 0, 50, 49)),
+             GidMapper::CorruptLayerData);
+
+    // Invalid compressed data
+    QCOMPARE(gidMapper.decodeLayerData(decoded, QByteArray("AAAAAAAA"),
+                                       Map::Base64Zlib, layer.rect()),
+             GidMapper::CorruptLayerData);
+}
+
 QTEST_MAIN(test_MapReader)
 #include "test_mapreader.moc"